@@ -7,12 +7,16 @@
 #include <map>
 #include <memory>
 #include <stdexcept>
+#include <string>
 
 #include <docopt/docopt.h>
 #include "log/Logger.hpp"
 #include "net/Server.hpp"
 #include "regatron/Comm.hpp"
 #include "regatron/Handler.hpp"
+#include "regatron/SharedCommands.hpp"
+#include "regatron/SharedSnapshot.hpp"
+#include "regatron/Tcio.hpp"
 #include "utils/Instrumentator.hpp"
 
 constexpr const char *VERSION_STRING = "CONS - Regatron Interface v1.0.5";
@@ -21,8 +25,9 @@ constexpr const char *USAGE =
 Will start a TCP or an UNIX server and listen to commands.
 On Windows, as to be expected, only TCP servers are available.
 
-One client is supported at time. Tries to connect to the device defined by the pattern /dev/ttyUSBxx or COMx,
-where xx is an integer defined by the <regatron_port> argument.
+Multiple clients are served at the same time. Device readings are polled in the background and
+get commands are answered from the latest readings, "fresh <command>" reads from the device instead. Connects in the background to the device defined by the pattern /dev/ttyUSBxx or COMx,
+where xx is an integer defined by the <regatron_port> argument, device commands answer UNAVAILABLE until then.
 
 <endpoint> may be a port or a file, according to the socket type (tcp|unix).
 When using TCP connections, the incoming connection port will be 20000 + <regatron_port>.
@@ -30,9 +35,9 @@ When using TCP connections, the incoming connection port will be 20000 + <regatr
     Usage:
 )"
 #if __linux__
-    R"(      main (tcp|unix) <regatron_port>)"
+    R"(      main (tcp|unix) <regatron_port> [--threads=<n>] [--fast_period=<ms>] [--slow_period=<ms>] [--fast_readings] [--history_depth=<n>] [--shared_memory] [--shared_commands] [--connect_delay=<ms>] [--fast_connect] [--adaptive_timeout [--timeout_min=<n>] [--timeout_max=<n>]] [--identity_cache=<dir>] [--tcio_record=<file> | --tcio_replay=<file> [--replay_scale=<x>]])"
 #else
-    R"(      main <regatron_port> [--reconnect_interval=<sec>])"
+    R"(      main <regatron_port> [--reconnect_interval=<sec>] [--threads=<n>] [--fast_period=<ms>] [--slow_period=<ms>] [--fast_readings] [--history_depth=<n>] [--connect_delay=<ms>] [--fast_connect] [--adaptive_timeout [--timeout_min=<n>] [--timeout_max=<n>]] [--identity_cache=<dir>] [--tcio_record=<file> | --tcio_replay=<file> [--replay_scale=<x>]])"
 #endif
     R"(
       main (-h | --help)
@@ -41,14 +46,42 @@ When using TCP connections, the incoming connection port will be 20000 + <regatr
     Options:
       -h --help                   Show this screen.
       --version                   Show version.
-      --reconnect_interval=<sec>  Interval in seconds between reconnect attempts [default: 60].
+      --reconnect_interval=<sec>  Maximum interval in seconds between reconnect attempts [default: 60].
+      --threads=<n>               Number of threads serving network clients [default: 1].
+      --fast_period=<ms>          Acquisition period of actual values and state, 0 disables [default: 100].
+      --slow_period=<ms>          Acquisition period of temperatures, DC link and trees, 0 disables [default: 1000].
+      --fast_readings             Acquire module values from the raw measurement inputs, fewer serial transactions.
+      --history_depth=<n>         Readings kept per acquisition group for getHistory, 0 disables [default: 3000].
+      --shared_memory             Publish the acquired readings in the shared memory segment /dev/shm/REGxx, see regatron/SharedSnapshot.hpp.
+      --shared_commands           Accept system setpoints from the shared memory segment /dev/shm/REGxxCommands, see regatron/SharedCommands.hpp.
+      --connect_delay=<ms>        Wait between the TCIO initialization and a device search [default: 5000].
+      --fast_connect              Fast COM port detection, and probe the port of the last connection (RegatronCOMxxxPort.txt) before searching.
+      --adaptive_timeout          Fit the serial timeouts to the measured round trip time of the device calls.
+      --timeout_min=<n>           Lowest adaptive timeout multiplier, 1 to 5000 [default: 2].
+      --timeout_max=<n>           Highest adaptive timeout multiplier, 1 to 5000 [default: 100].
+      --identity_cache=<dir>      Keep the limits and versions of each unit in <dir>, read back after connecting.
+      --tcio_record=<file>        Record every TCIO call to a trace file.
+      --tcio_replay=<file>        Answer TCIO calls from a recorded trace file instead of the device.
+      --replay_scale=<x>          Replayed calls take their recorded duration times x, 0 answers at once [default: 1].
 
 )";
 
 struct Options {
-    bool isTcp;
-    int  regDevPort;
-    long reconnectInterval;
+    bool                        isTcp;
+    int                         regDevPort;
+    long                        reconnectInterval;
+    unsigned int                threads;
+    Regatron::AcquisitionConfig acquisition;
+    std::string                 sharedCommands;
+    std::chrono::milliseconds   connectDelay;
+    bool                        fastConnect;
+    bool                        adaptiveTimeout;
+    unsigned int                timeoutMin;
+    unsigned int                timeoutMax;
+    std::string                 identityCache;
+    std::string                 tcioRecord;
+    std::string                 tcioReplay;
+    double                      replayScale;
 };
 
 static Options ParseOpts(const int argc, const char *argv[]) {
@@ -63,9 +96,52 @@ static Options ParseOpts(const int argc, const char *argv[]) {
 #endif
     int regDevPort = static_cast<int>(args.at("<regatron_port>").asLong());
     auto reconnectInterval = args.at("--reconnect_interval").asLong();
+    auto threads = static_cast<unsigned int>(args.at("--threads").asLong());
+    Regatron::AcquisitionConfig acquisition{
+        .fastPeriod =
+            std::chrono::milliseconds{args.at("--fast_period").asLong()},
+        .slowPeriod =
+            std::chrono::milliseconds{args.at("--slow_period").asLong()},
+        .fastReadings = args.at("--fast_readings").asBool(),
+        .historyDepth =
+            static_cast<std::size_t>(args.at("--history_depth").asLong())};
+#if __linux__
+    if (args.at("--shared_memory").asBool()) {
+        acquisition.sharedSnapshot = Regatron::Shared::SegmentName(regDevPort);
+    }
+#endif
+    std::string sharedCommands;
+#if __linux__
+    if (args.at("--shared_commands").asBool()) {
+        sharedCommands = Regatron::Shared::CommandSegmentName(regDevPort);
+    }
+#endif
+    const std::chrono::milliseconds connectDelay{
+        args.at("--connect_delay").asLong()};
+    const auto &identity = args.at("--identity_cache");
+    const auto &record   = args.at("--tcio_record");
+    const auto &replay   = args.at("--tcio_replay");
+    std::string identityCache = identity ? identity.asString() : std::string{};
+    std::string tcioRecord = record ? record.asString() : std::string{};
+    std::string tcioReplay = replay ? replay.asString() : std::string{};
+    double      replayScale = std::stod(args.at("--replay_scale").asString());
     return {.isTcp             = tcp,
             .regDevPort        = regDevPort,
-            .reconnectInterval = reconnectInterval};
+            .reconnectInterval = reconnectInterval,
+            .threads           = threads,
+            .acquisition       = acquisition,
+            .sharedCommands    = sharedCommands,
+            .connectDelay      = connectDelay,
+            .fastConnect       = args.at("--fast_connect").asBool(),
+            .adaptiveTimeout   = args.at("--adaptive_timeout").asBool(),
+            .timeoutMin =
+                static_cast<unsigned int>(args.at("--timeout_min").asLong()),
+            .timeoutMax =
+                static_cast<unsigned int>(args.at("--timeout_max").asLong()),
+            .identityCache     = identityCache,
+            .tcioRecord        = tcioRecord,
+            .tcioReplay        = tcioReplay,
+            .replayScale       = replayScale};
 }
 
 int main(const int argc, const char *argv[]) {
@@ -75,56 +151,62 @@ int main(const int argc, const char *argv[]) {
         spdlog::level::level_enum::trace,
         fmt::format("RegatronCOM{:03}Log.txt", options.regDevPort).c_str());
 
-    static std::shared_ptr<Regatron::Comm> regatron =
-        std::make_shared<Regatron::Comm>(options.regDevPort);
-
-    static std::shared_ptr<Regatron::Handler> handler =
-        std::make_shared<Regatron::Handler>(regatron);
+    if (!options.tcioRecord.empty()) {
+        Regatron::Tcio::StartRecording(options.tcioRecord);
+    } else if (!options.tcioReplay.empty()) {
+        Regatron::Tcio::StartReplay(options.tcioReplay, options.replayScale);
+    }
 
-    static std::shared_ptr<Net::Server> server = nullptr;
+    auto regatron = std::make_shared<Regatron::Comm>(options.regDevPort);
 
     regatron->SetAutoReconnectInterval(
         std::chrono::seconds{options.reconnectInterval});
+    regatron->SetConnectDelay(options.connectDelay);
+    if (options.fastConnect) {
+        regatron->SetFastConnect(
+            true,
+            fmt::format("RegatronCOM{:03}Port.txt", options.regDevPort));
+    }
+    if (options.adaptiveTimeout) {
+        regatron->SetAdaptiveTimeouts(options.timeoutMin, options.timeoutMax);
+    }
+    if (!options.identityCache.empty()) {
+        regatron->SetIdentityCache(options.identityCache);
+    }
 
     LOG_INFO(R"(Regatron reconnect interval at "{} seconds")",
              regatron->GetAutoReconnectInterval().count());
 
-    auto sighandler = +[](int signum) -> void {
-        /**
-         * @fixme:
-         * The shutdown function is being called twice.
-         * Once by this and once at a try{} block inside Server::listen().
-         * */
-        LOG_WARN(R"(Capture signal "{}", gracefully shutting down...)", signum);
-        if (server != nullptr) {
-            regatron->setAutoReconnect(false);
-            regatron->disconnect();
-
-            server->stop();
-            server->shutdown();
-        }
-
-        INSTRUMENTATOR_PROFILE_END_SESSION();
-        exit(SIGINT);
-    };
-    signal(SIGINT, sighandler);
+    // Connects in the background from here on
+    auto handler = std::make_shared<Regatron::Handler>(
+        regatron, options.acquisition, options.sharedCommands);
+
+    std::shared_ptr<Net::Server> server = nullptr;
 
 #if __linux__
     if (!options.isTcp) {
         const std::string unixEndpoint =
             fmt::format("/var/tmp/REG{:02}", options.regDevPort);
         LOG_INFO("Using unix endpoint at {}", unixEndpoint);
-        server = std::make_shared<Net::Server>(handler, unixEndpoint.c_str());
+        server = std::make_shared<Net::Server>(handler, unixEndpoint.c_str(),
+                                               options.threads);
     }
 #endif
 
     if (options.isTcp) {
         int tcpServerPort = 20000 + options.regDevPort;
-        server = std::make_shared<Net::Server>(handler, tcpServerPort);
+        server = std::make_shared<Net::Server>(
+            handler, static_cast<unsigned short>(tcpServerPort),
+            options.threads);
     }
+    server->stopOnSignals({SIGINT, SIGTERM});
     INSTRUMENTATOR_PROFILE_BEGIN_SESSION(
         "Listen", "cons_regatron_interface_results.json");
     server->listen();
     INSTRUMENTATOR_PROFILE_END_SESSION();
-    return 0;
+
+    // Every thread using the device stops before the last TCIO call
+    handler->shutdown();
+    Regatron::Tcio::Stop();
+    return server->stopSignal();
 }
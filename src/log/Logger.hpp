@@ -2,6 +2,7 @@
 
 #include "spdlog/spdlog.h"
 #include <memory>
+#include <mutex>
 
 /**
  * Always call Utils::Logger::Init()
@@ -14,9 +15,13 @@ class Logger {
   public:
     static void Init(spdlog::level::level_enum level = spdlog::level::trace, const char* logFileName = "ConsRegIface.txt");
     inline static std::shared_ptr<spdlog::logger> &getLogger() {
-        if (!defaultLogger) {
-            Init();
-        }
+        // The first log may come from several threads at once
+        static std::once_flag initialized;
+        std::call_once(initialized, [] {
+            if (!defaultLogger) {
+                Init();
+            }
+        });
         return defaultLogger;
     }
 };
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include <fmt/format.h>
+
+namespace Net {
+/**
+ * Length prefixed binary frames, an opt-in alternative to the new line
+ * delimited text messages on the same connection.
+ * A session switches to frames when the first byte it receives is
+ * BINARY_MAGIC, or on a "proto binary\n" text message answered
+ * "proto ACK\n": every byte after the magic or the new line is framed.
+ * A frame is the payload size as a little endian uint32, then the payload.
+ * */
+constexpr unsigned char    BINARY_MAGIC = 0xB1; /** never the start of text */
+constexpr std::string_view PROTO        = "proto";
+constexpr std::string_view PROTO_BINARY = "proto binary";
+constexpr std::size_t      FRAME_HEADER = 4;
+
+/**
+ * @return: payload size of the frame at the start of buffer, nullopt while
+ * the header is not complete
+ * */
+inline std::optional<std::size_t> FramePayloadSize(std::string_view buffer) {
+    if (buffer.size() < FRAME_HEADER) {
+        return {};
+    }
+    std::uint32_t size = 0;
+    for (std::size_t i = 0; i < FRAME_HEADER; i++) {
+        const auto byte = static_cast<unsigned char>(buffer[i]);
+        size |= static_cast<std::uint32_t>(byte) << (8 * i);
+    }
+    return size;
+}
+
+/** @return: mark for EndFrame, the payload is appended after it */
+inline std::size_t BeginFrame(fmt::memory_buffer &out) {
+    const auto mark = out.size();
+    out.resize(mark + FRAME_HEADER);
+    return mark;
+}
+
+/** Writes the size of the payload appended since BeginFrame */
+inline void EndFrame(fmt::memory_buffer &out, std::size_t mark) {
+    const auto size =
+        static_cast<std::uint32_t>(out.size() - mark - FRAME_HEADER);
+    for (std::size_t i = 0; i < FRAME_HEADER; i++) {
+        out[mark + i] = static_cast<char>((size >> (8 * i)) & 0xFFU);
+    }
+}
+} // namespace Net
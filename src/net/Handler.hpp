@@ -1,12 +1,45 @@
 #pragma once
 
 #include <asio.hpp> // NO LINT
+#include <fmt/format.h>
+#include <memory>
+#include <string_view>
+
+#include "net/Outbox.hpp"
 
 namespace Net {
+/** Response buffer, owned by the session and reused between requests. */
+using Response = fmt::memory_buffer;
+
 class Handler {
   public:
-    virtual std::string handle(const std::string &message) = 0;
-    virtual ~Handler()                                     = default;
+    /**
+     * May be called concurrently by sessions running on different threads.
+     * @param message: one complete message, including the trailing new line.
+     * @param response: the response is appended to it.
+     * */
+    virtual void handle(std::string_view message, Response &response) = 0;
+    /**
+     * Same, for a session that takes updates pushed later on through its
+     * outbox. Defaults to handle().
+     * */
+    virtual void handleSession(std::string_view message, Response &response,
+                               const std::shared_ptr<Outbox> & /*outbox*/) {
+        handle(message, response);
+    }
+    /** @return: true when the handler takes binary frames, see Net::Frame */
+    [[nodiscard]] virtual bool acceptsFrames() const { return false; }
+    /**
+     * May be called concurrently, like handle().
+     * @param payload: one complete frame, without the size header.
+     * @param response: payload of the response frame is appended to it.
+     * @return: false when the frame is malformed, the session is closed.
+     * */
+    virtual bool handleFrame(std::string_view /*payload*/,
+                             Response & /*response*/) {
+        return false;
+    }
+    virtual ~Handler() = default;
 
   protected:
     Handler()                = default;
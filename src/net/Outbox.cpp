@@ -0,0 +1,73 @@
+#include "Outbox.hpp"
+
+#include <algorithm>
+
+namespace Net {
+
+bool Outbox::push(uint64_t key, std::string_view update) {
+    bool wasEmpty = false;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        const auto end   = m_Pending.begin() + static_cast<long>(m_Count);
+        auto       found = std::find_if(m_Pending.begin(), end,
+                                  [key](const Pending &pending) {
+                                      return pending.key == key;
+                                  });
+        if (found != end) {
+            found->update.assign(update);
+            m_Merged++;
+            return true;
+        }
+        if (m_Count == MAX_PENDING) {
+            m_Dropped++;
+            return false;
+        }
+        if (m_Count == m_Pending.size()) {
+            m_Pending.emplace_back();
+        }
+        auto &pending = m_Pending[m_Count++];
+        pending.key   = key;
+        pending.update.assign(update);
+        wasEmpty = m_Count == 1 && m_Replies.empty();
+    }
+    // Outside the lock, the session may take() at once
+    if (wasEmpty && m_Notify) {
+        m_Notify();
+    }
+    return true;
+}
+
+void Outbox::reply(std::string_view reply) {
+    bool wasEmpty = false;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        wasEmpty = m_Count == 0 && m_Replies.empty();
+        m_Replies.append(reply);
+    }
+    if (wasEmpty && m_Notify) {
+        m_Notify();
+    }
+}
+
+void Outbox::take(fmt::memory_buffer &out) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    out.append(m_Replies.data(), m_Replies.data() + m_Replies.size());
+    m_Replies.clear();
+    for (std::size_t i = 0; i < m_Count; i++) {
+        const auto &update = m_Pending[i].update;
+        out.append(update.data(), update.data() + update.size());
+    }
+    m_Count = 0;
+}
+
+uint64_t Outbox::merged() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Merged;
+}
+
+uint64_t Outbox::dropped() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Dropped;
+}
+
+} // namespace Net
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+
+namespace Net {
+/**
+ * Updates pushed to a session outside of the request -> response chain.
+ * A slow client never blocks the producer: an update replaces the pending
+ * one of the same key, last value wins, and updates beyond MAX_PENDING keys
+ * are dropped.
+ * Replies to tagged requests completed out of order go out the same way,
+ * in completion order, but are never merged nor dropped.
+ * Thread safe.
+ * */
+class Outbox {
+  public:
+    static constexpr std::size_t MAX_PENDING = 64;
+    /** Called by push() when the outbox is no longer empty */
+    using Notify = std::function<void()>;
+
+    explicit Outbox(Notify notify) : m_Notify(std::move(notify)) {}
+
+    /**
+     * @param update: complete message, including the trailing new line
+     * @return: false when dropped
+     * */
+    bool push(uint64_t key, std::string_view update);
+    /**
+     * @param reply: complete reply, including the trailing new line. The
+     * handler bounds the requests in flight.
+     * */
+    void reply(std::string_view reply);
+    /** Appends the pending replies, then the updates, oldest key first */
+    void take(fmt::memory_buffer &out);
+
+    /** Updates replaced by a newer one of the same key */
+    [[nodiscard]] uint64_t merged() const;
+    [[nodiscard]] uint64_t dropped() const;
+
+  private:
+    struct Pending {
+        uint64_t    key = 0;
+        std::string update; /** reused, keeps capacity */
+    };
+
+    Notify               m_Notify;
+    mutable std::mutex   m_Mutex;
+    std::vector<Pending> m_Pending;
+    std::string          m_Replies; /** reused, keeps capacity */
+    std::size_t          m_Count   = 0; /** m_Pending entries in use */
+    uint64_t             m_Merged  = 0;
+    uint64_t             m_Dropped = 0;
+};
+} // namespace Net
@@ -1,16 +1,18 @@
 #include "Server.hpp"
 
+#include <thread>
+#include <vector>
+
 namespace Net {
 
 #if __linux__
-    Server::Server(std::shared_ptr<Net::Handler> handler, const char *unixEndpoint)
+Server::Server(std::shared_ptr<Net::Handler> handler, const char *unixEndpoint,
+               unsigned int threads)
     : m_handler(std::move(handler)),
       m_IOContext(std::make_shared<asio::io_context>()),
-      m_Socket(std::make_shared<asio::generic::stream_protocol::socket>(
-          *m_IOContext)),
-
-      m_UNIXAcceptor(nullptr),
-    m_TCPAcceptor(nullptr), m_Run{false} {
+      m_UNIXAcceptor(nullptr), m_UNIXEndpoint(unixEndpoint),
+      m_TCPAcceptor(nullptr), m_Threads(std::max(threads, 1U)),
+      m_SessionId{0} {
     if (std::filesystem::exists(unixEndpoint)) {
         LOG_WARN("File {} already exists... Trying to delete it ...",
                  unixEndpoint);
@@ -23,17 +25,15 @@ namespace Net {
 #endif
 
 Server::Server(std::shared_ptr<Net::Handler> handler,
-               const short unsigned int      tcpPort)
+               const short unsigned int tcpPort, unsigned int threads)
     : m_handler(std::move(handler)),
       m_IOContext(std::make_shared<asio::io_context>()),
-      m_Socket(std::make_shared<asio::generic::stream_protocol::socket>(
-          *m_IOContext)),
 #if __linux__
-    m_UNIXAcceptor(nullptr),
+      m_UNIXAcceptor(nullptr),
 #endif
       m_TCPAcceptor(std::make_shared<asio::ip::tcp::acceptor>(
           *m_IOContext, asio::ip::tcp::endpoint{asio::ip::tcp::v4(), tcpPort})),
-      m_Run{false} {
+      m_Threads(std::max(threads, 1U)), m_SessionId{0} {
 
     LOG_INFO(R"(Server Socket: TCP Server at port "{}")", tcpPort);
 }
@@ -44,86 +44,141 @@ Server::~Server() {
 #if __linux__
     // Delete UNIX endpoint
     if (m_UNIXAcceptor != nullptr) {
-        try {
-            std::error_code   stde;
-            const std::string endpoint =
-                m_UNIXAcceptor->local_endpoint().path();
-            LOG_INFO("Removing UNIX socket endpoint \"{}\"", endpoint);
-            std::filesystem::remove(endpoint, stde);
-
-        } catch (std::error_code &e) {
-            LOG_ERROR("Failed to remove UNIX endpoint");
+        std::error_code ec;
+        LOG_INFO("Removing UNIX socket endpoint \"{}\"", m_UNIXEndpoint);
+        if (!std::filesystem::remove(m_UNIXEndpoint, ec) && ec) {
+            LOG_ERROR(R"(Failed to remove UNIX endpoint "{}". "{}".)",
+                      m_UNIXEndpoint, ec.message());
         }
     }
 #endif
 }
 
-void Server::stop(){
-    m_Run = false;
+void Server::stop() { m_IOContext->stop(); }
+
+void Server::stopOnSignals(std::initializer_list<int> signals) {
+    m_Signals = std::make_unique<asio::signal_set>(*m_IOContext);
+    for (const auto signal : signals) {
+        m_Signals->add(signal);
+    }
+    m_Signals->async_wait([this](const std::error_code &ec, int signal) {
+        if (ec) {
+            return;
+        }
+        LOG_WARN(R"(Capture signal "{}", gracefully shutting down...)",
+                 signal);
+        m_StopSignal = signal;
+        shutdown();
+        stop();
+    });
 }
 
 void Server::shutdown() {
-    // Shutdown socket connections /** if m_Run is true, the socket will start again... @todo: Fix names !*/
     std::error_code ec;
-    m_Socket->shutdown(asio::socket_base::shutdown_send, ec);
-    if (ec) {
-        LOG_DEBUG("Failed to shutdown socket. Error {}.", ec.message());
-    } else {
-        LOG_INFO("Socket shutdown.");
+    if (m_TCPAcceptor != nullptr) {
+        m_TCPAcceptor->close(ec);
+    }
+#if __linux__
+    if (m_UNIXAcceptor != nullptr) {
+        m_UNIXAcceptor->close(ec);
     }
-    m_Socket->close(ec);
+#endif
     if (ec) {
-        LOG_DEBUG(R"(Failed to close socket. "{}".)", ec.message());
-    } else {
-        LOG_INFO("Socket closed.");
+        LOG_DEBUG(R"(Failed to close acceptor. "{}".)", ec.message());
     }
-}
 
-auto Server::read() {
-    asio::streambuf buf;
-    asio::read_until(*m_Socket, buf, "\n");
-    return std::string{asio::buffer_cast<const char *>(buf.data())};
-}
-auto Server::read(std::error_code &ec) {
-    asio::streambuf buf;
-    asio::read_until(*m_Socket, buf, "\n", ec);
-    return std::string{asio::buffer_cast<const char *>(buf.data())};
+    std::unordered_set<std::shared_ptr<Session>> sessions;
+    {
+        std::lock_guard<std::mutex> lock(m_SessionsMutex);
+        sessions = m_Sessions;
+    }
+    for (const auto &session : sessions) {
+        session->close();
+    }
+    LOG_INFO(R"(Server shutdown, "{}" sessions closed.)", sessions.size());
 }
 
-void Server::write(const std::string &message) {
-    asio::write(*m_Socket, asio::buffer(message));
+std::size_t Server::sessionCount() {
+    std::lock_guard<std::mutex> lock(m_SessionsMutex);
+    return m_Sessions.size();
 }
-void Server::write(const std::string &message, std::error_code &ec) {
-    asio::write(*m_Socket, asio::buffer(message), ec);
+
+void Server::removeSession(const std::shared_ptr<Session> &session) {
+    std::lock_guard<std::mutex> lock(m_SessionsMutex);
+    m_Sessions.erase(session);
 }
 
-void Server::listen() {
-    m_Run = true;
+void Server::accept() {
+    // Each client gets its own strand, handlers of a session never run
+    // concurrently even when the io_context is run by a thread pool.
+    auto socket =
+        std::make_shared<Session::Socket>(asio::make_strand(*m_IOContext));
+    auto onAccept = [this, socket](const std::error_code &ec) {
+        this->onAccept(ec, std::move(*socket));
+    };
 
-    while (m_Run) {
-        if (m_TCPAcceptor != nullptr) {
-            LOG_INFO("Waiting for client via TCP socket");
-            m_TCPAcceptor->accept(*m_Socket);
+    if (m_TCPAcceptor != nullptr) {
+        m_TCPAcceptor->async_accept(*socket, onAccept);
 #if __linux__
-        } else if (m_UNIXAcceptor != nullptr) {
-            LOG_INFO("Waiting for client via UNIX socket");
-            m_UNIXAcceptor->accept(*m_Socket);
+    } else if (m_UNIXAcceptor != nullptr) {
+        m_UNIXAcceptor->async_accept(*socket, onAccept);
 #endif
-        } else {
-            throw std::runtime_error("No acceptor available!");
+    } else {
+        throw std::runtime_error("No acceptor available!");
+    }
+}
+
+void Server::onAccept(const std::error_code &ec, Session::Socket socket) {
+    if (ec) {
+        if (ec == asio::error::operation_aborted) {
+            LOG_INFO("Server Socket: acceptor closed.");
+            return;
         }
+        LOG_ERROR(R"(Server Socket: Failed to accept client. "{}".)",
+                  ec.message());
+        accept();
+        return;
+    }
+
+    auto session = std::make_shared<Session>(
+        std::move(socket), m_handler, ++m_SessionId,
+        [this](const std::shared_ptr<Session> &s) { removeSession(s); });
+    {
+        std::lock_guard<std::mutex> lock(m_SessionsMutex);
+        m_Sessions.insert(session);
+        LOG_INFO(R"(Server Socket: "{}" clients connected.)",
+                 m_Sessions.size());
+    }
+    session->start();
+    accept();
+}
 
-        try {
-            LOG_INFO("Server Socket: Client connected.");
+void Server::listen() {
+    m_IOContext->restart();
+    accept();
 
-            while (m_Run) {
-                const std::string message = Server::read();
-                this->write(this->m_handler->handle(message));
+    auto run = [this]() {
+        while (true) {
+            try {
+                m_IOContext->run();
+                return;
+            } catch (const std::exception &e) {
+                LOG_CRITICAL(R"(Server Socket: Unhandled exception "{}".)",
+                             e.what());
             }
-        } catch (const std::system_error &e) {
-            LOG_CRITICAL(R"(Server Socket: Connection closed. "{}".)", e.what());
-            shutdown();
         }
+    };
+
+    LOG_INFO(R"(Server Socket: Waiting for clients using "{}" threads.)",
+             m_Threads);
+    std::vector<std::thread> pool;
+    pool.reserve(m_Threads - 1);
+    for (unsigned int i = 1; i < m_Threads; i++) {
+        pool.emplace_back(run);
+    }
+    run();
+    for (auto &thread : pool) {
+        thread.join();
     }
 }
 } // namespace Net
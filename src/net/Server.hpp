@@ -2,41 +2,72 @@
 
 #include "log/Logger.hpp"
 #include "net/Handler.hpp"
+#include "net/Session.hpp"
 
 #include <asio.hpp> // NOLINT
+#include <atomic>
 #include <filesystem>
+#include <initializer_list>
+#include <mutex>
+#include <string>
 #include <system_error>
+#include <unordered_set>
 
 namespace Net {
 class Server {
   public:
     Server() = delete;
-    Server &operator=(const Server &) = default;
-    Server &operator=(Server &&) = default;
+    Server(const Server &) = delete;
+    Server(Server &&)      = delete;
+    Server &operator=(const Server &) = delete;
+    Server &operator=(Server &&) = delete;
     ~Server();
 
+    /**
+     * @param threads: Number of threads running the io_context, sessions are
+     * handled concurrently when greater than one.
+     * */
     Server(std::shared_ptr<Net::Handler> handler,
-           const short unsigned int      tcpPort);
+           const short unsigned int tcpPort, unsigned int threads = 1);
 #if __linux__
-    Server(std::shared_ptr<Net::Handler> handler, const char *unixEndpoint);
+    Server(std::shared_ptr<Net::Handler> handler, const char *unixEndpoint,
+           unsigned int threads = 1);
 #endif
+    /** Accept clients and serve them until stop() is called. Blocking. */
     void listen();
+    /** Close the acceptor and every connected session. */
     void shutdown();
+    /** Stop the io_context, listen() returns. */
     void stop();
+    /**
+     * shutdown() and stop() on the first of the signals, handled on the
+     * io_context instead of in a signal handler.
+     * */
+    void stopOnSignals(std::initializer_list<int> signals);
+    /** @return: signal that stopped the server, 0 when none */
+    [[nodiscard]] int stopSignal() const { return m_StopSignal; }
 
+    [[nodiscard]] std::size_t sessionCount();
 
   private:
-    std::shared_ptr<Net::Handler>                                  m_handler;
-    std::shared_ptr<asio::io_context>                              m_IOContext;
-    std::shared_ptr<asio::generic::stream_protocol::socket>        m_Socket;
+    std::shared_ptr<Net::Handler>     m_handler;
+    std::shared_ptr<asio::io_context> m_IOContext;
 #if __linux__
     std::shared_ptr<asio::local::stream_protocol::acceptor> m_UNIXAcceptor;
+    /** Kept, the acceptor is closed by shutdown() before it is removed */
+    std::string m_UNIXEndpoint;
 #endif
-    std::shared_ptr<asio::ip::tcp::acceptor>                m_TCPAcceptor;
-    void              write(const std::string &message, std::error_code &ec);
-    void write(const std::string &message);
-    auto              read(std::error_code &ec);
-    auto              read();
-    bool              m_Run;
+    std::shared_ptr<asio::ip::tcp::acceptor> m_TCPAcceptor;
+    unsigned int                             m_Threads;
+    unsigned int                             m_SessionId;
+    std::unique_ptr<asio::signal_set>        m_Signals;
+    std::atomic<int>                         m_StopSignal{0};
+
+    std::mutex                                   m_SessionsMutex;
+    std::unordered_set<std::shared_ptr<Session>> m_Sessions;
+
+    void accept();
+    void onAccept(const std::error_code &ec, Session::Socket socket);
+    void removeSession(const std::shared_ptr<Session> &session);
 };
 } // namespace Net
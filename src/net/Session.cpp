@@ -0,0 +1,207 @@
+#include "Session.hpp"
+
+namespace Net {
+
+Session::Session(Socket socket, std::shared_ptr<Net::Handler> handler,
+                 unsigned int id, CloseHandler onClose)
+    : m_Socket(std::move(socket)), m_Handler(std::move(handler)), m_Id(id),
+      m_OnClose(std::move(onClose)), m_Closed{false}, m_Writing{false},
+      m_ResponsePending{false}, m_Started{false}, m_Binary{false} {}
+
+Session::~Session() { LOG_TRACE(R"(Session "{}": destroyed.)", m_Id); }
+
+void Session::start() {
+    LOG_INFO(R"(Session "{}": client connected.)", m_Id);
+    // Pushed from any thread, written from the session executor
+    m_Outbox = std::make_shared<Net::Outbox>([weak = weak_from_this()]() {
+        if (auto self = weak.lock()) {
+            asio::post(self->m_Socket.get_executor(),
+                       [self]() { self->flush(); });
+        }
+    });
+    doRead();
+}
+
+void Session::close() {
+    asio::post(m_Socket.get_executor(),
+               [self = shared_from_this()]() { self->closeSocket(); });
+}
+
+void Session::closeSocket() {
+    if (m_Closed) {
+        return;
+    }
+    m_Closed = true;
+
+    std::error_code ec;
+    m_Socket.shutdown(asio::socket_base::shutdown_both, ec);
+    if (ec) {
+        LOG_DEBUG(R"(Session "{}": failed to shutdown socket. "{}".)", m_Id,
+                  ec.message());
+    }
+    m_Socket.close(ec);
+    if (ec) {
+        LOG_DEBUG(R"(Session "{}": failed to close socket. "{}".)", m_Id,
+                  ec.message());
+    }
+    LOG_INFO(R"(Session "{}": connection closed.)", m_Id);
+
+    if (m_OnClose) {
+        m_OnClose(shared_from_this());
+    }
+}
+
+void Session::onError(const std::error_code &ec, const char *operation) {
+    if (ec == asio::error::eof) {
+        LOG_INFO(R"(Session "{}": client disconnected.)", m_Id);
+    } else if (ec != asio::error::operation_aborted) {
+        LOG_ERROR(R"(Session "{}": {} failed. "{}".)", m_Id, operation,
+                  ec.message());
+    }
+    closeSocket();
+}
+
+void Session::doRead() {
+    const auto onRead = [self = shared_from_this()](const std::error_code &ec,
+                                                    std::size_t /*length*/) {
+        if (ec == asio::error::not_found) {
+            LOG_ERROR(R"(Session "{}": no message delimiter in "{}" bytes.)",
+                      self->m_Id, self->m_ReadBuffer.size());
+        }
+        if (ec) {
+            self->onError(ec, "read");
+            return;
+        }
+        self->handleMessages();
+    };
+    auto buffer = asio::dynamic_buffer(m_ReadBuffer, MAX_READ_BUFFER_SIZE);
+    if (m_Binary || !m_Started) {
+        // The first byte may be the magic, a partial frame stays in the
+        // buffer and any new byte may complete it
+        asio::async_read(m_Socket, buffer, asio::transfer_at_least(1), onRead);
+    } else {
+        asio::async_read_until(m_Socket, buffer, '\n', onRead);
+    }
+}
+
+void Session::handleMessages() {
+    m_Response.clear();
+
+    std::string_view buffer{m_ReadBuffer};
+    if (!m_Started) {
+        m_Started = true;
+        if (static_cast<unsigned char>(buffer.front()) == BINARY_MAGIC &&
+            m_Handler->acceptsFrames()) {
+            LOG_INFO(R"(Session "{}": binary frames.)", m_Id);
+            m_Binary = true;
+            buffer.remove_prefix(1);
+        }
+    }
+
+    // The read may have received several messages, handle every complete one
+    // and keep the trailing partial message for the next read.
+    if (!m_Binary) {
+        buffer.remove_prefix(handleText(buffer));
+    }
+    if (m_Binary) {
+        const auto handled = handleFrames(buffer);
+        if (!handled) {
+            LOG_ERROR(R"(Session "{}": malformed frame.)", m_Id);
+            closeSocket();
+            return;
+        }
+        buffer.remove_prefix(*handled);
+    }
+    m_ReadBuffer.erase(0, m_ReadBuffer.size() - buffer.size());
+
+    // Only part of a frame or of the first message so far, or replies that
+    // come later through the outbox
+    if (m_Response.size() == 0) {
+        doRead();
+        return;
+    }
+    m_ResponsePending = true;
+    flush();
+}
+
+std::size_t Session::handleText(std::string_view buffer) {
+    std::size_t begin = 0;
+    std::size_t end   = 0;
+    while ((end = buffer.find('\n', begin)) != std::string_view::npos) {
+        const auto message = buffer.substr(begin, end - begin + 1);
+        begin              = end + 1;
+        if (!message.starts_with(PROTO_BINARY) ||
+            message.find_first_not_of(" \t\r\n", PROTO_BINARY.size()) !=
+                std::string_view::npos) {
+            m_Handler->handleSession(message, m_Response, m_Outbox);
+            continue;
+        }
+
+        // Every byte after this message is framed
+        const bool accepted = m_Handler->acceptsFrames();
+        fmt::format_to(std::back_inserter(m_Response), "{} {}\n", PROTO,
+                       accepted ? "ACK" : "NACK");
+        if (accepted) {
+            LOG_INFO(R"(Session "{}": binary frames.)", m_Id);
+            m_Binary = true;
+            break;
+        }
+    }
+    return begin;
+}
+
+std::optional<std::size_t> Session::handleFrames(std::string_view buffer) {
+    std::size_t begin = 0;
+    while (const auto size = FramePayloadSize(buffer.substr(begin))) {
+        if (*size > MAX_READ_BUFFER_SIZE - FRAME_HEADER) {
+            return {};
+        }
+        if (buffer.size() - begin - FRAME_HEADER < *size) {
+            break;
+        }
+        const auto mark = BeginFrame(m_Response);
+        if (!m_Handler->handleFrame(
+                buffer.substr(begin + FRAME_HEADER, *size), m_Response)) {
+            return {};
+        }
+        EndFrame(m_Response, mark);
+        begin += FRAME_HEADER + *size;
+    }
+    return begin;
+}
+
+void Session::flush() {
+    if (m_Writing || m_Closed) {
+        return;
+    }
+    if (m_ResponsePending) {
+        m_ResponsePending = false;
+        doWrite(m_Response, true);
+        return;
+    }
+    m_Pushed.clear();
+    m_Outbox->take(m_Pushed);
+    if (m_Pushed.size() != 0) {
+        doWrite(m_Pushed, false);
+    }
+}
+
+void Session::doWrite(const Net::Response &buffer, bool response) {
+    m_Writing = true;
+    asio::async_write(m_Socket, asio::buffer(buffer.data(), buffer.size()),
+                      [self = shared_from_this(),
+                       response](const std::error_code &ec,
+                                 std::size_t /*length*/) {
+                          self->m_Writing = false;
+                          if (ec) {
+                              self->onError(ec, "write");
+                              return;
+                          }
+                          if (response) {
+                              self->doRead();
+                          }
+                          self->flush();
+                      });
+}
+
+} // namespace Net
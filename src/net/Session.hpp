@@ -0,0 +1,83 @@
+#pragma once
+
+#include "log/Logger.hpp"
+#include "net/Frame.hpp"
+#include "net/Handler.hpp"
+#include "net/Outbox.hpp"
+
+#include <asio.hpp> // NOLINT
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace Net {
+/**
+ * One connected client.
+ * Every session owns its socket and read buffer and runs its own
+ * read -> handle -> write chain on the server io_context, so an idle or slow
+ * client does not hold back the others.
+ * Requests may be pipelined, every complete line in the input buffer is
+ * handled in order and the responses are written back at once.
+ * Updates pushed to the session Outbox are written in between, never in the
+ * middle of a response; the next request is read once its response is out.
+ * A request answered later through the Outbox, see Outbox::reply, does not
+ * hold back the next one.
+ * A session may switch to binary frames once, see Net::Frame, when the
+ * handler accepts them.
+ * The socket is expected to be bound to a strand when the io_context is run
+ * by more than one thread.
+ * */
+class Session : public std::enable_shared_from_this<Session> {
+  public:
+    using Socket       = asio::generic::stream_protocol::socket;
+    using CloseHandler = std::function<void(const std::shared_ptr<Session> &)>;
+
+    /** Maximum number of buffered bytes without a complete message. */
+    static constexpr std::size_t MAX_READ_BUFFER_SIZE = 64 * 1024;
+
+    Session(Socket socket, std::shared_ptr<Net::Handler> handler,
+            unsigned int id, CloseHandler onClose);
+    Session(const Session &) = delete;
+    Session(Session &&)      = delete;
+    Session &operator=(const Session &) = delete;
+    Session &operator=(Session &&) = delete;
+    ~Session();
+
+    void start();
+
+    /** Thread safe, the socket is closed from the session executor. */
+    void close();
+
+    [[nodiscard]] unsigned int id() const { return m_Id; }
+
+  private:
+    void doRead();
+    /** Writes the pending response, else the pushed updates, one at a time */
+    void flush();
+    void doWrite(const Net::Response &buffer, bool response);
+    void handleMessages();
+    /** @return: bytes of the buffer handled */
+    std::size_t handleText(std::string_view buffer);
+    /** @return: bytes of the buffer handled, nullopt on a malformed frame */
+    std::optional<std::size_t> handleFrames(std::string_view buffer);
+    void onError(const std::error_code &ec, const char *operation);
+    void closeSocket();
+
+    Socket                        m_Socket;
+    std::shared_ptr<Net::Handler> m_Handler;
+    const unsigned int            m_Id;
+    CloseHandler                  m_OnClose;
+    std::string                   m_ReadBuffer; /** may hold partial data */
+    Net::Response                 m_Response;   /** reused, keeps capacity */
+    Net::Response                 m_Pushed;     /** taken from m_Outbox */
+    std::shared_ptr<Net::Outbox>  m_Outbox;
+    bool                          m_Closed;
+    bool                          m_Writing;
+    bool                          m_ResponsePending;
+    bool                          m_Started; /** any byte received */
+    bool                          m_Binary;  /** frames instead of lines */
+};
+} // namespace Net
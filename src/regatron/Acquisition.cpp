@@ -0,0 +1,260 @@
+#include "Acquisition.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+namespace Regatron {
+
+namespace {
+int64_t ToNanoseconds(Acquisition::Clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               time.time_since_epoch())
+        .count();
+}
+} // namespace
+
+Acquisition::Acquisition(std::shared_ptr<Comm> comm, TcioWorker &worker,
+                         AcquisitionConfig config)
+    : m_Comm(std::move(comm)), m_Worker(worker), m_Config(config),
+      m_History(config.historyDepth) {
+    if (!m_Config.sharedSnapshot.empty()) {
+        m_Shared =
+            std::make_unique<SharedSnapshotWriter>(m_Config.sharedSnapshot);
+    }
+}
+
+Acquisition::~Acquisition() { stop(); }
+
+void Acquisition::start() {
+    if (m_Thread.joinable() || (m_Config.fastPeriod.count() <= 0 &&
+                                m_Config.slowPeriod.count() <= 0)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_StopMutex);
+        m_Stop = false;
+    }
+    LOG_INFO(
+        R"(Acquisition: fast period "{} ms", slow period "{} ms", fast readings "{}".)",
+        m_Config.fastPeriod.count(), m_Config.slowPeriod.count(),
+        m_Config.fastReadings);
+    m_Thread = std::thread([this]() { run(); });
+}
+
+void Acquisition::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_StopMutex);
+        m_Stop = true;
+    }
+    m_StopCondition.notify_all();
+    if (m_Thread.joinable()) {
+        m_Thread.join();
+    }
+}
+
+void Acquisition::run() {
+    const bool fastEnabled = m_Config.fastPeriod.count() > 0;
+    const bool slowEnabled = m_Config.slowPeriod.count() > 0;
+    auto       nextFast    = Clock::now();
+    auto       nextSlow    = Clock::now();
+
+    std::unique_lock<std::mutex> lock(m_StopMutex);
+    while (!m_Stop) {
+        lock.unlock();
+        const auto now      = Clock::now();
+        const bool readFast = fastEnabled && now >= nextFast;
+        const bool readSlow = slowEnabled && now >= nextSlow;
+        acquire(readFast, readSlow);
+
+        // Missed periods are skipped instead of read back to back
+        if (readFast) {
+            nextFast = std::max(nextFast + m_Config.fastPeriod, now);
+        }
+        if (readSlow) {
+            nextSlow = std::max(nextSlow + m_Config.slowPeriod, now);
+        }
+        auto next = Clock::time_point::max();
+        if (fastEnabled) {
+            next = std::min(next, nextFast);
+        }
+        if (slowEnabled) {
+            next = std::min(next, nextSlow);
+        }
+
+        lock.lock();
+        m_StopCondition.wait_until(lock, next, [this]() { return m_Stop; });
+    }
+}
+
+void Acquisition::acquire(bool readFast, bool readSlow) {
+    if (!readFast && !readSlow) {
+        return;
+    }
+
+    bool published = false;
+    m_Worker.run(Priority::Monitor, TcioWorker::NO_DEADLINE,
+                 [this, readFast, readSlow, &published]() {
+                     published = read(readFast, readSlow);
+                 });
+    // Off the worker, listeners do not delay the device jobs
+    if (published && m_Listener) {
+        m_Listener(m_Snapshot.load());
+    }
+}
+
+bool Acquisition::acquires(Channel channel) const {
+    const auto period = static_cast<std::size_t>(channel) < FAST_CHANNELS
+                            ? m_Config.fastPeriod
+                            : m_Config.slowPeriod;
+    return period.count() > 0;
+}
+
+bool Acquisition::read(bool readFast, bool readSlow) {
+    const auto epoch = m_Epoch.load();
+    if (m_Next.epoch != epoch) {
+        m_Next       = Snapshot{};
+        m_Next.epoch = epoch;
+    }
+
+    // Reconnection is left to the Reconnector
+    if (m_Comm->getConnectionState() != ConnectionState::Ok) {
+        return false;
+    }
+    auto readings = m_Comm->getReadings();
+    if (!readings) {
+        return false;
+    }
+
+    try {
+        readings.value()->readGroups(m_Next, readFast, readSlow,
+                                     m_Config.fastReadings);
+        const auto time = ToNanoseconds(Clock::now());
+        if (readFast) {
+            m_Next.fastTime = time;
+        }
+        if (readSlow) {
+            m_Next.slowTime = time;
+        }
+        if (readSlow) {
+            detectTreeChange();
+        }
+        m_Snapshot.store(m_Next);
+        m_History.append(m_Next, readFast, readSlow);
+        if (m_Shared) {
+            m_Shared->publish(m_Next);
+        }
+        return true;
+
+    } catch (const CommException &e) {
+        LOG_CRITICAL(
+            R"(CommException: Regatron communication exception "{}" during acquisition. Device TCIO will be closed.)",
+            e.what());
+        invalidate();
+        m_Comm->ReadCommStatus();
+        m_Comm->disconnect();
+    }
+    return false;
+}
+
+void Acquisition::detectTreeChange() {
+    const bool sysChanged = !(m_Next.sysTree == m_SysTree);
+    const bool modChanged = !(m_Next.modTree == m_ModTree);
+    if (sysChanged || modChanged) {
+        m_SysTree = m_Next.sysTree;
+        m_ModTree = m_Next.modTree;
+        m_TreeGeneration++;
+
+        fmt::memory_buffer trees;
+        FormatCompactTree(trees, m_SysTree);
+        trees.push_back(' ');
+        FormatCompactTree(trees, m_ModTree);
+        LOG_WARN(R"(Acquisition: error tree generation "{}", sys "{}" mod "{}" changed: {})",
+                 m_TreeGeneration, sysChanged, modChanged,
+                 fmt::to_string(trees));
+    }
+    m_Next.treeGeneration = m_TreeGeneration;
+}
+
+bool Acquisition::isFresh(const Snapshot &snapshot, int64_t time,
+                          std::chrono::milliseconds period) const {
+    const auto current = age(snapshot, time);
+    return period.count() > 0 && current &&
+           current.value() < period * STALE_PERIODS;
+}
+
+std::optional<std::chrono::milliseconds>
+Acquisition::age(const Snapshot &snapshot, int64_t time) const {
+    if (time == 0 || snapshot.epoch != m_Epoch.load()) {
+        return {};
+    }
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::nanoseconds{ToNanoseconds(Clock::now()) - time});
+}
+
+bool Acquisition::isKept(int64_t time,
+                         std::chrono::milliseconds period) const {
+    return period.count() > 0 && time != 0 &&
+           m_Comm->getConnectionState() != ConnectionState::Ok;
+}
+
+std::optional<Snapshot> Acquisition::fast() const {
+    auto snapshot = m_Snapshot.load();
+    if (!isFresh(snapshot, snapshot.fastTime, m_Config.fastPeriod) &&
+        !isKept(snapshot.fastTime, m_Config.fastPeriod)) {
+        return {};
+    }
+    return snapshot;
+}
+
+std::optional<Snapshot> Acquisition::slow() const {
+    auto snapshot = m_Snapshot.load();
+    if (!isFresh(snapshot, snapshot.slowTime, m_Config.slowPeriod) &&
+        !isKept(snapshot.slowTime, m_Config.slowPeriod)) {
+        return {};
+    }
+    return snapshot;
+}
+
+std::optional<std::chrono::milliseconds> Acquisition::fastAge() const {
+    const auto snapshot = m_Snapshot.load();
+    return age(snapshot, snapshot.fastTime);
+}
+
+std::optional<std::chrono::milliseconds> Acquisition::slowAge() const {
+    const auto snapshot = m_Snapshot.load();
+    return age(snapshot, snapshot.slowTime);
+}
+
+bool Acquisition::formatHistory(fmt::memory_buffer &out, Channel channel,
+                                std::chrono::milliseconds window,
+                                std::size_t               decimation) const {
+    if (!m_History.enabled()) {
+        return false;
+    }
+    const auto now = Clock::now();
+    // The window may start before the clock epoch, everything is in it then
+    const auto since =
+        window < now.time_since_epoch() ? ToNanoseconds(now - window) : 0;
+    const auto points = m_History.query(channel, since, decimation);
+    FormatHistory(out, points, decimation > 1, ToNanoseconds(now));
+    return true;
+}
+
+bool Acquisition::formatTreesSince(fmt::memory_buffer &out,
+                                   uint64_t            generation) const {
+    const auto snapshot = slow();
+    if (!snapshot) {
+        return false;
+    }
+    if (snapshot->treeGeneration == generation) {
+        fmt::format_to(std::back_inserter(out), "unchanged");
+        return true;
+    }
+    fmt::format_to(std::back_inserter(out), "{} ", snapshot->treeGeneration);
+    FormatCompactTree(out, snapshot->sysTree);
+    out.push_back(' ');
+    FormatCompactTree(out, snapshot->modTree);
+    return true;
+}
+
+} // namespace Regatron
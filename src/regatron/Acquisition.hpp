@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "Comm.hpp"
+#include "History.hpp"
+#include "SharedSnapshotWriter.hpp"
+#include "Snapshot.hpp"
+#include "TcioWorker.hpp"
+#include "utils/SeqLock.hpp"
+
+namespace Regatron {
+
+/** A zero period disables the group, its commands are read from the device. */
+struct AcquisitionConfig {
+    std::chrono::milliseconds fastPeriod{0};
+    std::chrono::milliseconds slowPeriod{0};
+    bool        fastReadings{false}; /** see Readings::readGroups */
+    std::size_t historyDepth{0};     /** samples per group, see History */
+    /** Shared memory segment name, empty disables, see SharedSnapshotWriter */
+    std::string sharedSnapshot{};
+};
+
+/**
+ * Background thread polling the device at per-group rates and publishing the
+ * readings as a Snapshot, so get commands are answered without a serial
+ * transaction.
+ * A group is considered stale after STALE_PERIODS periods without a
+ * successful read, or after invalidate() is called.
+ * While the device is not connected the last readings are kept available,
+ * whatever their age, for the handler to serve marked as stale.
+ * Every read is also kept in the History, across connections, and
+ * published to the shared memory segment when one is configured.
+ * An error or warning bit flipping in either tree counts as a new tree
+ * generation, logged as a change event.
+ * */
+class Acquisition {
+  public:
+    using Clock = std::chrono::steady_clock;
+    /** Published snapshot, on the acquisition thread after every read */
+    using Listener = std::function<void(const Snapshot &)>;
+
+    static constexpr int STALE_PERIODS = 3;
+
+    /** @param worker: runs every device access, at Monitor priority */
+    Acquisition(std::shared_ptr<Comm> comm, TcioWorker &worker,
+                AcquisitionConfig config);
+    Acquisition(const Acquisition &) = delete;
+    Acquisition(Acquisition &&)      = delete;
+    Acquisition &operator=(const Acquisition &) = delete;
+    Acquisition &operator=(Acquisition &&) = delete;
+    ~Acquisition();
+
+    /** Before start() */
+    void setListener(Listener listener) { m_Listener = std::move(listener); }
+    void start();
+    void stop();
+
+    /** @return: true when the group of the channel is polled */
+    [[nodiscard]] bool acquires(Channel channel) const;
+
+    /** Discard the published readings, e.g. after a disconnect. */
+    void invalidate() { m_Epoch++; }
+
+    /**
+     * @return: snapshot when the group is up to date or kept from a lost
+     * connection, nullopt otherwise
+     * */
+    [[nodiscard]] std::optional<Snapshot> fast() const;
+    [[nodiscard]] std::optional<Snapshot> slow() const;
+
+    /** @return: age of each group or nullopt when not available */
+    [[nodiscard]] std::optional<std::chrono::milliseconds> fastAge() const;
+    [[nodiscard]] std::optional<std::chrono::milliseconds> slowAge() const;
+
+    /**
+     * Samples of the last window, see FormatHistory
+     * @return: false when the history is disabled
+     * */
+    bool formatHistory(fmt::memory_buffer &out, Channel channel,
+                       std::chrono::milliseconds window,
+                       std::size_t               decimation) const;
+
+    /**
+     * "unchanged" while generation is the latest tree generation,
+     * "<generation> <sysTree> <modTree>" otherwise, see FormatCompactTree
+     * @return: false when the slow group is not available
+     * */
+    bool formatTreesSince(fmt::memory_buffer &out, uint64_t generation) const;
+
+  private:
+    void run();
+    void acquire(bool readFast, bool readSlow);
+    /**
+     * On the worker thread
+     * @return: true when a snapshot was published
+     * */
+    bool read(bool readFast, bool readSlow);
+    /** Trees just read against the previous ones, see treeGeneration */
+    void detectTreeChange();
+
+    [[nodiscard]] bool isFresh(const Snapshot &snapshot, int64_t time,
+                               std::chrono::milliseconds period) const;
+    /** Last readings of a lost connection */
+    [[nodiscard]] bool isKept(int64_t time,
+                              std::chrono::milliseconds period) const;
+    [[nodiscard]] std::optional<std::chrono::milliseconds>
+    age(const Snapshot &snapshot, int64_t time) const;
+
+    std::shared_ptr<Comm>    m_Comm;
+    TcioWorker &             m_Worker;
+    const AcquisitionConfig  m_Config;
+    Utils::SeqLock<Snapshot> m_Snapshot; /** published readings */
+    Snapshot                 m_Next;     /** worker thread only */
+    std::atomic<uint64_t>    m_Epoch{0};
+    History                  m_History;
+    Listener                 m_Listener;
+    std::unique_ptr<SharedSnapshotWriter> m_Shared; /** worker thread only */
+    // Worker thread only, kept across connections
+    TreeSample m_SysTree;
+    TreeSample m_ModTree;
+    uint64_t   m_TreeGeneration{0};
+
+    std::thread             m_Thread;
+    std::mutex              m_StopMutex;
+    std::condition_variable m_StopCondition;
+    bool                    m_Stop{false};
+};
+
+} // namespace Regatron
@@ -0,0 +1,220 @@
+#include "Binary.hpp"
+
+#include <iterator>
+
+#include "utils/LittleEndian.hpp"
+
+namespace Regatron::Binary {
+
+namespace {
+using Utils::LittleEndian::Get;
+using Utils::LittleEndian::GetF64;
+using Utils::LittleEndian::Put;
+using Utils::LittleEndian::PutF64;
+
+void PutHeader(fmt::memory_buffer &out, uint16_t command, uint32_t id,
+               uint8_t flags, Type type) {
+    Put(out, command);
+    Put(out, id);
+    Put(out, flags);
+    Put(out, static_cast<uint8_t>(type));
+}
+
+/** group, mask of the non zero words, the non zero words */
+void PutCompact(fmt::memory_buffer &out, const T_ErrorTree32 &tree) {
+    uint32_t mask = 0;
+    for (std::size_t i = 0; i < std::size(tree.error); i++) {
+        if (tree.error[i] != 0) {
+            mask |= 1U << i;
+        }
+    }
+    Put(out, static_cast<uint32_t>(tree.group));
+    Put(out, mask);
+    for (const auto word : tree.error) {
+        if (word != 0) {
+            Put(out, static_cast<uint32_t>(word));
+        }
+    }
+}
+
+bool GetCompact(std::string_view &in, T_ErrorTree32 &tree) {
+    uint32_t group = 0;
+    uint32_t mask  = 0;
+    if (!Get(in, group) || !Get(in, mask)) {
+        return false;
+    }
+    tree       = {};
+    tree.group = group;
+    for (std::size_t i = 0; i < std::size(tree.error); i++) {
+        uint32_t word = 0;
+        if (((mask >> i) & 1U) != 0) {
+            if (!Get(in, word)) {
+                return false;
+            }
+        }
+        tree.error[i] = word;
+    }
+    return true;
+}
+} // namespace
+
+std::optional<Request> DecodeRequest(std::string_view payload) {
+    Request request;
+    uint8_t type = 0;
+    if (!Get(payload, request.command) || !Get(payload, request.id) ||
+        !Get(payload, request.flags) || !Get(payload, type)) {
+        return {};
+    }
+    request.type = static_cast<Type>(type);
+    switch (request.type) {
+    case Type::None:
+        return payload.empty() ? std::optional{request} : std::nullopt;
+    case Type::F64:
+        if (!GetF64(payload, request.number) || !payload.empty()) {
+            return {};
+        }
+        return request;
+    case Type::String:
+        request.text = payload;
+        return request;
+    default:
+        // Answered Invalid, the frame itself is well formed
+        return request;
+    }
+}
+
+std::optional<Reply> DecodeReply(std::string_view payload) {
+    Reply   reply;
+    uint8_t status = 0;
+    uint8_t type   = 0;
+    if (!Get(payload, reply.command) || !Get(payload, reply.id) ||
+        !Get(payload, status) || !Get(payload, type)) {
+        return {};
+    }
+    reply.status = static_cast<Status>(status);
+    reply.type   = static_cast<Type>(type);
+    reply.value  = payload;
+    return reply;
+}
+
+void EncodeGet(fmt::memory_buffer &out, uint16_t command, uint32_t id,
+               uint8_t flags) {
+    PutHeader(out, command, id, flags, Type::None);
+}
+
+void EncodeSet(fmt::memory_buffer &out, uint16_t command, uint32_t id,
+               double value) {
+    PutHeader(out, command, id, 0, Type::F64);
+    PutF64(out, value);
+}
+
+void EncodeQuery(fmt::memory_buffer &out, uint16_t command, uint32_t id,
+                 std::string_view argument) {
+    PutHeader(out, command, id, 0, Type::String);
+    out.append(argument.data(), argument.data() + argument.size());
+}
+
+void EncodeReplyHeader(fmt::memory_buffer &out, uint16_t command, uint32_t id,
+                       Status status) {
+    Put(out, command);
+    Put(out, id);
+    Put(out, static_cast<uint8_t>(status));
+}
+
+void EncodeNone(fmt::memory_buffer &out) {
+    Put(out, static_cast<uint8_t>(Type::None));
+}
+
+void EncodeF64(fmt::memory_buffer &out, double value) {
+    Put(out, static_cast<uint8_t>(Type::F64));
+    PutF64(out, value);
+}
+
+void EncodeString(fmt::memory_buffer &out, std::string_view value) {
+    Put(out, static_cast<uint8_t>(Type::String));
+    out.append(value.data(), value.data() + value.size());
+}
+
+void EncodeSample(fmt::memory_buffer &out, const StatusSample &sample) {
+    Put(out, static_cast<uint8_t>(Type::Sample));
+    PutF64(out, sample.voltage);
+    PutF64(out, sample.current);
+    PutF64(out, sample.power);
+    PutF64(out, sample.resistance);
+    Put(out, sample.state);
+}
+
+void EncodeF64Array(fmt::memory_buffer &           out,
+                    std::initializer_list<double> values) {
+    Put(out, static_cast<uint8_t>(Type::F64Array));
+    Put(out, static_cast<uint16_t>(values.size()));
+    for (const auto value : values) {
+        PutF64(out, value);
+    }
+}
+
+void EncodeTree(fmt::memory_buffer &out, const TreeSample &tree) {
+    Put(out, static_cast<uint8_t>(Type::Tree));
+    PutCompact(out, tree.error);
+    PutCompact(out, tree.warning);
+}
+
+void EncodeWaveform(fmt::memory_buffer &out, const ScopeWaveform &waveform) {
+    Put(out, static_cast<uint8_t>(Type::Waveform));
+    AppendWaveform(out, waveform);
+}
+
+std::optional<double> DecodeF64(const Reply &reply) {
+    auto   in    = reply.value;
+    double value = 0;
+    if (reply.type != Type::F64 || !GetF64(in, value) || !in.empty()) {
+        return {};
+    }
+    return value;
+}
+
+std::optional<StatusSample> DecodeSample(const Reply &reply) {
+    auto         in = reply.value;
+    StatusSample sample;
+    if (reply.type != Type::Sample || !GetF64(in, sample.voltage) ||
+        !GetF64(in, sample.current) || !GetF64(in, sample.power) ||
+        !GetF64(in, sample.resistance) || !Get(in, sample.state) ||
+        !in.empty()) {
+        return {};
+    }
+    return sample;
+}
+
+std::optional<std::vector<double>> DecodeF64Array(const Reply &reply) {
+    auto     in    = reply.value;
+    uint16_t count = 0;
+    if (reply.type != Type::F64Array || !Get(in, count)) {
+        return {};
+    }
+    std::vector<double> values(count);
+    for (auto &value : values) {
+        if (!GetF64(in, value)) {
+            return {};
+        }
+    }
+    return in.empty() ? std::optional{values} : std::nullopt;
+}
+
+std::optional<TreeSample> DecodeTree(const Reply &reply) {
+    auto       in = reply.value;
+    TreeSample tree;
+    if (reply.type != Type::Tree || !GetCompact(in, tree.error) ||
+        !GetCompact(in, tree.warning) || !in.empty()) {
+        return {};
+    }
+    return tree;
+}
+
+std::optional<ScopeWaveform> DecodeWaveform(const Reply &reply) {
+    if (reply.type != Type::Waveform) {
+        return {};
+    }
+    return ParseWaveform(reply.value);
+}
+
+} // namespace Regatron::Binary
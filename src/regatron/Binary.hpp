@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "OfflineScope.hpp"
+#include "Snapshot.hpp"
+#include "fmt/format.h"
+
+/**
+ * Payloads of the binary protocol, carried in Net::Frame frames.
+ * Every integer and double is little endian.
+ * Request: uint16 command id, uint32 request id, uint8 flags, uint8 Type,
+ * then the argument: none for a get, F64 for a set, String for a query.
+ * Reply: uint16 command id, uint32 request id, uint8 Status, uint8 Type,
+ * then the value.
+ * The command id is the position of the command in getCommandTable.
+ * */
+namespace Regatron::Binary {
+
+enum class Status : uint8_t {
+    Ok          = 0,
+    Nack        = 1, /** failed, as "NACK" */
+    Unavailable = 2, /** not connected, as "UNAVAILABLE" */
+    Stale       = 3, /** kept from a lost connection, as "STALE" */
+    Invalid     = 4  /** unknown command id or argument type */
+};
+
+enum class Type : uint8_t {
+    None     = 0,
+    F64      = 1,
+    String   = 2, /** the text reply value, up to the end of the payload */
+    Sample   = 3, /** voltage, current, power, resistance F64, state uint32 */
+    F64Array = 4, /** uint16 count, then the values */
+    Tree     = 5, /** error then warning: uint32 group, mask, words... */
+    Waveform = 6  /** offline scope, see AppendWaveform */
+};
+
+/** Request flag, skips the acquisition snapshot as "fresh" */
+constexpr uint8_t     FRESH       = 0x01;
+constexpr std::size_t HEADER_SIZE = 8;
+
+struct Request {
+    uint16_t         command = 0;
+    uint32_t         id      = 0;
+    uint8_t          flags   = 0;
+    Type             type    = Type::None;
+    double           number  = 0; /** Type::F64 */
+    std::string_view text;        /** Type::String */
+};
+
+struct Reply {
+    uint16_t         command = 0;
+    uint32_t         id      = 0;
+    Status           status  = Status::Ok;
+    Type             type    = Type::None;
+    std::string_view value; /** encoded, see the Decode functions */
+};
+
+/** @return: nullopt when malformed */
+std::optional<Request> DecodeRequest(std::string_view payload);
+std::optional<Reply>   DecodeReply(std::string_view payload);
+
+void EncodeGet(fmt::memory_buffer &out, uint16_t command, uint32_t id,
+               uint8_t flags = 0);
+void EncodeSet(fmt::memory_buffer &out, uint16_t command, uint32_t id,
+               double value);
+void EncodeQuery(fmt::memory_buffer &out, uint16_t command, uint32_t id,
+                 std::string_view argument);
+
+/** Reply up to the status, one of the value encoders follows */
+void EncodeReplyHeader(fmt::memory_buffer &out, uint16_t command, uint32_t id,
+                       Status status);
+void EncodeNone(fmt::memory_buffer &out);
+void EncodeF64(fmt::memory_buffer &out, double value);
+void EncodeString(fmt::memory_buffer &out, std::string_view value);
+void EncodeSample(fmt::memory_buffer &out, const StatusSample &sample);
+void EncodeF64Array(fmt::memory_buffer &           out,
+                    std::initializer_list<double> values);
+/** Same words as FormatCompactTree */
+void EncodeTree(fmt::memory_buffer &out, const TreeSample &tree);
+void EncodeWaveform(fmt::memory_buffer &out, const ScopeWaveform &waveform);
+
+/** @return: nullopt when the reply is of another type or malformed */
+std::optional<double>              DecodeF64(const Reply &reply);
+std::optional<StatusSample>        DecodeSample(const Reply &reply);
+std::optional<std::vector<double>> DecodeF64Array(const Reply &reply);
+std::optional<TreeSample>          DecodeTree(const Reply &reply);
+std::optional<ScopeWaveform>       DecodeWaveform(const Reply &reply);
+
+} // namespace Regatron::Binary
@@ -1,20 +1,40 @@
 
 #include "Comm.hpp"
+#include <fstream>
 #include <optional>
 
+#include "Tcio.hpp"
+
 namespace Regatron {
 
+namespace {
+#if __linux__
+/** DllSearchDevice numbers the devices from 1 */
+constexpr int DLL_PORT_OFFSET = 1;
+#else
+constexpr int DLL_PORT_OFFSET = 0;
+#endif
+
+int64_t ElapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+}
+} // namespace
+
 Comm::Comm(int port)
     : m_Port(port), m_PortNrFound(-1), m_CommStatus{CommStatus::Disconncted},
       m_readings(std::make_shared<Regatron::Readings>()), m_Connected(false),
       m_AutoReconnect(true),
-      m_AutoReconnectAttemptTime(std::chrono::system_clock::now()),
-      m_AutoReconnectInterval(std::chrono::seconds{15}) {}
+      m_AutoReconnectInterval(std::chrono::seconds{15}) {
+    Tcio::SetObserver(&m_LinkMonitor);
+}
 
 Comm::Comm() : Comm(1) {}
 
 Comm::~Comm() {
     disconnect();
+    Tcio::ClearObserver(&m_LinkMonitor);
     LOG_DEBUG("Comm object destroyed!");
 }
 
@@ -22,7 +42,7 @@ void Comm::ReadCommStatus() {
 	int pState{-1};
 	int pErrorNo{0};
 
-	if (DllGetStatus(&pState, &pErrorNo) != DLL_SUCCESS) {
+	if (TCIO(DllGetStatus)(&pState, &pErrorNo) != DLL_SUCCESS) {
 		LOG_WARN(R"(DLL: Failed to get DLL status. CommStatus set to "Disconnected")");
 		m_CommStatus = CommStatus::Disconncted;
 	}
@@ -58,16 +78,26 @@ std::chrono::seconds Comm::GetAutoReconnectInterval() const {
     return m_AutoReconnectInterval;
 }
 
+void Comm::SetConnectDelay(std::chrono::milliseconds delay) {
+    m_ConnectDelay = delay;
+}
+std::chrono::milliseconds Comm::GetConnectDelay() const {
+    return m_ConnectDelay;
+}
+
 void Comm::disconnect() {
-    auto result  = DllClose();
-    m_Connected  = false;
-    m_CommStatus = CommStatus::Disconncted;
+    auto result       = TCIO(DllClose)();
+    m_Connected       = false;
+    m_CommStatus      = CommStatus::Disconncted;
+    m_ConnectionState = ConnectionState::Disconnected;
+    m_IdentityPending = false;
 
     /** Reset DLL Variables */
     // Connection
     m_PortNrFound = -1;
 
     m_readings->Reset();
+    DeviceAccessControl::InvalidateSelector();
 
     LOG_WARN(
         R"(Dllclose: Driver/Objects used by the TCIO are closed, released memory (code "{}"))",
@@ -75,52 +105,25 @@ void Comm::disconnect() {
 }
 
 std::optional<std::shared_ptr<Regatron::Readings>> Comm::getReadings() {
-    if (m_CommStatus != CommStatus::Ok) {
-        LOG_ERROR(R"(Invalid DLL communication status "{}")",
-                  static_cast<int>(m_CommStatus));
+    if (m_ConnectionState != ConnectionState::Ok ||
+        m_CommStatus != CommStatus::Ok) {
+        LOG_ERROR(
+            R"(Invalid DLL communication status "{}", connection state "{}")",
+            static_cast<int>(m_CommStatus.load()),
+            static_cast<int>(m_ConnectionState.load()));
         return {};
     }
     return {m_readings};
 }
 
-void Comm::autoConnect() {
-    if (m_Connected && m_CommStatus != CommStatus::Ok) {
-        LOG_WARN(R"(Inconsistency detected, m_Connected is "true" but CommStatus is not "Ok",)"
-            " probably the power supply has been turned off. Forcing a communication restart..."
-        );
-        disconnect();
-    }
-
-    if (m_AutoReconnect && !m_Connected) {
-        const auto now       = std::chrono::system_clock::now();
-        const auto timeDelta = now - m_AutoReconnectAttemptTime;
-
-        if ((timeDelta < m_AutoReconnectInterval) && !m_InitialConnection) {
-            LOG_TRACE(
-                R"(autoconnect: timeout will be active for more "{} s", ignoring attempt.)",
-                (std::chrono::duration_cast<std::chrono::seconds>(
-                     m_AutoReconnectInterval - timeDelta))
-                    .count());
-            return;
-        }
-
-        LOG_TRACE(R"(autoconnect: attempting to connect after "{} s".)",
-                  std::chrono::duration_cast<std::chrono::seconds>(timeDelta)
-                      .count());
-        m_AutoReconnectAttemptTime = now;
-        try {
-            m_InitialConnection = false;
-            connect();
-        } catch (const CommException &e) {
-            LOG_ERROR(R"(autoconnect: Failed to connect "{}")", e.what());
-        }
-    }
-}
-
 CommStatus Comm::getCommStatus() const {
     return m_CommStatus;
 }
 
+ConnectionState Comm::getConnectionState() const {
+    return m_ConnectionState;
+}
+
 bool       Comm::getAutoReconnect() const {
     return m_AutoReconnect;
 }
@@ -132,7 +135,8 @@ void       Comm::setAutoReconnect(bool autoReconnect) {
 
 void Comm::InitializeDLL() {
     LOG_TRACE("Initializing TCIO lib.");
-    if (DllInit() != DLL_SUCCESS) {
+    DeviceAccessControl::InvalidateSelector();
+    if (TCIO(DllInit)() != DLL_SUCCESS) {
         throw CommException("Failed to initialize TCIO lib.");
     }
     ReadCommStatus();
@@ -155,81 +159,337 @@ bool Comm::connect(int fromPort, int toPort) {
             fmt::format(R"(invalid port range [{},{}].)", fromPort, toPort));
     }
 
+    try {
+        open();
+        if (!probe(fromPort, toPort)) {
+            // hack: while eth and rs232 at the same tc device: wait 2 sec
+            std::this_thread::sleep_for(m_ConnectDelay);
+            search(fromPort, toPort);
+        }
+        initialize();
+    } catch (const CommException &) {
+        m_ConnectionState = ConnectionState::Disconnected;
+        throw;
+    }
+    return true;
+}
+
+void Comm::open() {
+    m_AttemptStart    = std::chrono::steady_clock::now();
+    m_Times           = ConnectTimes{};
+    m_ConnectionState = ConnectionState::Searching;
     InitializeDLL();
 #if __linux__
-    if (DllSetSearchDevice2ttyDIGI() != DLL_SUCCESS) {
+    if (TCIO(DllSetSearchDevice2ttyDIGI)() != DLL_SUCCESS) {
         throw CommException("failed to set ttyDIGI string pattern.");
     }
 #endif
-
-    if (fromPort == toPort) {
-        LOG_INFO(R"(searching DIGI RealPort device "{}{:02}")", DEVICE_PREFIX,
-                 fromPort);
-    } else {
-        LOG_INFO(
-            R"(searching DIGI RealPort device in range "{}{:02}" to "{}{:02}")",
-            DEVICE_PREFIX, fromPort, DEVICE_PREFIX, toPort);
+#ifdef TCIO_FAST_DETECTION
+    if (m_FastDetection &&
+        TCIO(DllSetComPortFastDetection)(1) != DLL_SUCCESS) {
+        throw CommException("failed to enable fast COM port detection.");
+    }
+#else
+    if (m_FastDetection) {
+        LOG_WARN("Fast COM port detection is not available in this TCIO lib.");
     }
+#endif
 
     // use this function for VM or rs232 over ethernet
     unsigned int readTout{0};
     unsigned int writeTout{0};
-    if (DllSetCommTimeouts(READ_TIMEOUT_MULTIPLIER, WRITE_TIMEOUT_MULTIPLIER) !=
-        DLL_SUCCESS) {
+    if (TCIO(DllSetCommTimeouts)(READ_TIMEOUT_MULTIPLIER,
+                                 WRITE_TIMEOUT_MULTIPLIER) != DLL_SUCCESS) {
         throw CommException(R"("Failed to set DLL comm timeouts.")");
     }
 
-    if (DllGetCommTimeouts(&readTout, &writeTout) != DLL_SUCCESS) {
+    if (TCIO(DllGetCommTimeouts)(&readTout, &writeTout) != DLL_SUCCESS) {
         throw CommException(R"("Failed to get actual DLL comm timeouts.")");
     }
     LOG_TRACE(R"(Timeout after configuration: "read={}" "write={}".)",
               readTout, writeTout);
+    m_LinkMonitor.reset();
+    m_LinkMonitor.setMultiplier(readTout);
+    m_Times.open = ElapsedMs(m_AttemptStart);
+}
 
-    // hack: while eth and rs232 at the same tc device: wait 2 sec
-    std::this_thread::sleep_for(DELAY_RS232);
+bool Comm::probe() { return probe(m_Port, m_Port); }
+bool Comm::probe(int fromPort, int toPort) {
+    CheckSearching();
+    if (m_LastPort < fromPort + DLL_PORT_OFFSET ||
+        m_LastPort > toPort + DLL_PORT_OFFSET) {
+        return false;
+    }
 
-    m_PortNrFound = -1; // Zero m_PortNrFound
-#if __linux__
-    if (DllSearchDevice(fromPort + 1, toPort + 1, &m_PortNrFound) !=
-#else
-    if (DllSearchDevice(fromPort, toPort, &m_PortNrFound) !=
-#endif
-            DLL_SUCCESS ||
-        m_PortNrFound == -1) {
+    LOG_INFO(R"(probing the last connected device "{}{:02}")", DEVICE_PREFIX,
+             m_LastPort - DLL_PORT_OFFSET);
+    const auto start = std::chrono::steady_clock::now();
+    const bool found = SearchDevice(m_LastPort, m_LastPort);
+    m_Times.search += ElapsedMs(start);
+    if (!found) {
+        LOG_WARN(R"(No device at "{}{:02}", searching the port range.)",
+                 DEVICE_PREFIX, m_LastPort - DLL_PORT_OFFSET);
+    }
+    return found;
+}
+
+void Comm::search() { search(m_Port, m_Port); }
+void Comm::search(int fromPort, int toPort) {
+    CheckSearching();
+
+    if (fromPort == toPort) {
+        LOG_INFO(R"(searching DIGI RealPort device "{}{:02}")", DEVICE_PREFIX,
+                 fromPort);
+    } else {
+        LOG_INFO(
+            R"(searching DIGI RealPort device in range "{}{:02}" to "{}{:02}")",
+            DEVICE_PREFIX, fromPort, DEVICE_PREFIX, toPort);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const bool found = SearchDevice(fromPort + DLL_PORT_OFFSET,
+                                    toPort + DLL_PORT_OFFSET);
+    m_Times.search += ElapsedMs(start);
+    if (!found) {
         throw CommException(fmt::format(
             R"(Failed to connect to a device in range "{}{:02}" to "{}{:02}" (pPortNrFound={}).)",
             DEVICE_PREFIX, fromPort, DEVICE_PREFIX, toPort, m_PortNrFound));
     }
+}
 
-#if __linux__
-    LOG_TRACE(R"(Connected to device number "{}" at "{}{:02}.")", m_PortNrFound,
-              DEVICE_PREFIX, m_PortNrFound - 1);
-#else
-    LOG_TRACE(R"(Connected to device number "{}" at "{}{:02}.")", m_PortNrFound,
-              DEVICE_PREFIX, m_PortNrFound);
-#endif
-    m_Connected = true;
+void Comm::initialize() {
+    const auto start = std::chrono::steady_clock::now();
 
     int pActBaudRate{0};
-    if (DllGetCommBaudrate(&pActBaudRate) != DLL_SUCCESS) {
+    if (TCIO(DllGetCommBaudrate)(&pActBaudRate) != DLL_SUCCESS) {
         throw CommException("Failed read baudrate");
     }
     LOG_INFO("Baudrate: {}.", pActBaudRate);
+    if (m_LastBaudrate != 0 && m_LastBaudrate != pActBaudRate) {
+        LOG_WARN(
+            R"(Baudrate changed from "{}" to "{}" since the last connection.)",
+            m_LastBaudrate, pActBaudRate);
+    }
 
     // set remote control to RS232
-    if (TC4SetRemoteControlInput(2) != DLL_SUCCESS) {
+    if (TCIO(TC4SetRemoteControlInput)(2) != DLL_SUCCESS) {
         throw CommException("failed to set remote control do RS232.");
     }
     LOG_TRACE("Remote control set to RS232.");
 
-    m_readings->Initialize();
+    InitializeReadings();
 
     LOG_INFO(
         R"(Regatron device connected at port "{}", configured as "{}" with module ID "{}".)",
         m_PortNrFound, ((m_readings->isMaster()) ? "master" : "slave"),
         m_readings->getModuleID());
 
-    m_CommStatus = CommStatus::Ok;
+    m_LastPort     = m_PortNrFound;
+    m_LastBaudrate = pActBaudRate;
+    SavePort();
+
+    m_Times.initialize = ElapsedMs(start);
+    m_Times.wait = ElapsedMs(m_AttemptStart) -
+                   (m_Times.open + m_Times.search + m_Times.initialize);
+    m_ConnectTimes.store(m_Times);
+    LOG_INFO(
+        R"(Connect time: open "{} ms", wait "{} ms", search "{} ms", initialize "{} ms".)",
+        m_Times.open, m_Times.wait, m_Times.search, m_Times.initialize);
+
+    m_CommStatus      = CommStatus::Ok;
+    m_ConnectionState = ConnectionState::Ok;
+}
+
+void Comm::CheckSearching() const {
+    // A disconnect between the steps cancels the attempt
+    if (m_ConnectionState != ConnectionState::Searching) {
+        throw CommException("connection attempt cancelled.",
+                            CommStatus::Disconncted);
+    }
+}
+
+bool Comm::SearchDevice(int fromPort, int toPort) {
+    m_PortNrFound = -1; // Zero m_PortNrFound
+    if (TCIO(DllSearchDevice)(fromPort, toPort, &m_PortNrFound) !=
+            DLL_SUCCESS ||
+        m_PortNrFound == -1) {
+        return false;
+    }
+
+    LOG_TRACE(R"(Connected to device number "{}" at "{}{:02}.")", m_PortNrFound,
+              DEVICE_PREFIX, m_PortNrFound - DLL_PORT_OFFSET);
+    m_Connected       = true;
+    m_ConnectionState = ConnectionState::Initializing;
     return true;
 }
+
+void Comm::abortSearch() {
+    if (m_ConnectionState == ConnectionState::Searching) {
+        TCIO(DllAbortDeviceSearch)();
+    }
+}
+
+int Comm::getSearchProgress() {
+    int port{-1};
+    if (m_ConnectionState != ConnectionState::Searching ||
+        TCIO(DllGetDeviceSearchProgress)(&port) != DLL_SUCCESS || port < 0) {
+        return -1;
+    }
+    return port - DLL_PORT_OFFSET;
+}
+
+ConnectTimes Comm::GetConnectTimes() const { return m_ConnectTimes.load(); }
+
+void Comm::SetFastConnect(bool fastDetection, const std::string &portFile) {
+    m_FastDetection = fastDetection;
+    m_PortFile      = portFile;
+    if (m_PortFile.empty()) {
+        return;
+    }
+
+    std::ifstream file(m_PortFile);
+    int           port{-1};
+    int           baudrate{0};
+    if (file >> port >> baudrate) {
+        m_LastPort     = port;
+        m_LastBaudrate = baudrate;
+        LOG_INFO(R"(Last connection at "{}{:02}", baudrate "{}".)",
+                 DEVICE_PREFIX, m_LastPort - DLL_PORT_OFFSET, m_LastBaudrate);
+    }
+}
+
+void Comm::SetAdaptiveTimeouts(unsigned int min, unsigned int max) {
+    m_LinkMonitor.setBounds(min, max);
+    m_AdaptiveTimeouts = true;
+}
+
+bool Comm::GetAdaptiveTimeouts() const { return m_AdaptiveTimeouts; }
+
+void Comm::tuneTimeouts() {
+    if (!m_AdaptiveTimeouts || m_ConnectionState != ConnectionState::Ok) {
+        return;
+    }
+
+    unsigned int talkQueue{0};
+#ifdef TCIO_TALK_QUEUE
+    unsigned int sendBytes{0};
+    unsigned int receiveBytes{0};
+    if (TCIO(DllGetTalkQueueCount)(&talkQueue, &sendBytes, &receiveBytes) !=
+        DLL_SUCCESS) {
+        LOG_WARN("Failed to read the DLL talk queue.");
+        talkQueue = 0;
+    }
+#endif
+
+    const auto current    = m_LinkMonitor.stats().multiplier;
+    const auto multiplier = m_LinkMonitor.tune(talkQueue);
+    if (multiplier == current) {
+        return;
+    }
+    if (TCIO(DllSetCommTimeouts)(multiplier, multiplier) != DLL_SUCCESS) {
+        LOG_WARN(R"(Failed to set the DLL comm timeouts to "{}".)",
+                 multiplier);
+        return;
+    }
+    m_LinkMonitor.setMultiplier(multiplier);
+
+    const auto stats = m_LinkMonitor.stats();
+    LOG_INFO(
+        R"(Timeout multiplier "{}" -> "{}", round trip p99 "{} us", timeouts "{}", talk queue "{}".)",
+        current, multiplier, stats.p99, stats.timeouts, talkQueue);
+}
+
+LinkStats Comm::getLinkStats() const { return m_LinkMonitor.stats(); }
+
+void Comm::SetIdentityCache(const std::string &directory) {
+    m_IdentityCache.emplace(directory);
+}
+
+bool Comm::isIdentityPending() const { return m_IdentityPending; }
+
+uint32_t Comm::getIdentityLoaded() const { return m_readings->getLoaded(); }
+
+void Comm::InitializeReadings() {
+    m_SerialNr = 0;
+    if (m_IdentityCache &&
+        TCIO(TC4GetSerialNr)(&m_SerialNr) != DLL_SUCCESS) {
+        throw CommException("failed to read the serial number.");
+    }
+
+    auto identity = m_IdentityCache ? m_IdentityCache->load(m_SerialNr)
+                                    : std::optional<Identity>{};
+    if (!identity) {
+        // Only the fields needed for control, the others are loaded later
+        m_readings->Initialize();
+        m_IdentityStep       = MANDATORY_FIELDS;
+        m_IdentityRevalidate = false;
+        m_IdentityPending    = true;
+        return;
+    }
+
+    LOG_INFO(R"(Identity of serial number "{}" taken from the cache.)",
+             m_SerialNr);
+    m_readings->Initialize(*identity);
+    m_CachedIdentity     = std::move(*identity);
+    m_IdentityStep       = 0;
+    m_IdentityRevalidate = true;
+    m_IdentityPending    = true;
+}
+
+bool Comm::loadIdentity() {
+    if (!m_IdentityPending || m_ConnectionState != ConnectionState::Ok) {
+        return false;
+    }
+
+    // Fields loaded on demand meanwhile are not read again
+    while (m_IdentityStep < IDENTITY_FIELDS && !m_IdentityRevalidate &&
+           m_readings->isLoaded(static_cast<IdentityField>(m_IdentityStep))) {
+        m_IdentityStep++;
+    }
+    if (m_IdentityStep < IDENTITY_FIELDS) {
+        try {
+            m_readings->ReadIdentity(
+                static_cast<IdentityField>(m_IdentityStep++));
+        } catch (const CommException &e) {
+            // Retried on the next connection or on first use, the link is
+            // left to the acquisition
+            LOG_WARN(R"(Failed to load the identity "{}".)", e.what());
+            m_IdentityPending = false;
+            return false;
+        }
+        if (m_IdentityStep < IDENTITY_FIELDS) {
+            return true;
+        }
+    }
+
+    m_IdentityPending = false;
+    if (!m_IdentityCache) {
+        return false;
+    }
+    const auto identity = m_readings->GetIdentity(m_SerialNr);
+    if (!m_IdentityRevalidate) {
+        m_IdentityCache->save(identity);
+        return false;
+    }
+    if (identity == m_CachedIdentity) {
+        LOG_INFO(R"(Cached identity of serial number "{}" confirmed.)",
+                 identity.serialNr);
+        return false;
+    }
+    LOG_WARN(R"(Identity of serial number "{}" changed since it was cached.)",
+             identity.serialNr);
+    m_IdentityCache->save(identity);
+    return false;
+}
+
+void Comm::SavePort() const {
+    if (m_PortFile.empty()) {
+        return;
+    }
+    std::ofstream file(m_PortFile, std::ios::trunc);
+    file << m_LastPort << ' ' << m_LastBaudrate << '\n';
+    if (!file) {
+        LOG_WARN(R"(Failed to save the connected port to "{}".)", m_PortFile);
+    }
+}
 } // namespace Regatron
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <ctime>
 #include <iomanip>
@@ -12,12 +13,22 @@
 #include "fmt/format.h"
 #include "serialiolib.h" // NOLINT
 
+#include "LinkMonitor.hpp"
 #include "Readings.hpp"
 #include "Regatron.hpp"
 #include "Version.hpp"
+#include "utils/SeqLock.hpp"
 
 namespace Regatron {
 
+/** Time spent in each step of the last connection [ms] */
+struct ConnectTimes {
+    int64_t open       = 0; /** DllInit and communication setup */
+    int64_t wait       = 0; /** connect delay and waits between the steps */
+    int64_t search     = 0; /** remembered port probe and device search */
+    int64_t initialize = 0; /** remote control and readings setup */
+};
+
 class Comm {
     static constexpr std::chrono::seconds DELAY_RS232{5};
 #if __linux__
@@ -40,6 +51,74 @@ class Comm {
     bool connect(int port);
     bool connect(int fromPort, int toPort);
 
+    /**
+     * Steps of connect(), in order, the connect delay and search() are only
+     * needed when probe() did not find the device.
+     *   open(): DllInit and communication setup, state Searching.
+     *   probe(): look for the device at the port of the last connection
+     *   only, state Initializing when found.
+     *   search(): look for the device in the port range, state Initializing.
+     *   initialize(): remote control and readings setup, state Ok.
+     * @throws: CommException, the caller disconnects on failure.
+     * */
+    void open();
+    bool probe();
+    bool probe(int fromPort, int toPort);
+    void search();
+    void search(int fromPort, int toPort);
+    void initialize();
+
+    /**
+     * Abort a running device search, it fails at once.
+     * May be called from any thread.
+     * */
+    void abortSearch();
+    /** @return: port being searched, -1 when not searching. Any thread. */
+    [[nodiscard]] int getSearchProgress();
+    /** Last connection, may be called from any thread */
+    [[nodiscard]] ConnectTimes GetConnectTimes() const;
+
+    /**
+     * Fast connect: DllSetComPortFastDetection before searching, and the
+     * port and baud rate of each connection saved to portFile, so the next
+     * one probes that port before a full search.
+     * @param portFile: empty to not remember the port
+     * */
+    void SetFastConnect(bool fastDetection, const std::string &portFile);
+
+    /**
+     * Adaptive serial timeouts: tuneTimeouts() fits the timeout multiplier,
+     * READ_TIMEOUT_MULTIPLIER at each connection, to the round trip time of
+     * the recent device calls, see LinkMonitor.
+     * @param min, max: multiplier bounds, within [1, 5000]
+     * */
+    void SetAdaptiveTimeouts(unsigned int min, unsigned int max);
+    [[nodiscard]] bool GetAdaptiveTimeouts() const;
+    /** Sample the DLL talk queue and set the fitted timeouts when connected */
+    void tuneTimeouts();
+    /** May be called from any thread */
+    [[nodiscard]] LinkStats getLinkStats() const;
+
+    /**
+     * Identity cache: initialize() reads the serial number and, for a unit
+     * seen before, takes the increments, limits and versions from the cache
+     * instead of the device. loadIdentity() reads them back later.
+     * @param directory: one file per serial number
+     * */
+    void SetIdentityCache(const std::string &directory);
+    /** @return: true while identity fields remain to be loaded or read back */
+    [[nodiscard]] bool isIdentityPending() const;
+    /** Readings::getLoaded, may be called from any thread */
+    [[nodiscard]] uint32_t getIdentityLoaded() const;
+    /**
+     * initialize() only reads the MANDATORY_FIELDS, setpoints are accepted at
+     * once. Loads the next identity field not loaded on demand yet, or reads
+     * back the next cached one. The cache is written once all are loaded and
+     * the device no longer matches it.
+     * @return: true while fields remain
+     * */
+    bool loadIdentity();
+
     /** Will call DLLClose(), reset internal usage variables, set m_PortNrFound to -1,
         set m_Connected to false and m_CommStatus to CommStatus::Disconnected.
     */
@@ -48,6 +127,10 @@ class Comm {
     void SetAutoReconnectInterval(std::chrono::seconds&& seconds);
     [[nodiscard]] std::chrono::seconds GetAutoReconnectInterval() const;
 
+    /** Wait before the device search, DELAY_RS232 by default. */
+    void SetConnectDelay(std::chrono::milliseconds delay);
+    [[nodiscard]] std::chrono::milliseconds GetConnectDelay() const;
+
     /**
      * This method will read and set the actual communication status
      * @return CommStatus
@@ -55,9 +138,10 @@ class Comm {
     void ReadCommStatus();
 
     CommStatus getCommStatus() const;
+    /** May be called from any thread */
+    [[nodiscard]] ConnectionState getConnectionState() const;
     [[nodiscard]] bool getAutoReconnect() const;
     void       setAutoReconnect(bool autoReconnect);
-    void       autoConnect();
 
     /**
      *   Regatron Readings
@@ -69,15 +153,43 @@ class Comm {
   private:
     int                                 m_Port;        /** comm port */
     int                                 m_PortNrFound; /** detected comm port */
-    CommStatus m_CommStatus; /** DLL communication details */
+    std::atomic<CommStatus> m_CommStatus; /** DLL communication details */
     std::shared_ptr<Regatron::Readings> m_readings;    /** Readings*/
     bool       m_Connected;     /** Whether we are connected to the device */
-    bool       m_AutoReconnect; /** Auto reconnect to device */
-    std::chrono::time_point<std::chrono::system_clock>
-                         m_AutoReconnectAttemptTime;
+    std::atomic<bool> m_AutoReconnect; /** Auto reconnect to device */
+    std::atomic<ConnectionState> m_ConnectionState{
+        ConnectionState::Disconnected};
     std::chrono::seconds m_AutoReconnectInterval;
-    bool                 m_InitialConnection = true;
+    std::chrono::milliseconds m_ConnectDelay{DELAY_RS232};
+
+    // Fast connect
+    bool        m_FastDetection = false;
+    std::string m_PortFile;
+    int         m_LastPort     = -1; /** DLL port number of the last connection */
+    int         m_LastBaudrate = 0;
+
+    std::chrono::steady_clock::time_point m_AttemptStart;
+    ConnectTimes                          m_Times; /** attempt in progress */
+    Utils::SeqLock<ConnectTimes>          m_ConnectTimes;
+
+    LinkMonitor       m_LinkMonitor; /** round trip time of the device calls */
+    std::atomic<bool> m_AdaptiveTimeouts{false};
+
+    std::optional<IdentityCache> m_IdentityCache;
+    Identity                     m_CachedIdentity; /** as loaded */
+    std::atomic<bool>            m_IdentityPending{false};
+    std::size_t                  m_IdentityStep = 0;
+    bool          m_IdentityRevalidate = false; /** cached fields read back */
+    unsigned long m_SerialNr           = 0;     /** with a cache only */
+
     void                 InitializeDLL();
+    /** @throws: CommException when a disconnect cancelled the attempt */
+    void                 CheckSearching() const;
+    /** DllSearchDevice, with DLL port numbers */
+    bool                 SearchDevice(int fromPort, int toPort);
+    void                 SavePort() const;
+    /** Mandatory identity fields, all from the cache when possible */
+    void                 InitializeReadings();
 };
 
 } // namespace Regatron
@@ -3,6 +3,7 @@
 #include "fmt/format.h"
 
 #include "Regatron.hpp"
+#include "Tcio.hpp"
 
 namespace Regatron {
 
@@ -70,7 +71,7 @@ bool ControllerSettings::WriteSlopeVolt() {
               SlopeRawToVms(m_SlopeStartupVolt), SlopeRawToVms(m_SlopeVolt));
 
     LOG_CRITICAL("Not available");
-    if (TC4SetVoltageSlopeRamp(m_SlopeVolt, m_SlopeStartupVolt) !=
+    if (TCIO(TC4SetVoltageSlopeRamp)(m_SlopeVolt, m_SlopeStartupVolt) !=
         DLL_SUCCESS) {
         throw CommException("Failed to set voltage slopes");
     }
@@ -86,7 +87,7 @@ bool ControllerSettings::WriteSlopeVolt() {
 std::string ControllerSettings::GetSlopeVolt() {
     unsigned int startupValue{};
     unsigned int value{};
-    if (TC4GetVoltageSlopeRamp(&value, &startupValue) != DLL_SUCCESS) {
+    if (TCIO(TC4GetVoltageSlopeRamp)(&value, &startupValue) != DLL_SUCCESS) {
         throw CommException("failed to get voltage slope ramp values.");
     }
     return fmt::format("[{},{},{},{}]", startupValue, value,
@@ -161,7 +162,7 @@ bool ControllerSettings::WriteSlopeCurrent() {
               SlopeRawToAms(m_SlopeCurrent));
 
     LOG_CRITICAL("Not available");
-    if (TC4SetCurrentSlopeRamp(m_SlopeCurrent, m_SlopeStartupCurrent) !=
+    if (TCIO(TC4SetCurrentSlopeRamp)(m_SlopeCurrent, m_SlopeStartupCurrent) !=
         DLL_SUCCESS) {
         throw CommException("Failed to set current slopes");
     }
@@ -177,7 +178,7 @@ bool ControllerSettings::WriteSlopeCurrent() {
 std::string ControllerSettings::GetSlopeCurrent() {
     unsigned int startupValue{};
     unsigned int value{};
-    if (TC4GetCurrentSlopeRamp(&value, &startupValue) != DLL_SUCCESS) {
+    if (TCIO(TC4GetCurrentSlopeRamp)(&value, &startupValue) != DLL_SUCCESS) {
         throw CommException("failed to get current slope ramp values.");
     }
     return fmt::format("[{},{},{},{}]", startupValue, value,
@@ -1,18 +1,36 @@
 #include "DeviceAccessControl.hpp"
 
+#include <atomic>
+
 #include "fmt/format.h"
 #include "serialiolib.h" // NOLINT
 #include "regatron/Regatron.hpp"
+#include "regatron/Tcio.hpp"
 
 namespace Regatron{
 namespace DeviceAccessControl {
 
+namespace {
+constexpr unsigned int     SELECTOR_UNKNOWN = ~0U;
+std::atomic<unsigned int>  selected{SELECTOR_UNKNOWN};
+std::atomic<uint64_t>      writes{0};
+std::atomic<uint64_t>      skipped{0};
+} // namespace
+
 void SelectModuleByID(unsigned int module) {
-    if (TC4SetModuleSelector(module) != DLL_SUCCESS) {
+    if (selected == module) {
+        skipped++;
+        return;
+    }
+
+    writes++;
+    if (TCIO(TC4SetModuleSelector)(module) != DLL_SUCCESS) {
+        InvalidateSelector();
         throw CommException(fmt::format(
         "failed to set module selector to {} (code {})",
         ((module == SYS_VALUES) ? "system" : "device"), module));
     }
+    selected = module;
 }
 
 void SelectSys() {
@@ -23,4 +41,12 @@ void SelectMod() {
     SelectModuleByID(MOD_VALUES);
 }
 
+void InvalidateSelector() {
+    selected = SELECTOR_UNKNOWN;
+}
+
+SelectorStats GetSelectorStats() {
+    return {.writes = writes, .skipped = skipped};
+}
+
 }}
@@ -1,11 +1,30 @@
 #pragma once
 
+#include <cstdint>
+
 namespace Regatron::DeviceAccessControl {
 
     constexpr unsigned int SYS_VALUES = 64;
     constexpr unsigned int MOD_VALUES = 0;
 
+    /** Module selector writes sent to the device and skipped as redundant */
+    struct SelectorStats {
+        uint64_t writes;
+        uint64_t skipped;
+    };
+
+    /**
+     * The last selected module is remembered and a selector write is only
+     * sent when it changes. Must be called with the TCIO lock held.
+     * @throw CommException, the remembered selection is cleared
+     * */
     void SelectModuleByID(unsigned int module);
     void SelectSys();
     void SelectMod();
+
+    /** Forget the selection, the next select is always sent. On reconnect
+     * or after any DLL error. */
+    void InvalidateSelector();
+
+    SelectorStats GetSelectorStats();
 }
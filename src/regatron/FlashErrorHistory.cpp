@@ -0,0 +1,110 @@
+#include "FlashErrorHistory.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+#include "Regatron.hpp"
+#include "Tcio.hpp"
+#include "log/Logger.hpp"
+
+namespace Regatron {
+
+namespace {
+constexpr float HISTORY_NANO_MILLI_CTE = 0.05F;
+
+std::string EntryToString(const T_ErrorHistoryEntry &entry) {
+    return fmt::format(
+        R"(T_ErrorHistoryEntry(entryCounter={},day={},hour={},minute={},second={},counter50us={},group={},detail={},identifier={}))",
+        entry.entryCounter, entry.day, entry.hour, entry.minute, entry.second,
+        entry.counter50us, entry.group, entry.detail, entry.identifier);
+}
+} // namespace
+
+void FlashErrorHistory::Update(std::size_t maxReads) {
+    unsigned int size{0};
+    if (TCIO(TC4GetFlashErrorHistorySize)(&size) != DLL_SUCCESS) {
+        throw CommException("failed to read error history entries.");
+    }
+
+    T_ErrorHistoryEntry entry{};
+    signed int          error{0};
+    unsigned long       first{0};
+    unsigned long       previous{0};
+    std::size_t         added{0};
+    const std::size_t   reads = std::min<std::size_t>(size, maxReads);
+    for (std::size_t nEntry = 0; nEntry < reads; nEntry++) {
+        const auto result =
+            nEntry == 0 ? TCIO(TC4GetFlashErrorHistoryFirstEntry)(&entry, &error)
+                        : TCIO(TC4GetFlashErrorHistoryNextEntry)(&entry, &error);
+        if (result != DLL_SUCCESS) {
+            throw CommException("failed to read entry.");
+        }
+
+        const bool known = m_Entries.count(entry.entryCounter) != 0;
+        if (nEntry == 0) {
+            if (known && size == m_DeviceSize &&
+                entry.entryCounter == m_FirstCounter) {
+                return;
+            }
+            first = entry.entryCounter;
+        } else if (known && entry.entryCounter < previous) {
+            // Newest first, the older ones were copied before
+            break;
+        }
+        previous = entry.entryCounter;
+        if (!known) {
+            m_Entries.emplace(entry.entryCounter, entry);
+            LOG_DEBUG("{}) {}", nEntry, EntryToString(entry));
+            added++;
+        }
+    }
+
+    // Only once every entry made it, a failed read is retried in full
+    m_DeviceSize   = size;
+    m_FirstCounter = first;
+    while (m_Entries.size() > CAPACITY) {
+        m_Entries.erase(m_Entries.begin());
+    }
+    if (added != 0) {
+        LOG_INFO(R"(TC4ErrorHistory: "{}" new entries, "{}" on the device)",
+                 added, size);
+    }
+}
+
+void FlashErrorHistory::Clear() {
+    m_Entries.clear();
+    m_DeviceSize   = 0;
+    m_FirstCounter = 0;
+}
+
+void FlashErrorHistory::Format(fmt::memory_buffer &out, unsigned long since,
+                               std::size_t count) const {
+    FormatRange(out, m_Entries.upper_bound(since), count);
+}
+
+void FlashErrorHistory::FormatLast(fmt::memory_buffer &out,
+                                   std::size_t count) const {
+    auto it = m_Entries.begin();
+    if (m_Entries.size() > count) {
+        std::advance(it, m_Entries.size() - count);
+    }
+    FormatRange(out, it, count);
+}
+
+void FlashErrorHistory::FormatRange(fmt::memory_buffer &out,
+                                    Entries::const_iterator it,
+                                    std::size_t count) const {
+    auto inserter = std::back_inserter(out);
+    out.push_back('[');
+    for (std::size_t n = 0; n < count && it != m_Entries.end(); n++, it++) {
+        const auto &entry = it->second;
+        inserter          = fmt::format_to(
+            inserter, "{},{},{},{},{},{:.2f},{},{} ", entry.entryCounter,
+            entry.day, entry.hour, entry.minute, entry.second,
+            static_cast<float>(entry.counter50us) * HISTORY_NANO_MILLI_CTE,
+            entry.group, entry.detail);
+    }
+    out.push_back(']');
+}
+
+} // namespace Regatron
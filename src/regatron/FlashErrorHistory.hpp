@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+
+#include "fmt/format.h"
+#include "serialiolib.h" // NOLINT
+
+namespace Regatron {
+
+/**
+ * Host side copy of the device flash error history, by entryCounter.
+ * Update() reads the entries the copy is missing, queries are served from
+ * the copy. Dropped on disconnect, another unit may answer the next time.
+ * */
+class FlashErrorHistory {
+  public:
+    /** Entries kept, the oldest are dropped first */
+    static constexpr std::size_t CAPACITY = 300;
+
+    /**
+     * Nothing but the size and the first entry is read while the history is
+     * unchanged. Listed newest first, reading stops at the first entry
+     * already copied; listed oldest first, every entry is read again.
+     * @param maxReads: entries read at most
+     * @throws: CommException
+     * */
+    void Update(std::size_t maxReads);
+    void Clear();
+
+    /** "[entry entry ]", oldest first, after entryCounter since */
+    void Format(fmt::memory_buffer &out, unsigned long since,
+                std::size_t count) const;
+    /** Same, the newest count entries */
+    void FormatLast(fmt::memory_buffer &out, std::size_t count) const;
+
+  private:
+    using Entries = std::map<unsigned long, T_ErrorHistoryEntry>;
+
+    void FormatRange(fmt::memory_buffer &out, Entries::const_iterator it,
+                     std::size_t count) const;
+
+    Entries       m_Entries;
+    unsigned int  m_DeviceSize   = 0; /** TC4GetFlashErrorHistorySize */
+    unsigned long m_FirstCounter = 0; /** first entry the device listed */
+};
+
+} // namespace Regatron
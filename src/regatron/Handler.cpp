@@ -23,44 +23,311 @@ namespace Regatron {
     }
 
 #define GET_FUNC(func)                                                         \
-    [this]() {                                                                 \
+    [this](Response &response) {                                               \
         auto readings = this->m_RegatronComm->getReadings();                   \
-        return readings ? readings.value()->func : NACK;                       \
+        Append(response, readings ? readings.value()->func : NACK);            \
     }
 
 #define GET_FORMAT(member)                                                     \
-    [this]() {                                                                 \
+    [this](Response &response) {                                               \
         auto readings = this->m_RegatronComm->getReadings();                   \
-        return readings ? fmt::format("{}", readings.value()->member) : NACK;  \
+        if (readings) {                                                        \
+            fmt::format_to(std::back_inserter(response), "{}",                 \
+                           readings.value()->member);                          \
+            return;                                                            \
+        }                                                                      \
+        Append(response, NACK);                                                \
     }
 
 #define CMD_API(member)                                                        \
-    [this]() {                                                                 \
+    [this](Response &response) {                                               \
         auto readings = this->m_RegatronComm->getReadings();                   \
         if (readings) {                                                        \
             readings.value()->member;                                          \
-            return ACK;                                                        \
+            Append(response, ACK);                                             \
+            return;                                                            \
         }                                                                      \
-        return NACK;                                                           \
+        Append(response, NACK);                                                \
+    }
+
+/** Cached alternative of a get command, see Acquisition. */
+#define CACHED(group, format)                                                  \
+    [this](Response &response) {                                               \
+        const auto snapshot = this->m_Acquisition.group();                     \
+        if (!snapshot) {                                                       \
+            return false;                                                      \
+        }                                                                      \
+        format;                                                                \
+        return true;                                                           \
+    }
+
+/** Typed alternative of CACHED for the binary protocol, see Binary */
+#define ENCODED(group, encode)                                                 \
+    [this](Response &response) {                                               \
+        const auto snapshot = this->m_Acquisition.group();                     \
+        if (!snapshot) {                                                       \
+            return false;                                                      \
+        }                                                                      \
+        encode;                                                                \
+        return true;                                                           \
     }
 
 volatile static double debugValue{0.0};
 
+namespace {
+constexpr std::string_view READ_PREFIX   = "get";
+constexpr std::string_view MODULE_PREFIX = "getMod";
+
+/** @return: command name of a message, without the fresh prefix */
+std::string_view CommandName(std::string_view message) {
+    auto name = message.substr(0, message.find(' '));
+    if (name == FRESH) {
+        message.remove_prefix(name.size());
+        message.remove_prefix(
+            std::min(message.find_first_not_of(' '), message.size()));
+        name = message.substr(0, message.find(' '));
+    }
+    return name;
+}
+
+bool IsModuleCommand(std::string_view name) {
+    return name.starts_with(MODULE_PREFIX);
+}
+
+bool IsRead(std::string_view message) {
+    return CommandName(message).starts_with(READ_PREFIX);
+}
+
+bool IsModuleRead(std::string_view message) {
+    return IsModuleCommand(CommandName(message));
+}
+
+/** Commands that do not use the device, handled on the caller thread */
+constexpr std::array<std::string_view, 16> LOCAL_COMMANDS{
+    "getDebug",          "setDebug",           "cmdConnect",
+    "getCommStatus",     "getConnectionState", "getAutoReconnect",
+    "setAutoReconnect",  "getSelectorStats",   "getReadingsAge",
+    "getConnectTimes",   "getSearchProgress",  "getLinkStats",
+    "getIdentityLoaded", "getHistory",         "getTreeSince",
+    "getCommandTable"};
+
+/** Longer than any history, larger windows are clamped to it */
+constexpr double MAX_HISTORY_SECONDS = 7 * 24 * 3600.;
+
+/** getHistory "<channel> <seconds>[ <decimation>]" */
+struct HistoryRequest {
+    Channel                   channel{};
+    std::chrono::milliseconds window{0};
+    std::size_t               decimation = 1;
+};
+
+std::optional<HistoryRequest> ParseHistory(std::string_view argument) {
+    std::array<std::string_view, 3> words{};
+    std::size_t                     count = 0;
+    while (!argument.empty()) {
+        const auto end = argument.find(' ');
+        if (end != 0) {
+            if (count == words.size()) {
+                return {};
+            }
+            words[count++] = argument.substr(0, end);
+        }
+        argument.remove_prefix(end == std::string_view::npos ? argument.size()
+                                                             : end + 1);
+    }
+
+    const auto number = [](std::string_view word, auto &value) {
+        return std::from_chars(word.data(), word.data() + word.size(), value)
+                   .ec == std::errc{};
+    };
+    HistoryRequest request;
+    double         seconds{0};
+    const auto     channel = ParseChannel(words[0]);
+    if (count < 2 || !channel || !number(words[1], seconds) ||
+        !std::isfinite(seconds) || seconds < 0 ||
+        (count == 3 && !number(words[2], request.decimation)) ||
+        request.decimation == 0) {
+        return {};
+    }
+    request.channel = *channel;
+    request.window  = std::chrono::milliseconds{
+        static_cast<std::chrono::milliseconds::rep>(
+            std::min(seconds, MAX_HISTORY_SECONDS) * 1000)};
+    return request;
+}
+
+/** getFlashErrorHistory "[<since> <count>]", no argument has count 0 */
+struct FlashHistoryPage {
+    unsigned long since = 0;
+    std::size_t   count = 0;
+};
+
+std::optional<FlashHistoryPage> ParseFlashHistoryPage(std::string_view argument) {
+    FlashHistoryPage page;
+    if (argument.empty()) {
+        return page;
+    }
+    const auto separator = argument.find(' ');
+    if (separator == std::string_view::npos) {
+        return {};
+    }
+    const auto since = argument.substr(0, separator);
+    const auto count = argument.substr(separator + 1);
+    if (std::from_chars(since.data(), since.data() + since.size(), page.since)
+                .ec != std::errc{} ||
+        std::from_chars(count.data(), count.data() + count.size(), page.count)
+                .ec != std::errc{} ||
+        page.count == 0) {
+        return {};
+    }
+    page.count = std::min(page.count, FlashErrorHistory::CAPACITY);
+    return page;
+}
+
+/** setScopeChannels "<address>[:<factor>] ..." */
+std::optional<std::vector<ScopeChannel>>
+ParseScopeChannels(std::string_view argument) {
+    std::vector<ScopeChannel> channels;
+    while (!argument.empty()) {
+        const auto end  = argument.find(' ');
+        const auto word = argument.substr(0, end);
+        argument.remove_prefix(end == std::string_view::npos ? argument.size()
+                                                             : end + 1);
+        if (word.empty()) {
+            continue;
+        }
+
+        ScopeChannel channel;
+        const auto   separator = word.find(':');
+        const auto   address   = word.substr(0, separator);
+        if (std::from_chars(address.data(), address.data() + address.size(),
+                            channel.address)
+                .ec != std::errc{}) {
+            return {};
+        }
+        if (separator != std::string_view::npos) {
+            const auto factor = word.substr(separator + 1);
+            if (std::from_chars(factor.data(), factor.data() + factor.size(),
+                                channel.factor)
+                    .ec != std::errc{}) {
+                return {};
+            }
+        }
+        channels.push_back(channel);
+    }
+    if (channels.empty() || channels.size() > ScopeWaveform::CHANNELS) {
+        return {};
+    }
+    return channels;
+}
+
+/** Too large for a batch item, see FormatWaveform */
+constexpr std::string_view SCOPE_WAVEFORM = "getScopeWaveform";
+/** TC4GetOffLineScopeValue calls per worker job of getScopeWaveform */
+constexpr std::size_t SCOPE_CALLS_PER_JOB = 16;
+
+/** Device commands accepted while not connected */
+constexpr std::string_view DISCONNECT = "cmdDisconnect";
+
+bool IsLocal(std::string_view name) {
+    return std::find(LOCAL_COMMANDS.begin(), LOCAL_COMMANDS.end(), name) !=
+           LOCAL_COMMANDS.end();
+}
+
+constexpr std::array<std::string_view, 8> BACKGROUND_COMMANDS{
+    "getFlashErrorHistory", "getDSPID",      "getDSPVersion",
+    "getDLLVersion",        "getPLDVersion", "getIBCVersion",
+    "getBootloaderVersion", SCOPE_WAVEFORM};
+
+/** @return: false when outside of the physical limits, or NaN */
+bool InPhysRange(const PhysLimits &phys, Shared::Setpoint setpoint,
+                 double value) {
+    static constexpr std::array<double PhysValues::*, Shared::SETPOINTS>
+        MEMBERS{&PhysValues::voltage, &PhysValues::current,
+                &PhysValues::power, &PhysValues::resistance};
+    const auto member = MEMBERS[static_cast<std::size_t>(setpoint)];
+    return value >= phys.min.*member && value <= phys.max.*member;
+}
+
+/** Maximum time waiting for the TCIO worker, by Priority */
+constexpr std::array<std::chrono::milliseconds, 3> DEADLINES{
+    std::chrono::seconds{10}, std::chrono::seconds{10},
+    std::chrono::seconds{30}};
+
+/** Writes preempt reads, slow or rarely changing reads come last. */
+Priority PriorityOf(std::string_view name, std::string_view argument) {
+    // Before the argument check, getFlashErrorHistory takes a page
+    if (std::find(BACKGROUND_COMMANDS.begin(), BACKGROUND_COMMANDS.end(),
+                  name) != BACKGROUND_COMMANDS.end()) {
+        return Priority::Background;
+    }
+    if (!argument.empty() || !name.starts_with(READ_PREFIX)) {
+        return Priority::Control;
+    }
+    return Priority::Monitor;
+}
+
+/** Highest priority of the items of a batch */
+Priority BatchPriority(std::string_view message) {
+    message.remove_prefix(std::string_view{BATCH}.size());
+    auto priority = Priority::Background;
+    while (!message.empty()) {
+        const auto end  = message.find(BATCH_SEPARATOR);
+        const auto item = message.substr(0, end);
+        message.remove_prefix(end == std::string_view::npos ? message.size()
+                                                            : end + 1);
+        const auto name = CommandName(
+            item.substr(std::min(item.find_first_not_of(' '), item.size())));
+        if (name.empty()) {
+            continue;
+        }
+        auto argument = item.substr(item.find(name) + name.size());
+        argument.remove_prefix(
+            std::min(argument.find_first_not_of(" \r\n"), argument.size()));
+        priority = std::min(priority, PriorityOf(name, argument));
+    }
+    return priority;
+}
+
+/** @return: true for "#<digits>" */
+bool IsTag(std::string_view tag) {
+    uint64_t   id{0};
+    const auto end    = tag.data() + tag.size();
+    const auto result = std::from_chars(tag.data() + 1, end, id);
+    return tag.size() > 1 && result.ec == std::errc{} && result.ptr == end;
+}
+} // namespace
+
 // @fixme: Do this in a way that does not require macros.
-Handler::Handler(std::shared_ptr<Regatron::Comm> regatronComm)
+Handler::Handler(std::shared_ptr<Regatron::Comm> regatronComm,
+                 AcquisitionConfig               acquisitionConfig,
+                 const std::string &             sharedCommands)
     : m_RegatronComm(regatronComm),
+      m_Reconnector(regatronComm, m_Worker),
+      m_Acquisition(regatronComm, m_Worker, acquisitionConfig),
       m_Matchers({
           // clang-format off
-          Match{"getDebug", [this](){ return fmt::format("{}", debugValue); }},
-          Match{"setDebug", [this](double value){ debugValue = value; return ACK; }},
-
-          Match{"cmdConnect", [this](){ return (this->m_RegatronComm->connect()) ? ACK : NACK; }},
-          Match{"cmdDisconnect", [this](){ this->m_RegatronComm->disconnect(); return ACK;}},
-          Match{"getCommStatus", [this](){ return fmt::format("{}", this->m_RegatronComm->getCommStatus()); }},
-          Match{"getAutoReconnect", [this](){ return fmt::format("{}", static_cast<int>(this->m_RegatronComm->getAutoReconnect())); }},
+          Match{"getDebug", [](Response &r){ fmt::format_to(std::back_inserter(r), "{}", static_cast<double>(debugValue)); }},
+          Match{"setDebug", [](double value){ debugValue = value; return ACK; }},
+
+          Match{"cmdConnect", [this](Response &r){ this->m_Reconnector.reconnect(); Append(r, ACK); }},
+          Match{"cmdDisconnect", [this](Response &r){ this->m_Acquisition.invalidate(); this->m_RegatronComm->disconnect(); Append(r, ACK); }},
+          Match{"getCommStatus", [this](Response &r){ fmt::format_to(std::back_inserter(r), "{}", this->m_RegatronComm->getCommStatus()); }},
+          Match{"getConnectionState", [this](Response &r){ fmt::format_to(std::back_inserter(r), "{}", static_cast<int>(this->m_RegatronComm->getConnectionState())); }},
+          Match{"getConnectTimes", [this](Response &r){ const auto times = this->m_RegatronComm->GetConnectTimes(); fmt::format_to(std::back_inserter(r), "[{},{},{},{}]", times.open, times.wait, times.search, times.initialize); }},
+          Match{"getSearchProgress", [this](Response &r){ fmt::format_to(std::back_inserter(r), "{}", this->m_RegatronComm->getSearchProgress()); }},
+          Match{"getIdentityLoaded", [this](Response &r){ const auto loaded = this->m_RegatronComm->getIdentityLoaded(); r.push_back('['); for (std::size_t field = 0; field < IDENTITY_FIELDS; field++) { fmt::format_to(std::back_inserter(r), field == 0 ? "{}" : ",{}", (loaded >> field) & 1U); } r.push_back(']'); }},
+          Match{"getLinkStats", [this](Response &r){ const auto stats = this->m_RegatronComm->getLinkStats(); fmt::format_to(std::back_inserter(r), "[{},{},{},{},{},{},{}]", stats.p50, stats.p90, stats.p99, stats.samples, stats.timeouts, stats.multiplier, stats.talkQueue); }},
+          Match{"getAutoReconnect", [this](Response &r){ fmt::format_to(std::back_inserter(r), "{}", static_cast<int>(this->m_RegatronComm->getAutoReconnect())); }},
           Match{"setAutoReconnect", [this](float autoReconnect){ this->m_RegatronComm->setAutoReconnect(autoReconnect != 0); return ACK; }},
-
-          Match{"getFlashErrorHistory",         GET_FUNC(GetFlashErrorHistoryEntries())},
+          Match{"getSelectorStats", [](Response &r){ const auto stats = DeviceAccessControl::GetSelectorStats(); fmt::format_to(std::back_inserter(r), "[{},{}]", stats.writes, stats.skipped); }},
+          Match{"getHistory", [this](std::string_view argument, Response &r){ const auto history = ParseHistory(argument); return history && this->m_Acquisition.formatHistory(r, history->channel, history->window, history->decimation); }},
+          Match{"getTreeSince", [this](std::string_view argument, Response &r){ uint64_t generation{0}; return std::from_chars(argument.data(), argument.data() + argument.size(), generation).ec == std::errc{} && this->m_Acquisition.formatTreesSince(r, generation); }},
+          Match{"getScopeWaveform", [this](std::string_view argument, Response &r){ return argument.empty() && this->readScopeWaveform(r, false); }, [this](Response &r){ return this->readScopeWaveform(r, true); }},
+          Match{"getCommandTable", [this](Response &r){ r.push_back('['); for (std::size_t id = 0; id < this->m_Matchers.size(); id++) { fmt::format_to(std::back_inserter(r), id == 0 ? "{}" : ",{}", this->m_Matchers[id].name()); } r.push_back(']'); }},
+          Match{"getReadingsAge", [this](Response &r){ fmt::format_to(std::back_inserter(r), "[{},{}]", this->m_Acquisition.fastAge().value_or(std::chrono::milliseconds{-1}).count(), this->m_Acquisition.slowAge().value_or(std::chrono::milliseconds{-1}).count()); }},
+
+          Match{"getFlashErrorHistory",         [this](std::string_view argument, Response &r){ const auto page = ParseFlashHistoryPage(argument); auto readings = this->m_RegatronComm->getReadings(); if (!page || !readings) { return false; } if (page->count == 0) { readings.value()->GetFlashErrorHistoryEntries(r); } else { readings.value()->GetFlashErrorHistoryEntries(r, page->since, page->count); } return true; }},
           Match{"setFlashErrorHistoryMax",      SET_FUNC_UINT(SetFlashErrorHistoryMaxEntries)},
           Match{"getFlashErrorHistoryMax",      GET_FORMAT(GetFlashErrorHistoryMaxEntries())},
           Match{"getOperatingSeconds",          GET_FORMAT(GetOperatingSeconds())},
@@ -73,23 +340,23 @@ Handler::Handler(std::shared_ptr<Regatron::Comm> regatronComm)
           // Simple readings
           Match{"getModuleID",                  GET_FORMAT(getModuleID())},
 
-          Match{"getDSPID",                     GET_FUNC(getVersion().m_DeviceDSPID)},
-          Match{"getDSPVersion",                GET_FUNC(getVersion().m_DSPVersionString)},
+          Match{"getDSPID",                     GET_FUNC(getDSPID())},
+          Match{"getDSPVersion",                GET_FUNC(getDSPVersion())},
           Match{"getDLLVersion",                GET_FUNC(getVersion().m_DLLVersionString)},
-          Match{"getPLDVersion",                GET_FUNC(getVersion().m_PLDVersionString)},
-          Match{"getIBCVersion",                GET_FUNC(getVersion().m_IBCVersionString)},
-          Match{"getBootloaderVersion",         GET_FUNC(getVersion().m_BootloaderVersionString)},
+          Match{"getPLDVersion",                GET_FUNC(getPLDVersion())},
+          Match{"getIBCVersion",                GET_FUNC(getIBCVersion())},
+          Match{"getBootloaderVersion",         GET_FUNC(getBootloaderVersion())},
 
-          Match{"getDCLinkVoltage",             GET_FUNC(getDCLinkVoltage())},
-          Match{"getPrimaryCurrent",            GET_FUNC(getPrimaryCurrent())},
+          Match{"getDCLinkVoltage",             GET_FUNC(getDCLinkVoltage()),   CACHED(slow, fmt::format_to(std::back_inserter(response), "{}", snapshot->dcLinkVoltage)), ENCODED(slow, Binary::EncodeF64(response, snapshot->dcLinkVoltage))},
+          Match{"getPrimaryCurrent",            GET_FUNC(getPrimaryCurrent()),  CACHED(slow, fmt::format_to(std::back_inserter(response), "{}", snapshot->primaryCurrent)), ENCODED(slow, Binary::EncodeF64(response, snapshot->primaryCurrent))},
 
           Match{"getControlInput",              GET_FUNC(getRemoteControlInput())},
 
           Match{"getModControlMode",            GET_FUNC(GetModuleStatus().GetControlModeString())},
           Match{"getModCurrentRef",             GET_FORMAT(GetModuleStatus().GetCurrentRef())},
-          Match{"getModMinMaxNom",              GET_FUNC(GetModuleStatus().GetMinMaxNomString())},
+          Match{"getModMinMaxNom",              GET_FUNC(getModMinMaxNom())},
           Match{"getModPowerRef",               GET_FORMAT(GetModuleStatus().GetPowerRef())},
-          Match{"getModReadings",               GET_FUNC(GetModuleStatus().GetReadingsString())},
+          Match{"getModReadings",               GET_FUNC(GetModuleStatus().GetReadingsString()), CACHED(fast, FormatReadings(response, snapshot->mod)), ENCODED(fast, Binary::EncodeSample(response, snapshot->mod))},
           Match{"getModResistanceRef",          GET_FORMAT(GetModuleStatus().GetResistanceRef())},
           Match{"getModVoltageRef",             GET_FORMAT(GetModuleStatus().GetVoltageRef())},
 
@@ -98,7 +365,7 @@ Handler::Handler(std::shared_ptr<Regatron::Comm> regatronComm)
           Match{"getSysMinMaxNom",              GET_FUNC(GetSystemStatus().GetMinMaxNomString())},
           Match{"getSysOutVoltEnable",          GET_FORMAT(GetSystemStatus().GetOutVoltEnable())},
           Match{"getSysPowerRef",               GET_FORMAT(GetSystemStatus().GetPowerRef())},
-          Match{"getSysReadings",               GET_FUNC(GetSystemStatus().GetReadingsString())},
+          Match{"getSysReadings",               GET_FUNC(GetSystemStatus().GetReadingsString()), CACHED(fast, FormatReadings(response, snapshot->sys)), ENCODED(fast, Binary::EncodeSample(response, snapshot->sys))},
           Match{"getSysResistanceRef",          GET_FORMAT(GetSystemStatus().GetResistanceRef())},
           Match{"getSysVoltageRef",             GET_FORMAT(GetSystemStatus().GetVoltageRef())},
           Match{"setSysCurrentRef",             SET_FUNC_DOUBLE(GetSystemStatus().SetCurrentRef)},
@@ -107,11 +374,19 @@ Handler::Handler(std::shared_ptr<Regatron::Comm> regatronComm)
           Match{"setSysResistanceRef",          SET_FUNC_DOUBLE(GetSystemStatus().SetResistanceRef)},
           Match{"setSysVoltageRef",             SET_FUNC_DOUBLE(GetSystemStatus().SetVoltageRef)},
 
-          Match{"getTemperatures",              GET_FUNC(getTemperatures())},
+          // Offline scope, see getScopeWaveform
+          Match{"setScopeChannels",             [this](std::string_view argument, Response &r){ const auto channels = ParseScopeChannels(argument); auto readings = this->m_RegatronComm->getReadings(); if (!channels || !readings) { return false; } readings.value()->GetOfflineScope().SetChannels(*channels); Append(r, ACK); return true; }},
+          Match{"setScopeTimeFactor",           SET_FUNC_UINT(GetOfflineScope().SetTimeFactor)},
+          Match{"setScopeControl",              SET_FUNC_UINT(GetOfflineScope().SetControl)},
+          Match{"getScopeStatus",               GET_FUNC(GetOfflineScope().GetStatus())},
+
+          Match{"getTemperatures",              GET_FUNC(getTemperatures()),    CACHED(slow, FormatTemperatures(response, snapshot->igbtTemp, snapshot->rectifierTemp, snapshot->pcbTemp)), ENCODED(slow, Binary::EncodeF64Array(response, {snapshot->igbtTemp, snapshot->rectifierTemp, snapshot->pcbTemp}))},
 
           // Error + Warning T_ErrorTree32
-          Match{"getModTree",                   GET_FUNC(getModTree())},
-          Match{"getSysTree",                   GET_FUNC(getSysTree())},
+          Match{"getModTree",                   GET_FUNC(getModTree()),         CACHED(slow, FormatErrorTree(response, snapshot->modTree)), ENCODED(slow, Binary::EncodeTree(response, snapshot->modTree))},
+          Match{"getSysTree",                   GET_FUNC(getSysTree()),         CACHED(slow, FormatErrorTree(response, snapshot->sysTree)), ENCODED(slow, Binary::EncodeTree(response, snapshot->sysTree))},
+          Match{"getModTreeCompact",            GET_FUNC(getModTreeCompact()),  CACHED(slow, FormatCompactTree(response, snapshot->modTree)), ENCODED(slow, Binary::EncodeTree(response, snapshot->modTree))},
+          Match{"getSysTreeCompact",            GET_FUNC(getSysTreeCompact()),  CACHED(slow, FormatCompactTree(response, snapshot->sysTree)), ENCODED(slow, Binary::EncodeTree(response, snapshot->sysTree))},
 
 
 
@@ -144,8 +419,39 @@ Handler::Handler(std::shared_ptr<Regatron::Comm> regatronComm)
           Match{"getSlopeCurrentSp",            GET_FORMAT(GetControllerSettings().GetSlopeCurrentSp())},
           // -------------------------------------------------------------------------------
           // clang-format on
-      }) {}
+      }),
+      m_Tagged([this](std::string_view message, Response &reply) {
+          handle(message, reply);
+          // "NACK" has no new line untagged
+          if (reply[reply.size() - 1] != '\n') {
+              reply.push_back('\n');
+          }
+      }) {
+    m_Commands.reserve(m_Matchers.size());
+    for (const auto &m : m_Matchers) {
+        if (!m_Commands.emplace(m.name(), &m).second) {
+            LOG_CRITICAL(R"(Duplicated command "{}")", m.name());
+        }
+    }
+    m_Acquisition.setListener([this](const Snapshot &snapshot) {
+        m_Subscriptions.publish(
+            snapshot, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          Acquisition::Clock::now().time_since_epoch())
+                          .count());
+    });
+    m_Reconnector.start();
+    m_Acquisition.start();
+    if (!sharedCommands.empty()) {
+        m_SharedCommands = std::make_unique<SharedCommandsServer>(
+            sharedCommands, m_Worker,
+            [this](Shared::Setpoint setpoint, double value) {
+                return applySetpoint(setpoint, value);
+            });
+    }
+}
 
+#undef CACHED
+#undef ENCODED
 #undef CMD_API
 #undef GET_FORMAT
 #undef GET_FUNC
@@ -153,18 +459,493 @@ Handler::Handler(std::shared_ptr<Regatron::Comm> regatronComm)
 #undef SET_FUNC_DOUBLE
 #undef SET_FUNC_UINT
 
-std::string Handler::handle(const std::string &message) {
-    try {
-        m_RegatronComm->autoConnect();
-        for (const auto &m : m_Matchers) {
-            if (auto response = m.handle(message)) {
-                return response.value();
+void Handler::shutdown() {
+    m_SharedCommands.reset();
+    m_Reconnector.stop();
+    m_Acquisition.stop();
+    m_RegatronComm->setAutoReconnect(false);
+    m_Worker.run(Priority::Control, TcioWorker::NO_DEADLINE,
+                 [this]() { m_RegatronComm->disconnect(); });
+    m_Worker.stop();
+    LOG_INFO("Device closed.");
+}
+
+void Handler::handle(std::string_view message, Response &response) {
+    if (message.starts_with(BATCH)) {
+        handleBatch(message, response);
+        return;
+    }
+    if (!handleMessage(message, response)) {
+        Append(response, NACK);
+    }
+}
+
+void Handler::handleSession(std::string_view message, Response &response,
+                            const std::shared_ptr<Net::Outbox> &outbox) {
+    if (message.starts_with(TAG)) {
+        handleTagged(message, response, outbox);
+        return;
+    }
+    const auto text =
+        message.substr(0, message.find_last_not_of(" \t\r\n") + 1);
+    const auto name = text.substr(0, text.find(' '));
+    if (name != SUBSCRIBE && name != UNSUBSCRIBE) {
+        handle(message, response);
+        return;
+    }
+    auto argument = text.substr(name.size());
+    argument.remove_prefix(
+        std::min(argument.find_first_not_of(' '), argument.size()));
+    if (!handleSubscription(name, argument, response, outbox)) {
+        Append(response, NACK);
+    }
+}
+
+void Handler::handleTagged(std::string_view message, Response &response,
+                           const std::shared_ptr<Net::Outbox> &outbox) {
+    message = message.substr(0, message.find_last_not_of(" \t\r\n") + 1);
+    const auto tag     = message.substr(0, message.find(' '));
+    auto       request = message.substr(tag.size());
+    request.remove_prefix(
+        std::min(request.find_first_not_of(' '), request.size()));
+    if (!IsTag(tag) || request.empty() || request.starts_with(TAG)) {
+        Append(response, NACK);
+        return;
+    }
+
+    // In line when the device is not needed, the reply keeps its place
+    const auto mark = response.size();
+    fmt::format_to(std::back_inserter(response), "{} ", tag);
+    const auto              name = CommandName(request);
+    std::optional<Priority> queued;
+    if (request.starts_with(BATCH)) {
+        queued = BatchPriority(request);
+    } else if (name == SUBSCRIBE || name == UNSUBSCRIBE) {
+        handleSession(request, response, outbox);
+    } else {
+        const auto parsed  = parseMessage(request);
+        const auto handled = handleAtOnce(parsed, response);
+        if (!handled) {
+            queued = PriorityOf(parsed.name, parsed.argument);
+        } else if (!*handled) {
+            Append(response, NACK);
+        }
+    }
+    if (!queued) {
+        // "NACK" has no new line untagged
+        if (response[response.size() - 1] != '\n') {
+            response.push_back('\n');
+        }
+        return;
+    }
+
+    // Answered through the outbox once the TCIO worker is done
+    response.resize(mark);
+    if (!m_Tagged.post(*queued, tag, request, outbox)) {
+        LOG_WARN(R"(Tagged request "{}" refused, "{}" pending.)", tag,
+                 m_Tagged.pending());
+        fmt::format_to(std::back_inserter(response), "{} {}\n", tag, NACK);
+    }
+}
+
+bool Handler::handleFrame(std::string_view payload, Response &response) {
+    const auto request = Binary::DecodeRequest(payload);
+    if (!request) {
+        return false;
+    }
+    const auto reply = [&response, &request](Binary::Status status) {
+        Binary::EncodeReplyHeader(response, request->command, request->id,
+                                  status);
+    };
+    if (request->command >= m_Matchers.size() ||
+        (request->type != Binary::Type::None &&
+         request->type != Binary::Type::F64 &&
+         request->type != Binary::Type::String)) {
+        reply(Binary::Status::Invalid);
+        Binary::EncodeNone(response);
+        return true;
+    }
+    const auto &command = m_Matchers[request->command];
+    const bool  fresh   = (request->flags & Binary::FRESH) != 0;
+
+    // Snapshot readings, nothing formatted nor parsed on the way
+    if (!fresh && request->type == Binary::Type::None) {
+        const auto mark = response.size();
+        reply(m_RegatronComm->getConnectionState() == ConnectionState::Ok
+                  ? Binary::Status::Ok
+                  : Binary::Status::Stale);
+        if (command.handleEncoded(response)) {
+            return true;
+        }
+        response.resize(mark);
+    }
+
+    // The same text message otherwise, reused by every frame of the thread
+    thread_local std::string message;
+    thread_local Response    text;
+    message.clear();
+    text.clear();
+    if (fresh) {
+        fmt::format_to(std::back_inserter(message), "{} ", FRESH);
+    }
+    message.append(command.name());
+    if (request->type == Binary::Type::F64) {
+        fmt::format_to(std::back_inserter(message), " {}", request->number);
+    } else if (request->type == Binary::Type::String) {
+        message.push_back(' ');
+        message.append(request->text);
+    }
+    if (!handleMessage(message, text)) {
+        reply(Binary::Status::Nack);
+        Binary::EncodeNone(response);
+        return true;
+    }
+
+    // "<command> <value>[ STALE]\n"
+    std::string_view value{text.data(), text.size()};
+    value.remove_prefix(std::min(command.name().size() + 1, value.size()));
+    if (value.ends_with('\n')) {
+        value.remove_suffix(1); // the terminator only, a value may end in 0x0A
+    }
+    auto                   status = Binary::Status::Ok;
+    const std::string_view stale{STALE};
+    if (value.size() > stale.size() && value.ends_with(stale) &&
+        value[value.size() - stale.size() - 1] == ' ') {
+        status = Binary::Status::Stale;
+        value.remove_suffix(stale.size() + 1);
+    }
+    if (value == UNAVAILABLE || value == NACK) {
+        reply(value == NACK ? Binary::Status::Nack
+                            : Binary::Status::Unavailable);
+        Binary::EncodeNone(response);
+    } else if (value == ACK) {
+        reply(status);
+        Binary::EncodeNone(response);
+    } else {
+        reply(status);
+        Binary::EncodeString(response, value);
+    }
+    return true;
+}
+
+bool Handler::handleSubscription(std::string_view name,
+                                 std::string_view argument,
+                                 Response &       response,
+                                 const std::shared_ptr<Net::Outbox> &outbox) {
+    if (name == UNSUBSCRIBE) {
+        uint64_t id{0};
+        if (argument.empty()) {
+            m_Subscriptions.removeAll(outbox);
+        } else if (std::from_chars(argument.data(),
+                                   argument.data() + argument.size(), id)
+                           .ec != std::errc{} ||
+                   !m_Subscriptions.remove(id, outbox)) {
+            return false;
+        }
+        fmt::format_to(std::back_inserter(response), "{} {}\n", UNSUBSCRIBE,
+                       ACK);
+        return true;
+    }
+
+    // Served from the acquisition only, every channel has to be polled
+    auto request = ParseSubscription(argument);
+    if (!request ||
+        !std::all_of(request->channels.begin(), request->channels.end(),
+                     [this](Channel channel) {
+                         return m_Acquisition.acquires(channel);
+                     })) {
+        return false;
+    }
+    const auto id = m_Subscriptions.add(std::move(*request), outbox);
+    fmt::format_to(std::back_inserter(response), "{} {}\n", SUBSCRIBE, id);
+    return true;
+}
+
+void Handler::handleBatch(std::string_view message, Response &response) {
+    // Reused by every batch handled on this thread
+    thread_local std::vector<std::string_view> items;
+    thread_local std::vector<Response>         replies;
+    items.clear();
+
+    message.remove_prefix(std::string_view{BATCH}.size());
+    while (!message.empty() &&
+           (message.back() == '\n' || message.back() == '\r')) {
+        message.remove_suffix(1);
+    }
+    while (!message.empty()) {
+        const auto       end  = message.find(BATCH_SEPARATOR);
+        std::string_view item = message.substr(0, end);
+        message.remove_prefix(end == std::string_view::npos ? message.size()
+                                                            : end + 1);
+
+        item.remove_prefix(std::min(item.find_first_not_of(' '), item.size()));
+        item.remove_suffix(item.size() - (item.find_last_not_of(' ') + 1));
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    if (replies.size() < items.size()) {
+        replies.resize(items.size());
+    }
+
+    // Every item is handled on its own, a failure only affects its reply
+    const auto handleItem = [this](std::string_view item, Response &reply) {
+        reply.clear();
+        if (CommandName(item) != SCOPE_WAVEFORM &&
+            handleMessage(item, reply)) {
+            reply.resize(reply.size() - 1); // '\n'
+        } else {
+            fmt::format_to(std::back_inserter(reply), "{} {}",
+                           item.substr(0, item.find(' ')), NACK);
+        }
+    };
+
+    // Reads do not change the device state, within every run of reads the
+    // module reads are handled first so the selector changes at most twice.
+    std::size_t runBegin = 0;
+    for (std::size_t i = 0; i <= items.size(); i++) {
+        if (i < items.size() && IsRead(items[i])) {
+            continue;
+        }
+        for (std::size_t r = runBegin; r < i; r++) {
+            if (IsModuleRead(items[r])) {
+                handleItem(items[r], replies[r]);
             }
         }
+        for (std::size_t r = runBegin; r < i; r++) {
+            if (!IsModuleRead(items[r])) {
+                handleItem(items[r], replies[r]);
+            }
+        }
+        if (i < items.size()) {
+            handleItem(items[i], replies[i]);
+        }
+        runBegin = i + 1;
+    }
 
+    // Replies keep the request order
+    Append(response, BATCH);
+    for (std::size_t i = 0; i < items.size(); i++) {
+        if (i != 0) {
+            response.push_back(BATCH_SEPARATOR);
+        }
+        response.append(replies[i].data(),
+                        replies[i].data() + replies[i].size());
+    }
+    response.push_back('\n');
+}
+
+bool Handler::handleMessage(std::string_view message, Response &response) {
+    const auto parsed = parseMessage(message);
+    if (const auto handled = handleAtOnce(parsed, response)) {
+        return *handled;
+    }
+    return handleQueued(parsed, response);
+}
+
+Handler::ParsedMessage Handler::parseMessage(std::string_view message) const {
+    // "[fresh ]<command>[ <argument>]\n" is split once, the command is found
+    // by name
+    ParsedMessage parsed;
+    parsed.text = message.substr(0, message.find_last_not_of(" \t\r\n") + 1);
+    const auto split = [&parsed](std::string_view text) {
+        const auto nameEnd = text.find(' ');
+        parsed.name        = text.substr(0, nameEnd);
+        parsed.argument    = {};
+        if (nameEnd != std::string_view::npos) {
+            parsed.argument = text.substr(nameEnd + 1);
+            parsed.argument.remove_prefix(
+                std::min(parsed.argument.find_first_not_of(' '),
+                         parsed.argument.size()));
+        }
+    };
+    split(parsed.text);
+    parsed.fresh = parsed.name == FRESH;
+    if (parsed.fresh) {
+        split(parsed.argument);
+    }
+
+    const auto command = m_Commands.find(parsed.name);
+    if (command != m_Commands.end()) {
+        parsed.command = command->second;
+    }
+    return parsed;
+}
+
+std::optional<bool> Handler::handleAtOnce(const ParsedMessage &message,
+                                          Response &           response) {
+    if (message.command == nullptr) {
         // Default not found message
+        LOG_WARN(R"(No match for message "{}")", message.text);
+        return false;
+    }
+
+    if (IsLocal(message.name)) {
+        return message.command->handle(message.argument, response);
+    }
+
+    // Snapshot readings do not need the device, while disconnected the last
+    // ones are kept and marked
+    const bool connected =
+        m_RegatronComm->getConnectionState() == ConnectionState::Ok;
+    if (!message.fresh &&
+        message.command->handleCached(message.argument, response)) {
+        if (!connected) {
+            response.resize(response.size() - 1); // '\n'
+            fmt::format_to(std::back_inserter(response), " {}\n", STALE);
+        }
+        return true;
+    }
+
+    // Fail at once, the Reconnector brings the connection back
+    if (!connected && message.name != DISCONNECT) {
+        fmt::format_to(std::back_inserter(response), "{} {}\n", message.name,
+                       UNAVAILABLE);
+        return true;
+    }
+    return {};
+}
+
+bool Handler::handleQueued(const ParsedMessage &message, Response &response) {
+    // A failed command must not leave a partial response behind
+    const auto mark     = response.size();
+    const auto priority = PriorityOf(message.name, message.argument);
+    bool       handled  = false;
+    if (message.name == SCOPE_WAVEFORM) {
+        // Queues its own Background jobs, the worker is not held for the read
+        handled = message.command->handle(message.argument, response);
+        if (!handled) {
+            response.resize(mark);
+        }
+        return handled;
+    }
+    const auto started  = m_Worker.run(
+        priority, DEADLINES[static_cast<std::size_t>(priority)], [&]() {
+            handled = handleDevice(*message.command, message.name,
+                                   message.argument, message.text, response);
+        });
+    if (!started) {
+        LOG_ERROR(R"(TCIO worker busy, message "{}" was not handled)",
+                  message.text);
+    }
+    if (!handled) {
+        response.resize(mark);
+    }
+    return handled;
+}
+
+bool Handler::readScopeWaveform(Response &response, bool encoded) {
+    // One client at a time, the capture is read back into the Readings
+    std::unique_lock<std::mutex> scope(m_ScopeMutex, std::try_to_lock);
+    if (!scope.owns_lock()) {
+        return false;
+    }
+
+    // Background jobs of a few calls each, control and monitor jobs run in
+    // between
+    const auto step = [this](auto &&job) {
+        bool       done    = false;
+        const auto started = m_Worker.run(
+            Priority::Background,
+            DEADLINES[static_cast<std::size_t>(Priority::Background)], [&]() {
+                auto readings = m_RegatronComm->getReadings();
+                if (m_RegatronComm->getConnectionState() !=
+                        ConnectionState::Ok ||
+                    !readings) {
+                    return;
+                }
+                try {
+                    job(readings.value()->GetOfflineScope());
+                    done = true;
+                } catch (const CommException &e) {
+                    LOG_CRITICAL(
+                        R"(CommException: Regatron communication exception "{}" reading the offline scope. Device TCIO will be closed.)",
+                        e.what());
+                    m_Acquisition.invalidate();
+                    m_RegatronComm->disconnect();
+                }
+            });
+        return started && done;
+    };
+
+    bool more = true;
+    if (!step([](OfflineScope &offlineScope) { offlineScope.BeginRead(); })) {
+        return false;
+    }
+    while (more) {
+        if (!step([&more](OfflineScope &offlineScope) {
+                more = offlineScope.ReadBlocks(SCOPE_CALLS_PER_JOB);
+            })) {
+            return false;
+        }
+    }
+    return step([&response, encoded](OfflineScope &offlineScope) {
+        if (encoded) {
+            Binary::EncodeWaveform(response, offlineScope.GetWaveform());
+        } else {
+            FormatWaveform(response, offlineScope.GetWaveform());
+        }
+    });
+}
+
+Shared::CommandStatus Handler::applySetpoint(Shared::Setpoint setpoint,
+                                             double           value) {
+    // getReadings logs an error while disconnected, ask the state first
+    if (m_RegatronComm->getConnectionState() != ConnectionState::Ok) {
+        return Shared::CommandStatus::Unavailable;
+    }
+    auto readings = m_RegatronComm->getReadings();
+    if (!readings) {
+        return Shared::CommandStatus::Unavailable;
+    }
+    // Same device calls as the setSys<Setpoint>Ref commands
+    auto &system = readings.value()->GetSystemStatus();
+    if (!InPhysRange(system.GetPhys(), setpoint, value)) {
+        return Shared::CommandStatus::OutOfRange;
+    }
+    try {
+        switch (setpoint) {
+        case Shared::Setpoint::Voltage:
+            system.SetVoltageRef(value);
+            break;
+        case Shared::Setpoint::Current:
+            system.SetCurrentRef(value);
+            break;
+        case Shared::Setpoint::Power:
+            system.SetPowerRef(value);
+            break;
+        case Shared::Setpoint::Resistance:
+            system.SetResistanceRef(value);
+            break;
+        }
+        return Shared::CommandStatus::Applied;
+    } catch (const CommException &e) {
+        LOG_CRITICAL(
+            R"(CommException: Regatron communication exception "{}" writing a shared memory setpoint. Device TCIO will be closed.)",
+            e.what());
+        m_Acquisition.invalidate();
+        m_RegatronComm->disconnect();
+    }
+    return Shared::CommandStatus::Failed;
+}
+
+bool Handler::handleDevice(const Match &command, std::string_view name,
+                           std::string_view argument, std::string_view message,
+                           Response &response) {
+    try {
+        // Module commands select the module themselves, everything else
+        // expects the system, no selector write when it already is.
+        if (!IsModuleCommand(name) &&
+            m_RegatronComm->getConnectionState() == ConnectionState::Ok) {
+            DeviceAccessControl::SelectSys();
+        }
+
+        if (command.handle(argument, response)) {
+            return true;
+        }
+
         LOG_WARN(R"(No match for message "{}")", message);
-        return NACK;
+        return false;
 
     } catch (const CommException &e) {
         LOG_CRITICAL(
@@ -177,6 +958,7 @@ std::string Handler::handle(const std::string &message) {
         LOG_CRITICAL(R"(Device TCIO will be closed, comm status "{}")", m_RegatronComm->getCommStatus());
 
         // Reset communication and DLL
+        m_Acquisition.invalidate();
         m_RegatronComm->disconnect();
 
     } catch (const std::invalid_argument &e) {
@@ -189,6 +971,6 @@ std::string Handler::handle(const std::string &message) {
             R"(Runtime Error: Unexpected runtime error "{}" when handling message "{}")",
             e.what(), message);
     }
-    return NACK;
+    return false;
 }
 } // namespace Regatron
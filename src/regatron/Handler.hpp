@@ -3,28 +3,145 @@
 #include "log/Logger.hpp"
 #include "net/Handler.hpp"
 
+#include "regatron/Acquisition.hpp"
+#include "regatron/Binary.hpp"
 #include "regatron/Comm.hpp"
 #include "regatron/Match.hpp"
+#include "regatron/Reconnector.hpp"
 #include "regatron/Regatron.hpp"
+#include "regatron/SharedCommandsServer.hpp"
+#include "regatron/Subscriptions.hpp"
+#include "regatron/TaggedRequests.hpp"
+#include "regatron/TcioWorker.hpp"
 
 #include <array>
 #include <chrono>
+#include <cmath>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 
 namespace Regatron {
 constexpr const char* NACK = "NACK";
 constexpr const char* ACK = "ACK";
+/** Device command while the connection is not Ok, see Reconnector */
+constexpr const char* UNAVAILABLE = "UNAVAILABLE";
+/** Appended to a cached reading kept from a lost connection */
+constexpr const char* STALE = "STALE";
+
+/** "batch cmd1;cmd2 arg;...\n" -> "batch response1;response2;...\n" */
+constexpr const char* BATCH           = "batch ";
+constexpr char        BATCH_SEPARATOR = ';';
+
+/** "fresh getSysReadings\n" skips the acquisition snapshot */
+constexpr const char* FRESH = "fresh";
+
+/**
+ * "#<digits> <message>\n" -> "#<digits> <response>\n", out of order: at
+ * once when the device is not needed, otherwise through the session outbox
+ * once the TCIO worker is done, see TaggedRequests
+ * */
+constexpr char TAG = '#';
+
+/**
+ * "subscribe <channels> <period_ms> [deadband]\n" -> "subscribe <id>\n",
+ * "unsubscribe [id]\n" -> "unsubscribe ACK\n", see Subscriptions
+ * */
+constexpr std::string_view SUBSCRIBE   = "subscribe";
+constexpr std::string_view UNSUBSCRIBE = "unsubscribe";
 
 class Handler : public Net::Handler {
   public:
-    Handler(std::shared_ptr<Regatron::Comm> regatronComm);
+    /**
+     * @param sharedCommands: shared memory segment name of the setpoint
+     * commands, empty disables, see SharedCommandsServer
+     * */
+    Handler(std::shared_ptr<Regatron::Comm> regatronComm,
+            AcquisitionConfig               acquisitionConfig = {},
+            const std::string &             sharedCommands    = {});
     ~Handler() = default;
 
+    /**
+     * Stops every thread using the device, then closes it in the last job of
+     * the TCIO worker. Requests fail from then on. From the main thread, not
+     * from a signal handler.
+     * */
+    void shutdown();
+
   private:
     std::shared_ptr<Regatron::Comm> m_RegatronComm;
+    TcioWorker                      m_Worker; /** owns every TCIO call */
+    Reconnector                     m_Reconnector;
+    Subscriptions                   m_Subscriptions; /** fed by m_Acquisition */
+    Acquisition                     m_Acquisition;
     std::vector<Match>              m_Matchers;
-    std::string                     handle(const std::string &message) override;
+    /** Command name -> m_Matchers entry, m_Matchers must not change. */
+    std::unordered_map<std::string_view, const Match *> m_Commands;
+    std::mutex m_ScopeMutex; /** getScopeWaveform in progress */
+    /** Stopped before anything its requests use */
+    TaggedRequests m_Tagged;
+    /** Last, stopped before anything it uses */
+    std::unique_ptr<SharedCommandsServer> m_SharedCommands;
+
+    void handle(std::string_view message, Response &response) override;
+    void handleSession(std::string_view message, Response &response,
+                       const std::shared_ptr<Net::Outbox> &outbox) override;
+    [[nodiscard]] bool acceptsFrames() const override { return true; }
+    /**
+     * Binary protocol, see Binary. Snapshot readings are answered with typed
+     * values, every other command goes through handleMessage and answers
+     * the text reply value as a string.
+     * */
+    bool handleFrame(std::string_view payload, Response &response) override;
+    /** "#<tag> <message>", see TAG */
+    void handleTagged(std::string_view message, Response &response,
+                      const std::shared_ptr<Net::Outbox> &outbox);
+    /** @return: false when the message fails */
+    bool handleSubscription(std::string_view name, std::string_view argument,
+                            Response &                          response,
+                            const std::shared_ptr<Net::Outbox> &outbox);
+
+    /**
+     * @return: false when the message fails or has no match, nothing is
+     * appended to the response in that case. A device command while not
+     * connected is answered "<command> UNAVAILABLE".
+     * */
+    bool handleMessage(std::string_view message, Response &response);
+    /** "[fresh ]<command>[ <argument>]", split once */
+    struct ParsedMessage {
+        std::string_view text; /** without the trailing new line */
+        std::string_view name;
+        std::string_view argument;
+        bool             fresh   = false;
+        const Match *    command = nullptr; /** nullptr: no match */
+    };
+    [[nodiscard]] ParsedMessage parseMessage(std::string_view message) const;
+    /**
+     * Local commands, snapshot readings and commands failing at once.
+     * @return: nullopt when the device is needed, nothing appended then
+     * */
+    std::optional<bool> handleAtOnce(const ParsedMessage &message,
+                                     Response &           response);
+    /** Waits for the TCIO worker, see handleMessage */
+    bool handleQueued(const ParsedMessage &message, Response &response);
+    /** Device part of handleMessage, on the worker thread */
+    bool handleDevice(const Match &command, std::string_view name,
+                      std::string_view argument, std::string_view message,
+                      Response &response);
+    void handleBatch(std::string_view message, Response &response);
+    /**
+     * getScopeWaveform: reads the offline scope capture back, see
+     * FormatWaveform, or Binary::EncodeWaveform when encoded.
+     * @return: false when not connected, the read back failed or another one
+     * is in progress
+     * */
+    bool readScopeWaveform(Response &response, bool encoded);
+    /** Shared memory setpoint command, on the worker thread */
+    Shared::CommandStatus applySetpoint(Shared::Setpoint setpoint,
+                                        double           value);
 };
 } // namespace Regatron
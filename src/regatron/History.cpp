@@ -0,0 +1,130 @@
+#include "History.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+namespace Regatron {
+
+namespace {
+constexpr int64_t NANOSECONDS_PER_MS = 1000000;
+
+std::array<double, FAST_CHANNELS> FastValues(const Snapshot &snapshot) {
+    return {snapshot.sys.voltage,
+            snapshot.sys.current,
+            snapshot.sys.power,
+            snapshot.sys.resistance,
+            static_cast<double>(snapshot.sys.state),
+            snapshot.mod.voltage,
+            snapshot.mod.current,
+            snapshot.mod.power,
+            snapshot.mod.resistance,
+            static_cast<double>(snapshot.mod.state)};
+}
+
+std::array<double, CHANNELS - FAST_CHANNELS>
+SlowValues(const Snapshot &snapshot) {
+    return {snapshot.igbtTemp, snapshot.rectifierTemp, snapshot.pcbTemp,
+            snapshot.dcLinkVoltage, snapshot.primaryCurrent};
+}
+} // namespace
+
+std::optional<Channel> ParseChannel(std::string_view name) {
+    const auto found =
+        std::find(CHANNEL_NAMES.begin(), CHANNEL_NAMES.end(), name);
+    if (found == CHANNEL_NAMES.end()) {
+        return {};
+    }
+    return static_cast<Channel>(std::distance(CHANNEL_NAMES.begin(), found));
+}
+
+double ChannelValue(const Snapshot &snapshot, Channel channel) {
+    const auto index = static_cast<std::size_t>(channel);
+    return index < FAST_CHANNELS ? FastValues(snapshot)[index]
+                                 : SlowValues(snapshot)[index - FAST_CHANNELS];
+}
+
+History::History(std::size_t depth) : m_Depth(depth) {
+    // Allocated once, append never allocates
+    m_Fast.times.resize(depth);
+    m_Fast.values.resize(FAST_CHANNELS, std::vector<double>(depth));
+    m_Slow.times.resize(depth);
+    m_Slow.values.resize(CHANNELS - FAST_CHANNELS, std::vector<double>(depth));
+}
+
+void History::append(const Snapshot &snapshot, bool fast, bool slow) {
+    if (m_Depth == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (fast) {
+        push(m_Fast, snapshot.fastTime, FastValues(snapshot).data());
+    }
+    if (slow) {
+        push(m_Slow, snapshot.slowTime, SlowValues(snapshot).data());
+    }
+}
+
+void History::push(Ring &ring, int64_t time, const double *values) {
+    ring.times[ring.next] = time;
+    for (std::size_t channel = 0; channel < ring.values.size(); channel++) {
+        ring.values[channel][ring.next] = values[channel];
+    }
+    ring.next = (ring.next + 1) % m_Depth;
+    ring.size = std::min(ring.size + 1, m_Depth);
+}
+
+std::vector<HistoryPoint> History::query(Channel channel, int64_t since,
+                                         std::size_t decimation) const {
+    std::vector<HistoryPoint> points;
+    if (m_Depth == 0) {
+        return points;
+    }
+    decimation        = std::max<std::size_t>(decimation, 1);
+    const auto index  = static_cast<std::size_t>(channel);
+    const bool isFast = index < FAST_CHANNELS;
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    const auto &ring   = isFast ? m_Fast : m_Slow;
+    const auto &values = ring.values[isFast ? index : index - FAST_CHANNELS];
+    const auto  oldest = (ring.next + m_Depth - ring.size) % m_Depth;
+
+    // Times only grow, the window starts at the first sample after since
+    std::size_t skip = 0;
+    while (skip < ring.size &&
+           ring.times[(oldest + skip) % m_Depth] < since) {
+        skip++;
+    }
+    const auto count = ring.size - skip;
+    points.reserve((count + decimation - 1) / decimation);
+    for (std::size_t i = 0; i < count; i++) {
+        const auto slot  = (oldest + skip + i) % m_Depth;
+        const auto value = values[slot];
+        if (i % decimation == 0) {
+            points.push_back({ring.times[slot], value, value});
+            continue;
+        }
+        auto &point = points.back();
+        point.time  = ring.times[slot];
+        point.min   = std::min(point.min, value);
+        point.max   = std::max(point.max, value);
+    }
+    return points;
+}
+
+void FormatHistory(fmt::memory_buffer &out,
+                   const std::vector<HistoryPoint> &points, bool decimated,
+                   int64_t now) {
+    auto it = std::back_inserter(out);
+    out.push_back('[');
+    for (std::size_t i = 0; i < points.size(); i++) {
+        const auto &point = points[i];
+        const auto  time  = (point.time - now) / NANOSECONDS_PER_MS;
+        it = fmt::format_to(it, i == 0 ? "{},{}" : ",{},{}", time, point.min);
+        if (decimated) {
+            it = fmt::format_to(it, ",{}", point.max);
+        }
+    }
+    out.push_back(']');
+}
+
+} // namespace Regatron
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "Snapshot.hpp"
+#include "fmt/format.h"
+
+namespace Regatron {
+
+/** Snapshot values kept by History, fast group first */
+enum class Channel : std::size_t {
+    SysVoltage,
+    SysCurrent,
+    SysPower,
+    SysResistance,
+    SysState,
+    ModVoltage,
+    ModCurrent,
+    ModPower,
+    ModResistance,
+    ModState,
+    // Slow group
+    IgbtTemp,
+    RectifierTemp,
+    PcbTemp,
+    DcLinkVoltage,
+    PrimaryCurrent
+};
+constexpr std::size_t CHANNELS      = 15;
+constexpr std::size_t FAST_CHANNELS = 10;
+
+/** getHistory channel names, by Channel */
+constexpr std::array<std::string_view, CHANNELS> CHANNEL_NAMES{
+    "sysVoltage",    "sysCurrent",     "sysPower",   "sysResistance",
+    "sysState",      "modVoltage",     "modCurrent", "modPower",
+    "modResistance", "modState",       "igbtTemp",   "rectifierTemp",
+    "pcbTemp",       "dcLinkVoltage",  "primaryCurrent"};
+
+/** @return: nullopt for an unknown name */
+std::optional<Channel> ParseChannel(std::string_view name);
+
+/** Value of a channel in the snapshot */
+double ChannelValue(const Snapshot &snapshot, Channel channel);
+
+/** Extremes of consecutive samples, a single sample has min == max */
+struct HistoryPoint {
+    int64_t time = 0; /** steady clock [ns] of the last sample */
+    double  min  = 0;
+    double  max  = 0;
+};
+
+/**
+ * Last samples of every channel, one ring buffer per acquisition group.
+ * Structure of arrays: the sample times and each channel are kept in arrays
+ * of their own, a query only walks the times and the channel asked for.
+ * Written by the acquisition, queried from any thread.
+ * */
+class History {
+  public:
+    /** @param depth: samples kept per group, 0 disables the history */
+    explicit History(std::size_t depth);
+
+    [[nodiscard]] bool enabled() const { return m_Depth != 0; }
+
+    /** Groups just read, at snapshot.fastTime and snapshot.slowTime */
+    void append(const Snapshot &snapshot, bool fast, bool slow);
+
+    /**
+     * @param since: steady clock [ns] of the oldest sample wanted
+     * @param decimation: samples per point, 1 keeps every sample
+     * @return: oldest first
+     * */
+    [[nodiscard]] std::vector<HistoryPoint>
+    query(Channel channel, int64_t since, std::size_t decimation) const;
+
+  private:
+    struct Ring {
+        std::vector<int64_t>             times;  /** [ns] */
+        std::vector<std::vector<double>> values; /** by channel */
+        std::size_t                      next = 0;
+        std::size_t                      size = 0;
+    };
+
+    void push(Ring &ring, int64_t time, const double *values);
+
+    const std::size_t  m_Depth;
+    mutable std::mutex m_Mutex;
+    Ring               m_Fast;
+    Ring               m_Slow;
+};
+
+/**
+ * "[time,value,...]" without decimation, "[time,min,max,...]" otherwise.
+ * @param now: steady clock [ns], times are in ms relative to it
+ * */
+void FormatHistory(fmt::memory_buffer &out,
+                   const std::vector<HistoryPoint> &points, bool decimated,
+                   int64_t now);
+
+} // namespace Regatron
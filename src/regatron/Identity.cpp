@@ -0,0 +1,152 @@
+#include "Identity.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+#include "fmt/format.h"
+#include "fmt/ranges.h"
+#include "log/Logger.hpp"
+
+namespace Regatron {
+
+namespace {
+/** Bumped when the file layout changes, older files are ignored */
+constexpr int FORMAT_VERSION = 1;
+
+std::string Format(const PhysValues &values) {
+    return fmt::format("{} {} {} {}", values.voltage, values.current,
+                       values.power, values.resistance);
+}
+
+bool Parse(std::istringstream &in, PhysValues &values) {
+    return static_cast<bool>(in >> values.voltage >> values.current >>
+                             values.power >> values.resistance);
+}
+
+template <typename T, std::size_t N>
+bool Parse(std::istringstream &in, std::array<T, N> &values) {
+    for (auto &value : values) {
+        if (!(in >> value)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename T> bool Parse(std::istringstream &in, T &value) {
+    return static_cast<bool>(in >> value);
+}
+
+bool Parse(std::istringstream &in, std::string &value) {
+    std::getline(in >> std::ws, value);
+    return !value.empty();
+}
+} // namespace
+
+IdentityCache::IdentityCache(std::string directory)
+    : m_Directory(std::move(directory)) {}
+
+std::string IdentityCache::path(unsigned long serialNr) const {
+    return (std::filesystem::path(m_Directory) /
+            fmt::format("{}.identity", serialNr))
+        .string();
+}
+
+std::optional<Identity> IdentityCache::load(unsigned long serialNr) const {
+    std::ifstream file(path(serialNr));
+    if (!file.is_open()) {
+        return {};
+    }
+
+    // "<key> <values>" lines
+    std::map<std::string, std::string> lines;
+    std::string                        line;
+    while (std::getline(file, line)) {
+        const auto separator = line.find(' ');
+        if (separator != std::string::npos) {
+            lines[line.substr(0, separator)] = line.substr(separator + 1);
+        }
+    }
+
+    Identity   identity;
+    int        version{0};
+    const auto field = [&lines](const std::string &key, auto &value) {
+        const auto found = lines.find(key);
+        if (found == lines.end()) {
+            return false;
+        }
+        std::istringstream in(found->second);
+        return Parse(in, value);
+    };
+    const bool valid =
+        field("version", version) && version == FORMAT_VERSION &&
+        field("serialNr", identity.serialNr) &&
+        identity.serialNr == serialNr &&
+        field("increments", identity.increments) &&
+        field("moduleId", identity.moduleId) &&
+        field("additional", identity.additional) &&
+        field("systemMin", identity.system.min) &&
+        field("systemMax", identity.system.max) &&
+        field("systemNom", identity.system.nom) &&
+        field("moduleMin", identity.module.min) &&
+        field("moduleMax", identity.module.max) &&
+        field("moduleNom", identity.module.nom) &&
+        field("dspId", identity.dspId) &&
+        field("dspVersion", identity.dspVersion) &&
+        field("bootloaderVersion", identity.bootloaderVersion) &&
+        field("pldVersion", identity.pldVersion) &&
+        field("ibcVersion", identity.ibcVersion);
+    if (!valid) {
+        LOG_WARN(R"(Ignoring the invalid identity cache "{}".)",
+                 path(serialNr));
+        return {};
+    }
+    return identity;
+}
+
+void IdentityCache::save(const Identity &identity) const {
+    const auto destination = path(identity.serialNr);
+    const auto temporary   = destination + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        file << fmt::format("version {}\n", FORMAT_VERSION)
+             << fmt::format("serialNr {}\n", identity.serialNr)
+             << fmt::format("increments {}\n",
+                            fmt::join(identity.increments, " "))
+             << fmt::format("moduleId {}\n", identity.moduleId)
+             << fmt::format("additional {}\n",
+                            fmt::join(identity.additional, " "))
+             << fmt::format("systemMin {}\n", Format(identity.system.min))
+             << fmt::format("systemMax {}\n", Format(identity.system.max))
+             << fmt::format("systemNom {}\n", Format(identity.system.nom))
+             << fmt::format("moduleMin {}\n", Format(identity.module.min))
+             << fmt::format("moduleMax {}\n", Format(identity.module.max))
+             << fmt::format("moduleNom {}\n", Format(identity.module.nom))
+             << fmt::format("dspId {}\n", identity.dspId)
+             << fmt::format("dspVersion {}\n", identity.dspVersion)
+             << fmt::format("bootloaderVersion {}\n",
+                            identity.bootloaderVersion)
+             << fmt::format("pldVersion {}\n", identity.pldVersion)
+             << fmt::format("ibcVersion {}\n", identity.ibcVersion);
+        if (!file) {
+            LOG_WARN(R"(Failed to write the identity cache "{}".)",
+                     temporary);
+            return;
+        }
+    }
+
+    // Readers never see a partial file
+    std::error_code error;
+    std::filesystem::rename(temporary, destination, error);
+    if (error) {
+        LOG_WARN(R"(Failed to write the identity cache "{}": {}.)",
+                 destination, error.message());
+        return;
+    }
+    LOG_INFO(R"(Identity of serial number "{}" saved to "{}".)",
+             identity.serialNr, destination);
+}
+
+} // namespace Regatron
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <optional>
+#include <string>
+
+#include "StatusReadings.hpp"
+
+namespace Regatron {
+
+/**
+ * Readings that only change with the unit or its firmware, read by
+ * Readings::Initialize on every connection.
+ * */
+struct Identity {
+    unsigned long serialNr = 0; /** TC4GetSerialNr */
+    /** TC4GetPhysicalValuesIncrement, device then system side */
+    std::array<double, 8> increments{};
+    unsigned int          moduleId = 0;
+    /** TC4GetAdditionalPhysicalValues: DC link, primary current and
+     * temperature nominal values */
+    std::array<int, 3> additional{};
+    PhysLimits         system; /** master only */
+    PhysLimits         module;
+    std::string        dspId;
+    std::string        dspVersion;
+    std::string        bootloaderVersion;
+    std::string        pldVersion;
+    std::string        ibcVersion;
+
+    bool operator==(const Identity &) const = default;
+};
+
+/**
+ * Identity of every unit seen, one "<serial number>.identity" text file per
+ * unit in a directory, so a reconnect skips the identity reads.
+ * */
+class IdentityCache {
+  public:
+    explicit IdentityCache(std::string directory);
+
+    /** @return: nullopt when the unit is not cached or the file is invalid */
+    [[nodiscard]] std::optional<Identity> load(unsigned long serialNr) const;
+    /** Failures are logged, the cache is only an optimization */
+    void save(const Identity &identity) const;
+
+  private:
+    [[nodiscard]] std::string path(unsigned long serialNr) const;
+
+    std::string m_Directory;
+};
+
+} // namespace Regatron
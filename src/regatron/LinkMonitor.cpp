@@ -0,0 +1,107 @@
+#include "LinkMonitor.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace Regatron {
+
+namespace {
+template <typename Window>
+std::vector<int64_t> Sorted(const Window &window, std::size_t samples) {
+    std::vector<int64_t> sorted(window.begin(), window.begin() + samples);
+    std::sort(sorted.begin(), sorted.end());
+    return sorted;
+}
+
+/** @param sorted: not empty */
+int64_t Percentile(const std::vector<int64_t> &sorted, std::size_t percent) {
+    return sorted[(sorted.size() - 1) * percent / 100];
+}
+} // namespace
+
+void LinkMonitor::onCall(DLL_RESULT                result,
+                         std::chrono::microseconds duration) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (result == DLL_SUCCESS) {
+        m_Window[m_Next] = duration.count();
+        m_Next           = (m_Next + 1) % WINDOW;
+        m_Samples        = std::min(m_Samples + 1, WINDOW);
+        m_RecentAnswers++;
+        return;
+    }
+
+    // A failure answered at once is not a timeout
+    if (m_Multiplier != 0 && duration >= timeout() / 2) {
+        m_Timeouts++;
+        m_RecentTimeouts++;
+    }
+}
+
+void LinkMonitor::setBounds(unsigned int min, unsigned int max) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Min = std::clamp(min, MULTIPLIER_MIN, MULTIPLIER_MAX);
+    m_Max = std::clamp(max, m_Min, MULTIPLIER_MAX);
+}
+
+void LinkMonitor::setMultiplier(unsigned int multiplier) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Multiplier = multiplier;
+}
+
+void LinkMonitor::reset() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Next           = 0;
+    m_Samples        = 0;
+    m_RecentAnswers  = 0;
+    m_RecentTimeouts = 0;
+    m_TalkQueue      = 0;
+}
+
+unsigned int LinkMonitor::tune(unsigned int talkQueue) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_TalkQueue = talkQueue;
+
+    auto target = m_Multiplier;
+    if (m_RecentTimeouts > 0 && m_RecentAnswers > 0) {
+        // Slow, not dead: the device answers, just not always in time
+        target = m_Multiplier * 2;
+    } else if (m_RecentTimeouts == 0 && m_Samples >= MIN_SAMPLES) {
+        const auto sorted = Sorted(m_Window, m_Samples);
+        const auto unit =
+            std::chrono::duration_cast<std::chrono::microseconds>(TIMEOUT_UNIT)
+                .count();
+        const auto fit = static_cast<unsigned int>(
+            (Percentile(sorted, 99) * SAFETY_FACTOR + unit - 1) / unit);
+        if (fit > target) {
+            target = fit;
+        } else if (talkQueue == 0) {
+            target = std::max(fit, target / 2);
+        }
+    }
+    m_RecentAnswers  = 0;
+    m_RecentTimeouts = 0;
+    return std::clamp(target, m_Min, m_Max);
+}
+
+LinkStats LinkMonitor::stats() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    LinkStats stats;
+    stats.samples    = m_Samples;
+    stats.timeouts   = m_Timeouts;
+    stats.multiplier = m_Multiplier;
+    stats.talkQueue  = m_TalkQueue;
+    if (m_Samples > 0) {
+        const auto sorted = Sorted(m_Window, m_Samples);
+        stats.p50         = Percentile(sorted, 50);
+        stats.p90         = Percentile(sorted, 90);
+        stats.p99         = Percentile(sorted, 99);
+    }
+    return stats;
+}
+
+std::chrono::microseconds LinkMonitor::timeout() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        TIMEOUT_UNIT * m_Multiplier);
+}
+
+} // namespace Regatron
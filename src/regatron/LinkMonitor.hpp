@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+#include "Tcio.hpp"
+
+namespace Regatron {
+
+/** Round trip time of the recent device calls and the timeout in use */
+struct LinkStats {
+    int64_t      p50        = 0; /** [us] */
+    int64_t      p90        = 0; /** [us] */
+    int64_t      p99        = 0; /** [us] */
+    std::size_t  samples    = 0; /** successful calls in the window */
+    uint64_t     timeouts   = 0; /** failed calls that waited the timeout */
+    unsigned int multiplier = 0; /** read and write timeout multiplier */
+    unsigned int talkQueue  = 0; /** last DllGetTalkQueueCount */
+};
+
+/**
+ * Follows the round trip time of every device call and fits the serial
+ * timeout multiplier to it, so a dead link is detected after a few round
+ * trips and a slow one is not taken for dead.
+ * tune() aims at SAFETY_FACTOR times the 99th percentile. It grows at once,
+ * doubling when calls time out while others still answer, and shrinks at
+ * most by half per call, not at all while TALK commands are queued in the
+ * DLL.
+ * */
+class LinkMonitor : public Tcio::Observer {
+  public:
+    /** Calls kept for the percentiles */
+    static constexpr std::size_t WINDOW = 256;
+    /** Calls needed before the timeout follows the percentiles */
+    static constexpr std::size_t MIN_SAMPLES = 32;
+    static constexpr int64_t     SAFETY_FACTOR = 4;
+    /**
+     * Call time allowed per unit of the multiplier: the library timeout is
+     * per byte, a scalar request/response exchange is about 16 bytes.
+     * */
+    static constexpr std::chrono::milliseconds TIMEOUT_UNIT{16};
+    /** DllSetCommTimeouts range */
+    static constexpr unsigned int MULTIPLIER_MIN = 1;
+    static constexpr unsigned int MULTIPLIER_MAX = 5000;
+
+    void onCall(DLL_RESULT                result,
+                std::chrono::microseconds duration) override;
+
+    /** Clamped to [MULTIPLIER_MIN, MULTIPLIER_MAX] */
+    void setBounds(unsigned int min, unsigned int max);
+    /** Multiplier set in the library */
+    void setMultiplier(unsigned int multiplier);
+    /** Start over, e.g. on a new connection */
+    void reset();
+
+    /**
+     * @param talkQueue: TALK commands queued in the DLL
+     * @return: multiplier fitting the calls since the last one, within the
+     * bounds
+     * */
+    [[nodiscard]] unsigned int tune(unsigned int talkQueue);
+    [[nodiscard]] LinkStats    stats() const;
+
+  private:
+    [[nodiscard]] std::chrono::microseconds timeout() const;
+
+    mutable std::mutex          m_Mutex;
+    std::array<int64_t, WINDOW> m_Window{}; /** [us], ring buffer */
+    std::size_t                 m_Next    = 0;
+    std::size_t                 m_Samples = 0;
+    uint64_t                    m_Timeouts{0};
+    uint64_t m_RecentAnswers{0};  /** successful calls since tune() */
+    uint64_t m_RecentTimeouts{0}; /** timed out calls since tune() */
+
+    unsigned int m_Multiplier = 0;
+    unsigned int m_Min        = MULTIPLIER_MIN;
+    unsigned int m_Max        = MULTIPLIER_MAX;
+    unsigned int m_TalkQueue  = 0;
+};
+
+} // namespace Regatron
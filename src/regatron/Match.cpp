@@ -2,64 +2,108 @@
 
 namespace Regatron {
 
-Match::Match(std::string &&commandString, std::string &&setFormat,
-             std::function<std::string()> &&      getHandle,
-             std::function<std::string(double)> &&setHandle)
-    : m_CommandString(commandString), m_SetFormat(setFormat),
-      m_GetPattern(fmt::format("{}\n", m_CommandString)),
-      m_SetPattern(fmt::format("{} {}\n", m_CommandString, m_SetFormat)),
-      m_GetHandleFunc(getHandle),
-      m_SetHandleFunc(setHandle) {
+Match::Match(std::string &&commandString, GetHandle &&getHandle,
+             SetHandle &&setHandle, CachedHandle &&cachedHandle,
+             QueryHandle &&queryHandle, EncodedHandle &&encodedHandle)
+    : m_CommandString(commandString), m_GetHandleFunc(getHandle),
+      m_SetHandleFunc(setHandle), m_CachedHandleFunc(cachedHandle),
+      m_QueryHandleFunc(queryHandle), m_EncodedHandleFunc(encodedHandle) {
     LOG_TRACE(toString());
 }
 
 /** @note: get only constructor */
-Match::Match(std::string &&                 commandString,
-             std::function<std::string()> &&getHandle)
-    : Match(std::move(commandString), "%lf", std::move(getHandle), nullptr) {}
+Match::Match(std::string &&commandString, GetHandle &&getHandle)
+    : Match(std::move(commandString), std::move(getHandle), nullptr,
+            nullptr, nullptr, nullptr) {}
 
 /** @note: set only constructor */
-Match::Match(std::string &&                       commandString,
-             std::function<std::string(double)> &&setHandle)
-    : Match(std::move(commandString), "%lf", nullptr, std::move(setHandle)) {}
+Match::Match(std::string &&commandString, SetHandle &&setHandle)
+    : Match(std::move(commandString), nullptr, std::move(setHandle),
+            nullptr, nullptr, nullptr) {}
+
+/** @note: get constructor, with a cached alternative */
+Match::Match(std::string &&commandString, GetHandle &&getHandle,
+             CachedHandle &&cachedHandle)
+    : Match(std::move(commandString), std::move(getHandle), nullptr,
+            std::move(cachedHandle), nullptr, nullptr) {}
+
+/** @note: get constructor, with cached text and binary alternatives */
+Match::Match(std::string &&commandString, GetHandle &&getHandle,
+             CachedHandle &&cachedHandle, EncodedHandle &&encodedHandle)
+    : Match(std::move(commandString), std::move(getHandle), nullptr,
+            std::move(cachedHandle), nullptr, std::move(encodedHandle)) {}
+
+/** @note: query only constructor */
+Match::Match(std::string &&commandString, QueryHandle &&queryHandle)
+    : Match(std::move(commandString), nullptr, nullptr, nullptr,
+            std::move(queryHandle), nullptr) {}
+
+/** @note: query constructor, with a binary alternative */
+Match::Match(std::string &&commandString, QueryHandle &&queryHandle,
+             EncodedHandle &&encodedHandle)
+    : Match(std::move(commandString), nullptr, nullptr, nullptr,
+            std::move(queryHandle), std::move(encodedHandle)) {}
 
 std::string Match::toString() const {
     return fmt::format(R"([Match](m_CommandString"{}"))", m_CommandString);
 }
 
-CommandType Match::getCommandType(const std::string &message) {
-    if (message.starts_with(GET)) {
-        return CommandType::getCommand;
+std::optional<double> Match::handleSet(std::string_view argument) const {
+    double     data{0};
+    const auto result = std::from_chars(
+        argument.data(), argument.data() + argument.size(), data);
+    return result.ec == std::errc{} ? std::optional<double>{data}
+                                    : std::nullopt;
+}
+
+bool Match::handleCached(std::string_view argument,
+                         Response &       response) const {
+    if (m_CachedHandleFunc == nullptr || !argument.empty()) {
+        return false;
     }
-    if (message.starts_with(SET)) {
-        return CommandType::setCommand;
+
+    const auto mark = response.size();
+    fmt::format_to(std::back_inserter(response), "{} ", m_CommandString);
+    if (!m_CachedHandleFunc(response)) {
+        response.resize(mark);
+        return false;
     }
-    return CommandType::invalidCommand;
+    response.push_back('\n');
+    return true;
 }
 
-std::optional<double> Match::handleSet(const char *message) const {
-    double data{0};
-    int    r = std::sscanf(message, m_SetPattern.c_str(), &data);
-    return r == 1 ? std::optional<double>{data} : std::nullopt;
+bool Match::handleEncoded(Response &response) const {
+    if (m_EncodedHandleFunc == nullptr) {
+        return false;
+    }
+    const auto mark = response.size();
+    if (!m_EncodedHandleFunc(response)) {
+        response.resize(mark);
+        return false;
+    }
+    return true;
 }
 
-std::optional<std::string> Match::handle(const std::string &message) const {
+bool Match::handle(std::string_view argument, Response &response) const {
     CommandType commandType;
 
     std::optional<double> param;
 
-    if (m_GetHandleFunc != nullptr && message == m_GetPattern) {
+    if (m_QueryHandleFunc != nullptr) {
+        commandType = CommandType::queryCommand;
+
+    } else if (m_GetHandleFunc != nullptr && argument.empty()) {
         commandType = CommandType::getCommand;
 
-    } else if (m_SetHandleFunc != nullptr &&
-               (param = handleSet(message.c_str()))) {
+    } else if (m_SetHandleFunc != nullptr && !argument.empty() &&
+               (param = handleSet(argument))) {
         commandType = CommandType::setCommand;
     } else {
         commandType = CommandType::invalidCommand;
     }
 
     if (commandType == CommandType::invalidCommand) {
-        return {};
+        return false;
     }
 
     // LOG_DEBUG(R"(command: "{}" message: "{}")", m_CommandString,  message);
@@ -69,14 +113,28 @@ std::optional<std::string> Match::handle(const std::string &message) const {
     default:
         LOG_CRITICAL(
             R"(Logic error ! Unknown commandType at "Match::handle".)");
-        return {};
+        return false;
 
     case CommandType::getCommand: {
-        return {fmt::format("{} {}\n", m_CommandString, m_GetHandleFunc())};
+        fmt::format_to(std::back_inserter(response), "{} ", m_CommandString);
+        m_GetHandleFunc(response);
+        response.push_back('\n');
+        return true;
+    }
+    case CommandType::queryCommand: {
+        const auto mark = response.size();
+        fmt::format_to(std::back_inserter(response), "{} ", m_CommandString);
+        if (!m_QueryHandleFunc(argument, response)) {
+            response.resize(mark);
+            return false;
+        }
+        response.push_back('\n');
+        return true;
     }
     case CommandType::setCommand: {
-        return {fmt::format("{} {}\n", m_CommandString,
-                            m_SetHandleFunc(param.value()))};
+        fmt::format_to(std::back_inserter(response), "{} {}\n",
+                       m_CommandString, m_SetHandleFunc(param.value()));
+        return true;
     }
     }
 }
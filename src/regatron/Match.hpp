@@ -2,11 +2,13 @@
 #include "log/Logger.hpp"
 #include "utils/Instrumentator.hpp"
 #include <algorithm>
+#include <charconv>
 #include <fmt/format.h>
 #include <functional>
 #include <iterator>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <optional>
 
 namespace Regatron {
@@ -16,53 +18,103 @@ enum class CommandType : int {
     invalidCommand     = -1,
     getCommand,
     setCommand,
-    cmdCommand
+    cmdCommand,
+    queryCommand
 };
 
+/** Response buffer, reused between the requests of a connection. */
+using Response      = fmt::memory_buffer;
+using GetHandle     = std::function<void(Response &)>;
+using SetHandle     = std::function<std::string_view(double)>;
+/** Answers from cached readings, false when they are not available. */
+using CachedHandle  = std::function<bool(Response &)>;
+/** Get with a text argument, false when the argument is invalid. */
+using QueryHandle   = std::function<bool(std::string_view, Response &)>;
+/** Typed alternative of the binary protocol, appends a Binary::Type value */
+using EncodedHandle = std::function<bool(Response &)>;
+
+inline void Append(Response &response, std::string_view value) {
+    response.append(value.data(), value.data() + value.size());
+}
+
 /**
- * @todo: impplement an elegant dispatcher?
- * @todo: Migrate to a template class?
- * ideas: Have an object checker list that will forward the message to the
- * correct handler method.
+ * A command and its handlers.
+ * Messages follow the pattern "<command>[ <argument>]\n", they are split once
+ * by Regatron::Handler, that finds the Match by command name and forwards the
+ * argument. An empty argument selects the get handler, a numeric argument the
+ * set handler. A query handler takes any argument, e.g.
+ * "getHistory sysVoltage 10".
+ * Get commands may also have a cached handler, used instead of the device
+ * read unless the request asks for a fresh value, and its typed alternative
+ * for the binary protocol.
  * */
 class Match {
   private:
-    static constexpr const char *GET = "get"; // Not parameterized
-    static constexpr const char *SET = "set"; // Parameterized
+    const std::string   m_CommandString;
+    const GetHandle     m_GetHandleFunc;
+    const SetHandle     m_SetHandleFunc;
+    const CachedHandle  m_CachedHandleFunc;
+    const QueryHandle   m_QueryHandleFunc;
+    const EncodedHandle m_EncodedHandleFunc;
 
-    const std::string                        m_CommandString;
-    const std::string                        m_SetFormat;
-    const std::string                        m_GetPattern;
-    const std::string                        m_SetPattern;
-    const std::function<std::string()>       m_GetHandleFunc;
-    const std::function<std::string(double)> m_SetHandleFunc;
-
-    CommandType getCommandType(const std::string& message);
-    Match(std::string&& commandString, std::string&& setFormat,
-          std::function<std::string()>&&       getHandle,
-          std::function<std::string(double)>&& setHandle);
+    Match(std::string&& commandString, GetHandle&& getHandle,
+          SetHandle&& setHandle, CachedHandle&& cachedHandle,
+          QueryHandle&& queryHandle, EncodedHandle&& encodedHandle);
 
   public:
     /** @note: get only constructor */
-    Match(std::string&&            commandString,
-          std::function<std::string()>&& getHandle);
+    Match(std::string&& commandString, GetHandle&& getHandle);
 
     /** @note: set only constructor */
-    Match(std::string&&                  commandString,
-          std::function<std::string(double)>&& setHandle);
+    Match(std::string&& commandString, SetHandle&& setHandle);
+
+    /** @note: get constructor, with a cached alternative */
+    Match(std::string&& commandString, GetHandle&& getHandle,
+          CachedHandle&& cachedHandle);
+
+    /** @note: get constructor, with cached text and binary alternatives */
+    Match(std::string&& commandString, GetHandle&& getHandle,
+          CachedHandle&& cachedHandle, EncodedHandle&& encodedHandle);
+
+    /** @note: query only constructor */
+    Match(std::string&& commandString, QueryHandle&& queryHandle);
+
+    /** @note: query constructor, with a binary alternative */
+    Match(std::string&& commandString, QueryHandle&& queryHandle,
+          EncodedHandle&& encodedHandle);
 
     std::string toString() const;
 
-    /** throws: May throw something (std::invalid_argument)! */
-    std::optional<double> handleSet(const char *message) const;
+    [[nodiscard]] const std::string &name() const { return m_CommandString; }
+
+    /** @return: parsed set argument, nullopt when it is not a number */
+    std::optional<double> handleSet(std::string_view argument) const;
 
     /**
      * Respond a message according to the command type.
      *
-     * @return: A response to the client. following the pattern
+     * @param argument: message content after the command name, without the
+     * trailing new line.
+     * @param response: the response is appended following the pattern
      *     '{} {}\n' Pattern, handle method response.
-     * @throws:
+     * @return: false when the argument does not match any handler.
+     * @throws: handler exceptions, response may be left partially written.
+     * */
+    bool handle(std::string_view argument, Response &response) const;
+
+    /**
+     * Respond a get message from cached readings, no device access.
+     * @return: false when there is no cached handler or the cached readings
+     * are not available, nothing is appended to the response in that case.
+     * */
+    bool handleCached(std::string_view argument, Response &response) const;
+
+    /**
+     * Binary protocol alternative of handleCached, appends the typed value
+     * only, see Binary.
+     * @return: false when there is no such handler or the cached readings
+     * are not available, nothing is appended to the response in that case.
      * */
-    std::optional<std::string> handle(const std::string &message) const;
+    bool handleEncoded(Response &response) const;
 };
 } // namespace Regatron
@@ -1,6 +1,7 @@
 #include "ModuleStatusReadings.hpp"
 #include "serialiolib.h" // NOLINT
 #include "DeviceAccessControl.hpp"
+#include "Tcio.hpp"
 
 namespace Regatron {
 
@@ -13,32 +14,56 @@ void ModuleStatusReadings::Select() {
 };
 
 
+void ModuleStatusReadings::ReadDigital(double voltageIncrement,
+                                       double currentIncrement) {
+    Select();
+    int voltage{0};
+    int current{0};
+    if (TCIO(TC4GetMeasurementDigitalValues)(&voltage, &current) !=
+        DLL_SUCCESS) {
+        throw CommException("failed to get module digital measurements");
+    }
+
+    if (TCIO(TC4StateActSystem)(&m_State) != DLL_SUCCESS) {
+        throw CommException("failed to get module state");
+    }
+
+    m_ActualOutVoltageMon = static_cast<double>(voltage) * voltageIncrement;
+    m_ActualOutCurrentMon = static_cast<double>(current) * currentIncrement;
+    m_ActualOutPowerMon =
+        m_ActualOutVoltageMon * m_ActualOutCurrentMon / WATT_PER_KILOWATT;
+    m_ActualResMon = 0.;
+    if (current != 0) {
+        m_ActualResMon =
+            m_ActualOutVoltageMon / m_ActualOutCurrentMon * MILLIOHM_PER_OHM;
+    }
+}
+
 void ModuleStatusReadings::ReadControlMode() {
     DeviceAccessControl::SelectMod();
-    if (TC4GetControlMode(&m_ControlMode) != DLL_SUCCESS) {
+    if (TCIO(TC4GetControlMode)(&m_ControlMode) != DLL_SUCCESS) {
         throw CommException("failed to read module control mode");
     }
-    DeviceAccessControl::SelectSys();
 }
 
 void ModuleStatusReadings::ReadPhys() {
-    if (TC4GetModulePhysicalLimitMax(&m_VoltagePhysMax, &m_CurrentPhysMax,
-                                     &m_PowerPhysMax,
-                                     &m_ResistancePhysMax) != DLL_SUCCESS) {
+    if (TCIO(TC4GetModulePhysicalLimitMax)(
+            &m_VoltagePhysMax, &m_CurrentPhysMax, &m_PowerPhysMax,
+            &m_ResistancePhysMax) != DLL_SUCCESS) {
         throw CommException(fmt::format(
             "failed to get {} physical max limit values.", Name()));
     }
 
-    if (TC4GetModulePhysicalLimitMin(&m_VoltagePhysMin, &m_CurrentPhysMin,
-                                     &m_PowerPhysMin,
-                                     &m_ResistancePhysMin) != DLL_SUCCESS) {
+    if (TCIO(TC4GetModulePhysicalLimitMin)(
+            &m_VoltagePhysMin, &m_CurrentPhysMin, &m_PowerPhysMin,
+            &m_ResistancePhysMin) != DLL_SUCCESS) {
         throw CommException(fmt::format(
             "failed to get {} physical min limit values.", Name()));
     }
 
-    if (TC4GetModulePhysicalLimitNom(&m_VoltagePhysNom, &m_CurrentPhysNom,
-                                     &m_PowerPhysNom,
-                                     &m_ResistancePhysNom) != DLL_SUCCESS) {
+    if (TCIO(TC4GetModulePhysicalLimitNom)(
+            &m_VoltagePhysNom, &m_CurrentPhysNom, &m_PowerPhysNom,
+            &m_ResistancePhysNom) != DLL_SUCCESS) {
         throw CommException(fmt::format(
             "failed to get {} physical nominal values.", Name()));
     }
@@ -3,12 +3,23 @@
 
 namespace Regatron {
 class ModuleStatusReadings : public StatusReadings {
+    static constexpr double WATT_PER_KILOWATT = 1000.;
+    static constexpr double MILLIOHM_PER_OHM  = 1000.;
+
   public:
     void ReadControlMode() override;
     void ReadPhys() override;
     const char *Name() const override;
     void Select() override;
- 
+
+    /**
+     * Same values as Read(), from the raw measurement inputs converted with
+     * the physical values increments: two transactions instead of five.
+     * Power and resistance are calculated from voltage and current.
+     * @throw CommException
+     * */
+    void ReadDigital(double voltageIncrement, double currentIncrement);
+
 };
 
 } // namespace Regatron
@@ -0,0 +1,195 @@
+#include "OfflineScope.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+#include "Regatron.hpp"
+#include "Tcio.hpp"
+#include "log/Logger.hpp"
+#include "utils/Base64.hpp"
+#include "utils/LittleEndian.hpp"
+
+namespace Regatron {
+
+namespace {
+/** T_OfflineScopeData channel arrays, in channel order */
+constexpr std::array<double (T_OfflineScopeData::*)[OfflineScope::BLOCK],
+                     ScopeWaveform::CHANNELS>
+    BLOCK_CHANNELS{
+        &T_OfflineScopeData::Channel1, &T_OfflineScopeData::Channel2,
+        &T_OfflineScopeData::Channel3, &T_OfflineScopeData::Channel4,
+        &T_OfflineScopeData::Channel5, &T_OfflineScopeData::Channel6,
+        &T_OfflineScopeData::Channel7, &T_OfflineScopeData::Channel8};
+
+using Utils::LittleEndian::Get;
+using Utils::LittleEndian::GetF64;
+using Utils::LittleEndian::Put;
+using Utils::LittleEndian::PutF64;
+
+void PutF64s(fmt::memory_buffer &out, const std::vector<double> &values) {
+    for (const auto value : values) {
+        PutF64(out, value);
+    }
+}
+
+bool GetF64s(std::string_view &in, std::vector<double> &values,
+             std::size_t count) {
+    if (in.size() / sizeof(double) < count) {
+        return false;
+    }
+    values.resize(count);
+    for (auto &value : values) {
+        GetF64(in, value);
+    }
+    return true;
+}
+} // namespace
+
+void OfflineScope::SetChannels(const std::vector<ScopeChannel> &channels) {
+    if (channels.empty() || channels.size() > ScopeWaveform::CHANNELS) {
+        throw std::invalid_argument("offline scope: 1 to 8 channels.");
+    }
+    T_OfflineScopeChannels config{};
+    config.NumOfChannel = static_cast<unsigned int>(channels.size());
+    std::array<unsigned int *, ScopeWaveform::CHANNELS> addresses{
+        &config.pChannel1, &config.pChannel2, &config.pChannel3,
+        &config.pChannel4, &config.pChannel5, &config.pChannel6,
+        &config.pChannel7, &config.pChannel8};
+    for (std::size_t i = 0; i < channels.size(); i++) {
+        *addresses[i] = channels[i].address;
+    }
+
+    if (TCIO(TC4SetOffLineScopeChannels)(&config) != DLL_SUCCESS) {
+        throw CommException("failed to set the offline scope channels.");
+    }
+    m_Factors.fill(1.);
+    for (std::size_t i = 0; i < channels.size(); i++) {
+        m_Factors[i] = channels[i].factor;
+    }
+    m_ChannelCount = channels.size();
+}
+
+void OfflineScope::SetTimeFactor(unsigned int factor) {
+    if (TCIO(TC4SetOffLineScopeTimeFactor)(factor) != DLL_SUCCESS) {
+        throw CommException("failed to set the offline scope time factor.");
+    }
+}
+
+void OfflineScope::SetControl(unsigned int control) {
+    if (TCIO(TC4SetOffLineScopeControl)(control) != DLL_SUCCESS) {
+        throw CommException("failed to set the offline scope control.");
+    }
+}
+
+std::string OfflineScope::GetStatus() {
+    unsigned int status{0};
+    unsigned int samples{0};
+    if (TCIO(TC4GetOffLineScopeStatus)(&status) != DLL_SUCCESS ||
+        TCIO(TC4GetOffLineScopeNumOfValidSamples)(&samples) != DLL_SUCCESS) {
+        throw CommException("failed to read the offline scope status.");
+    }
+    return fmt::format("[{},{}]", status, samples);
+}
+
+std::size_t OfflineScope::BeginRead() {
+    unsigned int samples{0};
+    if (TCIO(TC4GetOffLineScopeNumOfValidSamples)(&samples) != DLL_SUCCESS) {
+        throw CommException("failed to read the offline scope samples.");
+    }
+    // Reused between captures, a read back allocates at most once
+    m_Expected               = samples;
+    m_Waveform.channelCount  = m_ChannelCount;
+    m_Waveform.time.clear();
+    m_Waveform.time.reserve(samples);
+    for (auto &channel : m_Waveform.channels) {
+        channel.clear();
+    }
+    for (std::size_t c = 0; c < m_ChannelCount; c++) {
+        m_Waveform.channels[c].reserve(samples);
+    }
+    return m_Expected;
+}
+
+bool OfflineScope::ReadBlocks(std::size_t calls) {
+    for (std::size_t call = 0;
+         call < calls && m_Waveform.time.size() < m_Expected; call++) {
+        unsigned int reads = BLOCK;
+        if (TCIO(TC4GetOffLineScopeValue)(&m_Block, &reads) != DLL_SUCCESS) {
+            throw CommException("failed to read the offline scope values.");
+        }
+        reads = std::min<unsigned int>(
+            {reads, static_cast<unsigned int>(BLOCK),
+             static_cast<unsigned int>(m_Expected - m_Waveform.time.size())});
+        if (reads == 0) {
+            // Nothing more from the device, keep what was read
+            LOG_WARN(R"(Offline scope: "{}" of "{}" samples read back.)",
+                     m_Waveform.time.size(), m_Expected);
+            m_Expected = m_Waveform.time.size();
+            break;
+        }
+
+        m_Waveform.time.insert(m_Waveform.time.end(), m_Block.TimeStamp,
+                               m_Block.TimeStamp + reads);
+        for (std::size_t c = 0; c < m_ChannelCount; c++) {
+            const auto &values = m_Block.*BLOCK_CHANNELS[c];
+            m_Waveform.channels[c].insert(m_Waveform.channels[c].end(),
+                                          values, values + reads);
+        }
+    }
+
+    if (m_Waveform.time.size() < m_Expected) {
+        return true;
+    }
+    Convert();
+    return false;
+}
+
+void OfflineScope::Convert() {
+    for (std::size_t c = 0; c < m_ChannelCount; c++) {
+        const double factor = m_Factors[c];
+        for (auto &value : m_Waveform.channels[c]) {
+            value *= factor;
+        }
+    }
+}
+
+void AppendWaveform(fmt::memory_buffer &out, const ScopeWaveform &waveform) {
+    Put(out, static_cast<uint32_t>(waveform.time.size()));
+    Put(out, static_cast<uint32_t>(waveform.channelCount));
+    PutF64s(out, waveform.time);
+    for (std::size_t c = 0; c < waveform.channelCount; c++) {
+        PutF64s(out, waveform.channels[c]);
+    }
+}
+
+std::optional<ScopeWaveform> ParseWaveform(std::string_view bytes) {
+    uint32_t samples  = 0;
+    uint32_t channels = 0;
+    if (!Get(bytes, samples) || !Get(bytes, channels) ||
+        channels > ScopeWaveform::CHANNELS) {
+        return {};
+    }
+    ScopeWaveform waveform;
+    waveform.channelCount = channels;
+    if (!GetF64s(bytes, waveform.time, samples)) {
+        return {};
+    }
+    for (std::size_t c = 0; c < channels; c++) {
+        if (!GetF64s(bytes, waveform.channels[c], samples)) {
+            return {};
+        }
+    }
+    return bytes.empty() ? std::optional{std::move(waveform)} : std::nullopt;
+}
+
+void FormatWaveform(fmt::memory_buffer &out, const ScopeWaveform &waveform) {
+    // Reused by every read back of the thread
+    thread_local fmt::memory_buffer bytes;
+    bytes.clear();
+    AppendWaveform(bytes, waveform);
+    Utils::Base64::Encode(out, {bytes.data(), bytes.size()});
+}
+
+} // namespace Regatron
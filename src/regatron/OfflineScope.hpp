@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "fmt/format.h"
+#include "serialiolib.h" // NOLINT
+
+namespace Regatron {
+
+/**
+ * T_OfflineScopeChannels entry.
+ * The DLL channel factors are not loaded, see TC4SetOffLineScopeChannelFactors:
+ * the values are read back raw and only multiplied by factor.
+ * */
+struct ScopeChannel {
+    unsigned int address = 0;  /** DSP variable */
+    double       factor  = 1.; /** physical value per raw unit */
+};
+
+/** Samples read back from the offline scope, structure of arrays */
+struct ScopeWaveform {
+    static constexpr std::size_t CHANNELS = 8;
+
+    std::vector<double>                      time; /** DLL time stamps */
+    std::array<std::vector<double>, CHANNELS> channels;
+    std::size_t                              channelCount = 0;
+};
+
+/**
+ * Device side oscilloscope: samples up to eight DSP variables at the device
+ * rate, the capture is read back afterwards.
+ * The control and status codes are passed through as the DLL defines them.
+ * */
+class OfflineScope {
+  public:
+    /** Samples per TC4GetOffLineScopeValue, see T_OfflineScopeData */
+    static constexpr std::size_t BLOCK = 8;
+
+    /** @throws: CommException */
+    void SetChannels(const std::vector<ScopeChannel> &channels);
+    void SetTimeFactor(unsigned int factor);
+    void SetControl(unsigned int control);
+    /** "[status,validSamples]" */
+    std::string GetStatus();
+
+    /**
+     * Read back in steps: BeginRead() then ReadBlocks() until it returns
+     * false, the waveform is converted to physical values at the end.
+     * @return: samples to read
+     * @throws: CommException
+     * */
+    std::size_t BeginRead();
+    /**
+     * @param calls: TC4GetOffLineScopeValue calls at most
+     * @return: true while samples remain
+     * @throws: CommException
+     * */
+    bool ReadBlocks(std::size_t calls);
+    [[nodiscard]] const ScopeWaveform &GetWaveform() const {
+        return m_Waveform;
+    }
+
+  private:
+    void Convert();
+
+    std::array<double, ScopeWaveform::CHANNELS> m_Factors{};
+    std::size_t                                 m_ChannelCount = 0;
+    std::size_t                                 m_Expected     = 0;
+    ScopeWaveform                               m_Waveform;
+    T_OfflineScopeData                          m_Block{};
+};
+
+/**
+ * Little endian uint32 samples, uint32 channels, double time[samples] and
+ * double values[samples] for each channel.
+ * */
+void AppendWaveform(fmt::memory_buffer &out, const ScopeWaveform &waveform);
+/** @return: nullopt when bytes is not an AppendWaveform layout */
+std::optional<ScopeWaveform> ParseWaveform(std::string_view bytes);
+/** Text protocol: the AppendWaveform bytes in base64, no '\n' nor ';' */
+void FormatWaveform(fmt::memory_buffer &out, const ScopeWaveform &waveform);
+
+} // namespace Regatron
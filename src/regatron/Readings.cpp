@@ -2,38 +2,150 @@
 #include "serialiolib.h" // NOLINT
 
 namespace Regatron {
-static constexpr int   HISTORY_MAX_ENTRIES    = 300;
-static constexpr float HISTORY_NANO_MILLI_CTE = 0.05F;
+static constexpr int HISTORY_MAX_ENTRIES = FlashErrorHistory::CAPACITY;
 
 
 void Readings::readModuleID() {
-    if (TC4GetModuleID(&(this->m_ModuleID)) != DLL_SUCCESS) {
+    if (TCIO(TC4GetModuleID)(&(this->m_ModuleID)) != DLL_SUCCESS) {
         throw CommException("failed to get module ID.");
     }
 }
 
 void Readings::Initialize() {
-    // init lib
-    if (TC4GetPhysicalValuesIncrement(
-            &incDevVoltage, &incDevCurrent, &incDevPower, &incDevResistance,
-            &incSysVoltage, &incSysCurrent, &incSysPower,
-            &incSysResistance) != DLL_SUCCESS) {
-        throw CommException("failed to get physical values increment.");
+    for (std::size_t field = 0; field < MANDATORY_FIELDS; field++) {
+        ReadIdentity(static_cast<IdentityField>(field));
     }
 
-    readModuleID();
+    // Default is to keep system selected !
+    GetSystemStatus().Select();
+}
+
+void Readings::Initialize(const Identity &identity) {
+    incDevVoltage           = identity.increments[0];
+    incDevCurrent           = identity.increments[1];
+    incDevPower             = identity.increments[2];
+    incDevResistance        = identity.increments[3];
+    incSysVoltage           = identity.increments[4];
+    incSysCurrent           = identity.increments[5];
+    incSysPower             = identity.increments[6];
+    incSysResistance        = identity.increments[7];
+    m_ModuleID              = identity.moduleId;
+    m_DCLinkPhysNom         = identity.additional[0];
+    m_PrimaryCurrentPhysNom = identity.additional[1];
+    m_TemperaturePhysNom    = identity.additional[2];
+    m_SysStatusReadings.SetPhys(identity.system);
+    m_ModStatusReadings.SetPhys(identity.module);
+    m_Version.m_DeviceDSPID             = identity.dspId;
+    m_Version.m_DSPVersionString        = identity.dspVersion;
+    m_Version.m_BootloaderVersionString = identity.bootloaderVersion;
+    m_Version.m_PLDVersionString        = identity.pldVersion;
+    m_Version.m_IBCVersionString        = identity.ibcVersion;
+    m_Loaded = (1U << IDENTITY_FIELDS) - 1;
+
+    GetSystemStatus().Select();
+}
 
+void Readings::ReadIdentity(IdentityField field) {
     // One time readings... update on every new connection
-    readAdditionalPhys();
-    if (isMaster()) {
-        readSystemPhys();
+    switch (field) {
+    case IdentityField::Increments:
+        if (TCIO(TC4GetPhysicalValuesIncrement)(
+                &incDevVoltage, &incDevCurrent, &incDevPower,
+                &incDevResistance, &incSysVoltage, &incSysCurrent,
+                &incSysPower, &incSysResistance) != DLL_SUCCESS) {
+            throw CommException("failed to get physical values increment.");
+        }
+        break;
+    case IdentityField::ModuleId:
+        readModuleID();
+        break;
+    case IdentityField::SystemLimits:
+        if (isMaster()) {
+            readSystemPhys();
+        }
+        break;
+    case IdentityField::AdditionalPhys:
+        readAdditionalPhys();
+        break;
+    case IdentityField::ModuleLimits:
+        readModulePhys();
+        break;
+    case IdentityField::DspId:
+        m_Version.ReadDSPChip();
+        break;
+    case IdentityField::DspVersion:
+        m_Version.ReadDSPFirmware();
+        break;
+    case IdentityField::BootloaderVersion:
+        m_Version.ReadDSPBootloader();
+        break;
+    case IdentityField::PldVersion:
+        m_Version.ReadPLDFirmware();
+        break;
+    case IdentityField::IbcVersion:
+        m_Version.ReadIBCFirmware();
+        break;
     }
-    readModulePhys();
+    m_Loaded |= 1U << static_cast<unsigned int>(field);
+}
 
-    getVersion().ReadDSPVersion();
+void Readings::Load(IdentityField field) {
+    if (!isLoaded(field)) {
+        ReadIdentity(field);
+    }
+}
 
-    // Default is to keep system selected !
-    GetSystemStatus().Select();
+bool Readings::isLoaded(IdentityField field) const {
+    return (m_Loaded & (1U << static_cast<unsigned int>(field))) != 0;
+}
+
+const std::string &Readings::getDSPID() {
+    Load(IdentityField::DspId);
+    return m_Version.m_DeviceDSPID;
+}
+
+const std::string &Readings::getDSPVersion() {
+    Load(IdentityField::DspVersion);
+    return m_Version.m_DSPVersionString;
+}
+
+const std::string &Readings::getBootloaderVersion() {
+    Load(IdentityField::BootloaderVersion);
+    return m_Version.m_BootloaderVersionString;
+}
+
+const std::string &Readings::getPLDVersion() {
+    Load(IdentityField::PldVersion);
+    return m_Version.m_PLDVersionString;
+}
+
+const std::string &Readings::getIBCVersion() {
+    Load(IdentityField::IbcVersion);
+    return m_Version.m_IBCVersionString;
+}
+
+std::string Readings::getModMinMaxNom() {
+    Load(IdentityField::ModuleLimits);
+    return m_ModStatusReadings.GetMinMaxNomString();
+}
+
+Identity Readings::GetIdentity(unsigned long serialNr) const {
+    Identity identity;
+    identity.serialNr   = serialNr;
+    identity.increments = {incDevVoltage,    incDevCurrent, incDevPower,
+                           incDevResistance, incSysVoltage, incSysCurrent,
+                           incSysPower,      incSysResistance};
+    identity.moduleId   = m_ModuleID;
+    identity.additional = {m_DCLinkPhysNom, m_PrimaryCurrentPhysNom,
+                           m_TemperaturePhysNom};
+    identity.system     = m_SysStatusReadings.GetPhys();
+    identity.module     = m_ModStatusReadings.GetPhys();
+    identity.dspId             = m_Version.m_DeviceDSPID;
+    identity.dspVersion        = m_Version.m_DSPVersionString;
+    identity.bootloaderVersion = m_Version.m_BootloaderVersionString;
+    identity.pldVersion        = m_Version.m_PLDVersionString;
+    identity.ibcVersion        = m_Version.m_IBCVersionString;
+    return identity;
 }
 
 void Readings::readSystemErrorTree32() {
@@ -51,9 +163,9 @@ void Readings::readSystem() { m_SysStatusReadings.Read(); }
 bool Readings::isMaster() const { return (m_ModuleID == 0); }
 
 void Readings::readAdditionalPhys() {
-    if (TC4GetAdditionalPhysicalValues(&m_DCLinkPhysNom,
-                                       &m_PrimaryCurrentPhysNom,
-                                       &m_TemperaturePhysNom) != DLL_SUCCESS) {
+    if (TCIO(TC4GetAdditionalPhysicalValues)(
+            &m_DCLinkPhysNom, &m_PrimaryCurrentPhysNom,
+            &m_TemperaturePhysNom) != DLL_SUCCESS) {
         throw CommException("failed to get additional physical values.");
     }
 }
@@ -70,17 +182,26 @@ std::string Readings::getSysTree() {
     return m_SysStatusReadings.GetErrorTreeString();
 }
 
+std::string Readings::getModTreeCompact() {
+    return m_ModStatusReadings.GetCompactTreeString();
+}
+
+std::string Readings::getSysTreeCompact() {
+    return m_SysStatusReadings.GetCompactTreeString();
+}
+
 /**
  * Read and convert IGBT, Rectifier and PCB temperatures.
  * @throw CommException
  */
 void Readings::readTemperature() {
+    Load(IdentityField::AdditionalPhys);
     int igbtTemp{0};
     int rectTemp{0};
-    if (TC4GetTempDigital(&igbtTemp, &rectTemp) != DLL_SUCCESS) {
+    if (TCIO(TC4GetTempDigital)(&igbtTemp, &rectTemp) != DLL_SUCCESS) {
         throw CommException("failed to read IGBT and Rectifier temperature.");
     }
-    if (TC42GetTemperaturePCB(&m_PCBTempMon) != DLL_SUCCESS) {
+    if (TCIO(TC42GetTemperaturePCB)(&m_PCBTempMon) != DLL_SUCCESS) {
         throw CommException("failed to read PCB temperature.");
     }
     /*if (TCIBCGetInverterTemperatureHeatsink(&m_IBCInvHeatsinkTemp) !=
@@ -105,10 +226,44 @@ void Readings::readTemperature() {
  * @return string in the format "[val1,...,valn]" */
 std::string Readings::getTemperatures() {
     readTemperature();
-    std::ostringstream oss;
-    oss << '[' << m_IGBTTempMon << ',' << m_RectifierTempMon << ','
-        << m_PCBTempMon << ']';
-    return oss.str();
+    fmt::memory_buffer out;
+    FormatTemperatures(out, m_IGBTTempMon, m_RectifierTempMon, m_PCBTempMon);
+    return fmt::to_string(out);
+}
+
+void Readings::readGroups(Snapshot &snapshot, bool fast, bool slow,
+                          bool fastReadings) {
+    if (fast && fastReadings) {
+        m_ModStatusReadings.ReadDigital(incDevVoltage, incDevCurrent);
+    } else if (fast) {
+        readModule();
+    }
+    if (slow) {
+        readModuleErrorTree32();
+    }
+    if (fast) {
+        readSystem();
+    }
+    if (slow) {
+        readSystemErrorTree32();
+        readDCLinkVoltage();
+        readPrimaryCurrent();
+        readTemperature();
+    }
+
+    if (fast) {
+        snapshot.sys = m_SysStatusReadings.GetSample();
+        snapshot.mod = m_ModStatusReadings.GetSample();
+    }
+    if (slow) {
+        snapshot.dcLinkVoltage  = m_DCLinkVoltageMon;
+        snapshot.primaryCurrent = m_PrimaryCurrentMon;
+        snapshot.igbtTemp       = m_IGBTTempMon;
+        snapshot.rectifierTemp  = m_RectifierTempMon;
+        snapshot.pcbTemp        = m_PCBTempMon;
+        snapshot.sysTree        = m_SysStatusReadings.GetTreeSample();
+        snapshot.modTree        = m_ModStatusReadings.GetTreeSample();
+    }
 }
 
 
@@ -117,9 +272,10 @@ std::string Readings::getTemperatures() {
  * @throw CommException when dll fails
  */
 void Readings::readDCLinkVoltage() {
+    Load(IdentityField::AdditionalPhys);
     int DCLinkVoltStd{0};
 
-    if (TC4GetDCLinkDigital(&DCLinkVoltStd) != DLL_SUCCESS) {
+    if (TCIO(TC4GetDCLinkDigital)(&DCLinkVoltStd) != DLL_SUCCESS) {
         throw CommException("failed to read DCLink digital voltage.");
     }
     m_DCLinkVoltageMon = (static_cast<double>(DCLinkVoltStd) *
@@ -128,8 +284,9 @@ void Readings::readDCLinkVoltage() {
 }
 
 void Readings::readPrimaryCurrent() {
+    Load(IdentityField::AdditionalPhys);
     int primaryCurrent{0};
-    if (TC4GetIPrimDigital(&primaryCurrent) != DLL_SUCCESS) {
+    if (TCIO(TC4GetIPrimDigital)(&primaryCurrent) != DLL_SUCCESS) {
         throw CommException("failed to read transformer primary current.");
     }
     m_PrimaryCurrentMon = (static_cast<double>(primaryCurrent) *
@@ -137,15 +294,6 @@ void Readings::readPrimaryCurrent() {
                           NORM_MAX;
 }
 
-std::string
-Readings::ErrorHistoryEntryToString(T_ErrorHistoryEntry *entry) const {
-    return fmt::format(
-        R"(T_ErrorHistoryEntry(entryCounter={},day={},hour={},minute={},second={},counter50us={},group={},detail={},identifier={}))",
-        entry->entryCounter, entry->day, entry->hour, entry->minute,
-        entry->second, entry->counter50us, entry->group, entry->detail,
-        entry->identifier);
-}
-
 void Readings::SetFlashErrorHistoryMaxEntries(unsigned int maxEntries) {
 
     // @todo: Fix this harcoded limit ....
@@ -159,55 +307,23 @@ void Readings::SetFlashErrorHistoryMaxEntries(unsigned int maxEntries) {
     m_FlashErrorHistoryMaxEntries = maxEntries;
 }
 
-std::string Readings::GetFlashErrorHistoryEntries() const {
-
-    T_ErrorHistoryEntry entry{};
-    unsigned int        nEntries{0};
-    signed int          error{0};
-
-    std::ostringstream oss;
-    oss << '[';
-
-    if (TC4GetFlashErrorHistorySize(&nEntries) != DLL_SUCCESS) {
-        throw CommException("failed to read error history entries.");
-    }
-    LOG_INFO(R"(TC4ErrorHistory: Total entries: {}, Max entries read: {})",
-             nEntries, m_FlashErrorHistoryMaxEntries);
-
-    for (unsigned int nEntry = 0;
-         ((nEntry < nEntries) && (nEntry < m_FlashErrorHistoryMaxEntries));
-         nEntry++) {
-        if (nEntry == 0) {
-            if (TC4GetFlashErrorHistoryFirstEntry(&entry, &error) !=
-                DLL_SUCCESS) {
-                throw CommException("failed to read entry.");
-            }
-        } else {
-            if (TC4GetFlashErrorHistoryNextEntry(&entry, &error) !=
-                DLL_SUCCESS) {
-                throw CommException("failed to read entry.");
-            }
-        }
-        oss << fmt::format("{},{},{},{},{},{:.2f},{},{}", entry.entryCounter,
-                           entry.day, entry.hour, entry.minute, entry.second,
-                           static_cast<float>(entry.counter50us) *
-                               HISTORY_NANO_MILLI_CTE,
-                           entry.group, entry.detail);
-
-        LOG_INFO("{}) {}", nEntry, ErrorHistoryEntryToString(&entry));
-
-        oss << ' ';
-    }
+void Readings::GetFlashErrorHistoryEntries(fmt::memory_buffer &out) {
+    m_FlashErrorHistory.Update(m_FlashErrorHistoryMaxEntries);
+    m_FlashErrorHistory.FormatLast(out, m_FlashErrorHistoryMaxEntries);
+}
 
-    oss << ']';
-    return oss.str();
+void Readings::GetFlashErrorHistoryEntries(fmt::memory_buffer &out,
+                                           unsigned long since,
+                                           std::size_t count) {
+    m_FlashErrorHistory.Update(m_FlashErrorHistoryMaxEntries);
+    m_FlashErrorHistory.Format(out, since, count);
 }
 
 /***
  * function to read actual operating hour counter (counts seconds)
  * */
 unsigned long Readings::GetOperatingSeconds() {
-    if (TC4GetOperatingSeconds(&m_OperatingSeconds) != DLL_SUCCESS) {
+    if (TCIO(TC4GetOperatingSeconds)(&m_OperatingSeconds) != DLL_SUCCESS) {
         throw CommException("failed to read operating seconds.");
     }
     return m_OperatingSeconds;
@@ -216,7 +332,7 @@ unsigned long Readings::GetOperatingSeconds() {
  * function to get operating hour counter (in seconds) at powerup
  * */
 unsigned long Readings::GetPowerupTimeSeconds() {
-    if (TC4GetPowerupTime(&m_PowerupTimeSeconds) != DLL_SUCCESS) {
+    if (TCIO(TC4GetPowerupTime)(&m_PowerupTimeSeconds) != DLL_SUCCESS) {
         throw CommException("failed to read poweruptime seconds.");
     }
     return m_PowerupTimeSeconds;
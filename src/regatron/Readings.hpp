@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <cmath>
 #include <cstdint>
 #include <memory>
@@ -10,6 +11,11 @@
 #include "SystemStatusReadings.hpp"
 #include "DeviceAccessControl.hpp"
 #include "ControllerSettings.hpp"
+#include "FlashErrorHistory.hpp"
+#include "Identity.hpp"
+#include "OfflineScope.hpp"
+#include "Snapshot.hpp"
+#include "Tcio.hpp"
 
 #include "Version.hpp"
 #include "log/Logger.hpp"
@@ -39,6 +45,26 @@ constexpr unsigned int CONST_POWER        = 0;
 
 constexpr int DEFAULT_FLASH_ERROR_HISTORY_MAX_ENTRIES = 30;
 
+/**
+ * One time readings of a connection, in reading order. The first
+ * MANDATORY_FIELDS are needed for control and read before the connection is
+ * Ok, the others on first use or in the background.
+ * */
+enum class IdentityField : unsigned int {
+    Increments,
+    ModuleId,
+    SystemLimits, /** setpoint and slope conversions */
+    AdditionalPhys,
+    ModuleLimits,
+    DspId,
+    DspVersion,
+    BootloaderVersion,
+    PldVersion,
+    IbcVersion
+};
+constexpr std::size_t IDENTITY_FIELDS  = 10;
+constexpr std::size_t MANDATORY_FIELDS = 3;
+
 class Readings {
   public:
     Readings()
@@ -68,9 +94,34 @@ class Readings {
         return m_ModStatusReadings;
     }
 
+    inline OfflineScope &GetOfflineScope() { return m_OfflineScope; }
+
+    /** Read the mandatory identity fields and select the system */
     void Initialize();
+    /** Same, every field taken from a previous identity */
+    void Initialize(const Identity &identity);
+
+    /** Read a field from the device, loaded or not */
+    void ReadIdentity(IdentityField field);
+    /** Read a field unless already loaded */
+    void               Load(IdentityField field);
+    [[nodiscard]] bool isLoaded(IdentityField field) const;
+    /** Bit i set when IdentityField i is loaded, may be called from any
+     * thread */
+    [[nodiscard]] uint32_t getLoaded() const { return m_Loaded; }
+    [[nodiscard]] Identity GetIdentity(unsigned long serialNr) const;
+
+    // Deferred identity fields, loaded on first use
+    const std::string &getDSPID();
+    const std::string &getDSPVersion();
+    const std::string &getBootloaderVersion();
+    const std::string &getPLDVersion();
+    const std::string &getIBCVersion();
+    std::string        getModMinMaxNom();
 
     inline void Reset() {
+        m_Loaded = 0;
+        m_FlashErrorHistory.Clear();
 
         // Increment (internal usage)
         incDevVoltage    = 0.0;
@@ -90,6 +141,8 @@ class Readings {
 
     std::string getModTree();
     std::string getSysTree();
+    std::string getModTreeCompact();
+    std::string getSysTreeCompact();
 
     /**
      * Read and convert to physical value DCLinkVoltage
@@ -137,6 +190,20 @@ class Readings {
     /** Monitor Readings @throw: CommException */
     // void readGeneric();
 
+    /**
+     * Acquisition groups, read from the device into the snapshot.
+     * Fast: system and module actual values and state.
+     * Slow: DC link, primary current, temperatures and error trees.
+     * Versions and limits are read once per connection by Initialize().
+     * Module reads of both groups are done first, so the selector changes
+     * at most twice and the system stays selected afterwards.
+     * @param fastReadings: module values are read from the raw measurement
+     * inputs, see ModuleStatusReadings::ReadDigital.
+     * @throw: CommException
+     * */
+    void readGroups(Snapshot &snapshot, bool fast, bool slow,
+                    bool fastReadings = false);
+
     /** Methods readSystem and readModule will act on the following values:
      * TC4GetVoltageActSense(&m_...ActualOutVoltageMon)
      * TC4GetPowerActSense(&m_...ActualOutPowerMon)
@@ -159,21 +226,29 @@ class Readings {
     unsigned int GetFlashErrorHistoryMaxEntries() const {
         return m_FlashErrorHistoryMaxEntries;
     }
-    std::string GetFlashErrorHistoryEntries() const;
+    /**
+     * Copy the entries new on the device then format the newest ones, at
+     * most GetFlashErrorHistoryMaxEntries()
+     * @throws: CommException
+     * */
+    void GetFlashErrorHistoryEntries(fmt::memory_buffer &out);
+    /** Same, at most count entries after entryCounter since */
+    void GetFlashErrorHistoryEntries(fmt::memory_buffer &out,
+                                     unsigned long since, std::size_t count);
     inline void storeParameters() {
-        if (TC4StoreParameters() != DLL_SUCCESS) {
+        if (TCIO(TC4StoreParameters)() != DLL_SUCCESS) {
             throw CommException("failed to store parameters");
         }
     }
 
     inline void clearErrors() {
-        if (TC4ClearError() != DLL_SUCCESS) {
+        if (TCIO(TC4ClearError)() != DLL_SUCCESS) {
             throw CommException("failed to clear erors");
         }
     }
 
     inline void readRemoteControlInput() {
-        if (TC4GetRemoteControlInput(&m_RemoteCtrlInp) != DLL_SUCCESS) {
+        if (TCIO(TC4GetRemoteControlInput)(&m_RemoteCtrlInp) != DLL_SUCCESS) {
             throw CommException("failed to read remote control input");
         }
     }
@@ -188,6 +263,8 @@ class Readings {
     SystemStatusReadings m_SysStatusReadings;
     ModuleStatusReadings m_ModStatusReadings;
     ControllerSettings m_ControllerSettings;
+    OfflineScope m_OfflineScope;
+    FlashErrorHistory m_FlashErrorHistory;
 
     constexpr static double NORM_MAX       = 4000.;
 
@@ -214,9 +291,10 @@ class Readings {
     unsigned long m_OperatingSeconds;
     unsigned long m_PowerupTimeSeconds;
 
+    std::atomic<uint32_t> m_Loaded{0}; /** see getLoaded() */
+
     // Flash Error History
     unsigned int m_FlashErrorHistoryMaxEntries;
-    std::string  ErrorHistoryEntryToString(T_ErrorHistoryEntry *entry) const;
 
     double incDevVoltage;    /** Increment (internal usage) */
     double incDevCurrent;    /** Increment (internal usage) */
@@ -0,0 +1,159 @@
+#include "Reconnector.hpp"
+
+#include <algorithm>
+
+#include "log/Logger.hpp"
+
+namespace Regatron {
+
+Reconnector::Reconnector(std::shared_ptr<Comm> comm, TcioWorker &worker)
+    : m_Comm(std::move(comm)), m_Worker(worker) {}
+
+Reconnector::~Reconnector() { stop(); }
+
+void Reconnector::start() {
+    if (m_Thread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = false;
+    }
+    m_Thread = std::thread([this]() { run(); });
+}
+
+void Reconnector::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_Condition.notify_all();
+    // Do not wait for a search of the whole port range
+    m_Comm->abortSearch();
+    if (m_Thread.joinable()) {
+        m_Thread.join();
+    }
+}
+
+void Reconnector::reconnect() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Wake     = true;
+        m_Failures = 0;
+    }
+    m_Condition.notify_all();
+}
+
+void Reconnector::run() {
+    auto next     = Clock::now(); // the first attempt starts at once
+    auto nextTune = Clock::now() + TUNE_PERIOD;
+
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    while (!m_Stop) {
+        const auto state = m_Comm->getConnectionState();
+        const auto now   = Clock::now();
+        if (state == ConnectionState::Ok) {
+            // A lost connection is retried at once, the backoff starts over
+            m_Failures = 0;
+            m_Wake     = false;
+            next       = now;
+
+            // One identity field per job, queued control and monitor jobs
+            // run in between
+            const bool tune = m_Comm->GetAdaptiveTimeouts() && now >= nextTune;
+            if (tune || m_Comm->isIdentityPending()) {
+                if (tune) {
+                    nextTune = now + TUNE_PERIOD;
+                }
+                lock.unlock();
+                m_Worker.run(Priority::Background, TcioWorker::NO_DEADLINE,
+                             [this, tune]() {
+                                 m_Comm->loadIdentity();
+                                 if (tune) {
+                                     m_Comm->tuneTimeouts();
+                                 }
+                             });
+                lock.lock();
+                continue;
+            }
+        }
+
+        const bool disconnected = state == ConnectionState::Disconnected;
+        const bool due =
+            m_Wake || (m_Comm->getAutoReconnect() && now >= next);
+        if (!disconnected || !due) {
+            const auto until = now + POLL_PERIOD;
+            m_Condition.wait_until(
+                lock, next > now ? std::min(next, until) : until,
+                [this, disconnected]() {
+                    return m_Stop || (disconnected && m_Wake);
+                });
+            continue;
+        }
+
+        m_Wake = false;
+        lock.unlock();
+        const bool connected = attempt();
+        lock.lock();
+        if (connected) {
+            continue;
+        }
+
+        m_Failures++;
+        const auto wait = backoff();
+        next            = Clock::now() + wait;
+        LOG_INFO(R"(reconnect: attempt "{}" failed, next one in "{} ms".)",
+                 m_Failures,
+                 std::chrono::duration_cast<std::chrono::milliseconds>(wait)
+                     .count());
+    }
+}
+
+bool Reconnector::attempt() {
+    LOG_TRACE("reconnect: attempting to connect.");
+    const auto step = [this](auto &&job) {
+        return m_Worker.run(Priority::Background, TcioWorker::NO_DEADLINE,
+                            job);
+    };
+    try {
+        // The connect delay and the full search only when the device is not
+        // at the port of the last connection
+        bool found = false;
+        if (step([this]() { m_Comm->open(); }) &&
+            step([this, &found]() { found = m_Comm->probe(); }) &&
+            (found || (sleep(m_Comm->GetConnectDelay()) &&
+                       step([this]() { m_Comm->search(); }))) &&
+            step([this]() { m_Comm->initialize(); })) {
+            return true;
+        }
+    } catch (const CommException &e) {
+        LOG_ERROR(R"(reconnect: Failed to connect "{}")", e.what());
+    }
+
+    // Release the DLL, the next attempt starts from DllInit
+    m_Worker.run(Priority::Background, TcioWorker::NO_DEADLINE,
+                 [this]() { m_Comm->disconnect(); });
+    return false;
+}
+
+bool Reconnector::sleep(Clock::duration duration) {
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    return !m_Condition.wait_for(lock, duration, [this]() { return m_Stop; });
+}
+
+Reconnector::Clock::duration Reconnector::backoff() {
+    auto       delay = std::chrono::duration_cast<Clock::duration>(RETRY_MIN);
+    const auto limit = std::max(
+        delay, std::chrono::duration_cast<Clock::duration>(
+                   m_Comm->GetAutoReconnectInterval()));
+    for (unsigned int i = 1; i < m_Failures && delay < limit; i++) {
+        delay *= 2;
+    }
+    delay = std::min(delay, limit);
+
+    std::uniform_real_distribution<double> jitter(0.5, 1.);
+    return std::chrono::duration_cast<Clock::duration>(delay *
+                                                       jitter(m_Random));
+}
+
+} // namespace Regatron
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#include "Comm.hpp"
+#include "TcioWorker.hpp"
+
+namespace Regatron {
+
+/**
+ * Background thread bringing the device connection back, requests never wait
+ * for Comm::connect and fail at once while the state is not Ok.
+ * Disconnected -> Searching -> Initializing -> Ok, the connection steps run
+ * as background jobs of the TCIO worker, the connect delay is waited on this
+ * thread so the worker stays free. stop() aborts a running device search.
+ * Failed attempts are retried with an exponential backoff, from RETRY_MIN
+ * doubling up to the Comm reconnect interval, each wait randomized between
+ * half and all of it so several interfaces do not retry in lockstep. A lost
+ * connection is retried at once.
+ * While connected, the serial timeouts are tuned every TUNE_PERIOD when
+ * adaptive timeouts are enabled, see Comm::tuneTimeouts, and the deferred
+ * identity fields are loaded, see Comm::loadIdentity.
+ * */
+class Reconnector {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::chrono::milliseconds RETRY_MIN{1000};
+    /** Connection state check while nothing is to be done */
+    static constexpr std::chrono::milliseconds POLL_PERIOD{250};
+    static constexpr std::chrono::milliseconds TUNE_PERIOD{1000};
+
+    Reconnector(std::shared_ptr<Comm> comm, TcioWorker &worker);
+    Reconnector(const Reconnector &) = delete;
+    Reconnector(Reconnector &&)      = delete;
+    Reconnector &operator=(const Reconnector &) = delete;
+    Reconnector &operator=(Reconnector &&) = delete;
+    ~Reconnector();
+
+    void start();
+    void stop();
+
+    /**
+     * Attempt to connect at once, even with auto reconnect disabled, the
+     * backoff starts over.
+     * */
+    void reconnect();
+
+  private:
+    void run();
+    /** @return: true when connected */
+    bool attempt();
+    /** @return: false when stopped while waiting */
+    bool sleep(Clock::duration duration);
+    [[nodiscard]] Clock::duration backoff();
+
+    std::shared_ptr<Comm> m_Comm;
+    TcioWorker &          m_Worker;
+
+    std::thread             m_Thread;
+    std::mutex              m_Mutex;
+    std::condition_variable m_Condition;
+    bool                    m_Stop{false};
+    bool                    m_Wake{false};
+    unsigned int            m_Failures{0}; /** consecutive failed attempts */
+    std::mt19937            m_Random{std::random_device{}()};
+};
+
+} // namespace Regatron
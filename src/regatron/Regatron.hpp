@@ -11,6 +11,14 @@ enum class CommStatus {
     Disconncted
 };
 
+/** Connection progress, see Reconnector. */
+enum class ConnectionState {
+    Disconnected,
+    Searching,    /** DLL initialized, looking for the device */
+    Initializing, /** device found, reading its configuration */
+    Ok
+};
+
 class CommException : public std::runtime_error {
   protected:
     std::string      m_Message;
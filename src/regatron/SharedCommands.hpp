@@ -0,0 +1,165 @@
+#pragma once
+/**
+ * Setpoint commands through POSIX shared memory, for local control loops
+ * writing setpoints at a high rate: see SharedCommandsServer on the server
+ * side.
+ * This header only depends on the standard library, POSIX and
+ * utils/SpscRing.hpp, consumers include it as is.
+ * */
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <type_traits>
+
+#include "utils/SpscRing.hpp"
+
+#if __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Regatron::Shared {
+
+constexpr std::uint32_t COMMANDS_MAGIC   = 0x43474552; /** "REGC" */
+constexpr std::uint32_t COMMANDS_VERSION = 1;
+constexpr std::size_t   COMMANDS_SIZE    = 256; /** slots of each ring */
+
+/** System setpoints, as setSys<Setpoint>Ref */
+enum class Setpoint : std::uint32_t {
+    Voltage    = 0, /** [V] */
+    Current    = 1, /** [A] */
+    Power      = 2, /** [kW] */
+    Resistance = 3  /** [mOhm] */
+};
+constexpr std::size_t SETPOINTS = 4;
+
+enum class CommandStatus : std::int32_t {
+    Applied     = 0, /** written to the device */
+    Superseded  = 1, /** a newer value of the same setpoint was written */
+    OutOfRange  = 2, /** outside of the physical limits of the system */
+    Unavailable = 3, /** not connected, or the device is busy */
+    Failed      = 4, /** the device call failed, the connection is reset */
+    Invalid     = 5  /** unknown setpoint */
+};
+
+struct Command {
+    std::uint64_t id       = 0; /** chosen by the client, echoed back */
+    std::uint32_t setpoint = 0; /** Setpoint */
+    std::uint32_t reserved = 0;
+    double        value    = 0;
+};
+
+struct Completion {
+    std::uint64_t id       = 0;
+    std::uint32_t setpoint = 0;
+    std::int32_t  status   = 0; /** CommandStatus */
+    double        value    = 0;
+};
+
+/**
+ * Fixed binary layout, any change to it bumps COMMANDS_VERSION.
+ * The client produces commands and consumes completions, one client at a
+ * time.
+ * */
+struct CommandSegment {
+    /** COMMANDS_MAGIC once the rest is initialized, release / acquire */
+    std::atomic<std::uint32_t> magic{0};
+    std::uint32_t version = 0;
+    std::uint32_t size    = 0; /** sizeof(CommandSegment) */
+    std::uint32_t pid     = 0; /** of the server */
+    /** Completions lost while the completion ring was full */
+    std::atomic<std::uint64_t> droppedCompletions{0};
+    Utils::SpscRing<Command, COMMANDS_SIZE>    commands;
+    Utils::SpscRing<Completion, COMMANDS_SIZE> completions;
+};
+static_assert(std::is_standard_layout_v<CommandSegment>);
+static_assert(std::is_trivially_copyable_v<Command>);
+static_assert(std::is_trivially_copyable_v<Completion>);
+
+/** "/REGxxCommands", mapped at /dev/shm/REGxxCommands */
+inline std::string CommandSegmentName(int regatronPort) {
+    return "/REG" + std::string(regatronPort < 10 ? "0" : "") +
+           std::to_string(regatronPort) + "Commands";
+}
+
+#if __linux__
+/**
+ * Client side of a command segment. Every command gets exactly one
+ * completion, unless droppedCompletions grows: the client has to poll()
+ * them at least as fast as it submits.
+ * Not thread safe, single producer.
+ * */
+class Commander {
+  public:
+    explicit Commander(const std::string &name) {
+        const int fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0) {
+            return;
+        }
+        void *mapping = mmap(nullptr, sizeof(CommandSegment),
+                             PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED) {
+            return;
+        }
+        m_Segment = static_cast<CommandSegment *>(mapping);
+    }
+    Commander(const Commander &) = delete;
+    Commander(Commander &&)      = delete;
+    Commander &operator=(const Commander &) = delete;
+    Commander &operator=(Commander &&) = delete;
+    ~Commander() {
+        if (m_Segment != nullptr) {
+            munmap(m_Segment, sizeof(CommandSegment));
+        }
+    }
+
+    /** @return: false when missing, of another version or not initialized */
+    [[nodiscard]] bool valid() const {
+        return m_Segment != nullptr &&
+               m_Segment->magic.load(std::memory_order_acquire) ==
+                   COMMANDS_MAGIC &&
+               m_Segment->version == COMMANDS_VERSION &&
+               m_Segment->size == sizeof(CommandSegment);
+    }
+
+    /** @return: command id, 0 when not valid() or the ring is full */
+    std::uint64_t submit(Setpoint setpoint, double value) {
+        if (!valid()) {
+            return 0;
+        }
+        const Command command{.id       = m_NextId,
+                              .setpoint = static_cast<std::uint32_t>(setpoint),
+                              .value    = value};
+        if (!m_Segment->commands.push(command)) {
+            return 0;
+        }
+        return m_NextId++;
+    }
+
+    /** @return: next completion, nullopt when there is none */
+    std::optional<Completion> poll() {
+        Completion completion;
+        if (!valid() || !m_Segment->completions.pop(completion)) {
+            return {};
+        }
+        return completion;
+    }
+
+    [[nodiscard]] std::uint64_t droppedCompletions() const {
+        return valid() ? m_Segment->droppedCompletions.load(
+                             std::memory_order_relaxed)
+                       : 0;
+    }
+
+  private:
+    CommandSegment *m_Segment = nullptr;
+    std::uint64_t   m_NextId  = 1;
+};
+#endif
+
+} // namespace Regatron::Shared
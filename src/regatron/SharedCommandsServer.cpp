@@ -0,0 +1,133 @@
+#include "SharedCommandsServer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <optional>
+
+#include "log/Logger.hpp"
+
+namespace Regatron {
+
+#if __linux__
+SharedCommandsServer::SharedCommandsServer(std::string name,
+                                           TcioWorker &worker, Apply apply)
+    : m_Name(std::move(name)), m_Worker(worker), m_Apply(std::move(apply)) {
+    const int fd = shm_open(m_Name.c_str(), O_CREAT | O_RDWR, 0600);
+    if (fd < 0) {
+        LOG_ERROR(R"(Shared commands: failed to open "{}". "{}".)", m_Name,
+                  std::strerror(errno));
+        return;
+    }
+    void *mapping = MAP_FAILED;
+    if (ftruncate(fd, sizeof(Shared::CommandSegment)) == 0) {
+        mapping = mmap(nullptr, sizeof(Shared::CommandSegment),
+                       PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    const int error = errno;
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        LOG_ERROR(R"(Shared commands: failed to map "{}". "{}".)", m_Name,
+                  std::strerror(error));
+        shm_unlink(m_Name.c_str());
+        return;
+    }
+
+    // Published last, clients check the magic before anything else
+    m_Segment          = new (mapping) Shared::CommandSegment{};
+    m_Segment->version = Shared::COMMANDS_VERSION;
+    m_Segment->size    = sizeof(Shared::CommandSegment);
+    m_Segment->pid     = static_cast<std::uint32_t>(getpid());
+    m_Segment->magic.store(Shared::COMMANDS_MAGIC, std::memory_order_release);
+    LOG_INFO(R"(Shared commands: setpoints accepted at "/dev/shm{}".)",
+             m_Name);
+
+    m_Thread = std::thread(&SharedCommandsServer::run, this);
+}
+
+SharedCommandsServer::~SharedCommandsServer() {
+    if (m_Segment == nullptr) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_StopMutex);
+        m_Stop = true;
+    }
+    m_StopCondition.notify_all();
+    m_Thread.join();
+
+    m_Segment->magic.store(0, std::memory_order_release);
+    munmap(m_Segment, sizeof(Shared::CommandSegment));
+    shm_unlink(m_Name.c_str());
+}
+#else
+SharedCommandsServer::SharedCommandsServer(std::string name,
+                                           TcioWorker &worker, Apply apply)
+    : m_Name(std::move(name)), m_Worker(worker), m_Apply(std::move(apply)) {
+    LOG_WARN(R"(Shared commands: "{}" not available on this platform.)",
+             m_Name);
+}
+
+SharedCommandsServer::~SharedCommandsServer() = default;
+#endif
+
+void SharedCommandsServer::run() {
+    std::unique_lock<std::mutex> lock(m_StopMutex);
+    auto                         period = POLL_PERIOD;
+    while (!m_StopCondition.wait_for(lock, period,
+                                     [this]() { return m_Stop; })) {
+        if (m_Segment->commands.empty()) {
+            period = std::min(period * 2, IDLE_POLL_PERIOD);
+            continue;
+        }
+        period = POLL_PERIOD;
+        lock.unlock();
+        // Commands queued while waiting for the worker are coalesced too
+        if (!m_Worker.run(Priority::Control, DEADLINE,
+                          [this]() { drain(); })) {
+            LOG_WARN("Shared commands: TCIO worker busy, commands kept queued");
+        }
+        lock.lock();
+    }
+}
+
+void SharedCommandsServer::drain() {
+    std::array<std::optional<Shared::Command>, Shared::SETPOINTS> latest{};
+    Shared::Command command;
+    while (m_Segment->commands.pop(command)) {
+        if (command.setpoint >= Shared::SETPOINTS) {
+            complete(command, Shared::CommandStatus::Invalid);
+            continue;
+        }
+        auto &pending = latest[command.setpoint];
+        if (pending) {
+            complete(*pending, Shared::CommandStatus::Superseded);
+        }
+        pending = command;
+    }
+
+    for (const auto &pending : latest) {
+        if (pending) {
+            complete(*pending,
+                     m_Apply(static_cast<Shared::Setpoint>(pending->setpoint),
+                             pending->value));
+        }
+    }
+}
+
+void SharedCommandsServer::complete(const Shared::Command &command,
+                                    Shared::CommandStatus  status) {
+    const Shared::Completion completion{
+        .id       = command.id,
+        .setpoint = command.setpoint,
+        .status   = static_cast<std::int32_t>(status),
+        .value    = command.value};
+    // Never wait for the client, it reads droppedCompletions
+    if (!m_Segment->completions.push(completion)) {
+        m_Segment->droppedCompletions.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+} // namespace Regatron
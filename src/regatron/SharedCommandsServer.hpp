@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "SharedCommands.hpp"
+#include "TcioWorker.hpp"
+
+namespace Regatron {
+
+/**
+ * Server side of a Shared::CommandSegment: created on construction, removed
+ * on destruction.
+ * A thread polls the command ring, less often while it is idle, and drains
+ * it in a Control job of the TCIO worker. Commands are coalesced per setpoint, last value wins: the
+ * commands queued while the previous device writes ran complete as
+ * Superseded, only the newest value of each setpoint is applied.
+ * Not available outside of Linux, see enabled().
+ * */
+class SharedCommandsServer {
+  public:
+    /**
+     * Device write of a setpoint, on the worker thread.
+     * @return: status of the completion
+     * */
+    using Apply = std::function<Shared::CommandStatus(Shared::Setpoint,
+                                                      double value)>;
+
+    /**
+     * Wait between two looks at the command ring, doubled while it stays
+     * empty up to IDLE_POLL_PERIOD, back to POLL_PERIOD on the next command
+     * */
+    static constexpr std::chrono::microseconds POLL_PERIOD{250};
+    static constexpr std::chrono::microseconds IDLE_POLL_PERIOD{8000};
+    /** Maximum wait for the TCIO worker, the commands stay queued */
+    static constexpr std::chrono::seconds DEADLINE{1};
+
+    /** @param name: "/REGxxCommands", see Shared::CommandSegmentName */
+    SharedCommandsServer(std::string name, TcioWorker &worker, Apply apply);
+    SharedCommandsServer(const SharedCommandsServer &) = delete;
+    SharedCommandsServer(SharedCommandsServer &&)      = delete;
+    SharedCommandsServer &operator=(const SharedCommandsServer &) = delete;
+    SharedCommandsServer &operator=(SharedCommandsServer &&) = delete;
+    ~SharedCommandsServer();
+
+    /** @return: false when the segment could not be created */
+    [[nodiscard]] bool enabled() const { return m_Segment != nullptr; }
+
+  private:
+    void run();
+    /** On the worker thread */
+    void drain();
+    void complete(const Shared::Command &command,
+                  Shared::CommandStatus  status);
+
+    const std::string       m_Name;
+    TcioWorker &            m_Worker;
+    const Apply             m_Apply;
+    Shared::CommandSegment *m_Segment = nullptr;
+
+    std::thread             m_Thread;
+    std::mutex              m_StopMutex;
+    std::condition_variable m_StopCondition;
+    bool                    m_Stop{false};
+};
+
+} // namespace Regatron
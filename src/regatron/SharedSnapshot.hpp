@@ -0,0 +1,153 @@
+#pragma once
+/**
+ * Readings snapshot published in POSIX shared memory, for consumers on the
+ * same host: see SharedSnapshotWriter on the server side.
+ * This header only depends on the standard library, POSIX and
+ * utils/SeqLock.hpp, consumers include it as is.
+ * */
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <type_traits>
+
+#include "utils/SeqLock.hpp"
+
+#if __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Regatron::Shared {
+
+constexpr std::uint32_t MAGIC   = 0x53474552; /** "REGS" little endian */
+constexpr std::uint32_t VERSION = 1;
+
+/** T_ErrorTree32 with fixed size words */
+struct Tree {
+    std::uint32_t                group = 0;
+    std::array<std::uint32_t, 32> error{};
+};
+
+/** Actual output values, see StatusSample */
+struct Sample {
+    double        voltage    = 0; // [V]
+    double        current    = 0; // [A]
+    double        power      = 0; // [kW]
+    double        resistance = 0; // [mOhm]
+    std::uint32_t state      = 0;
+    std::uint32_t reserved   = 0;
+};
+
+/**
+ * Fixed binary layout, any change to it bumps VERSION.
+ * Times are CLOCK_MONOTONIC [ns] of the last read of the group, zero when
+ * the group was never read: the age tells stale readings apart, e.g. while
+ * the device is disconnected.
+ * */
+struct Readings {
+    std::int64_t  fastTime = 0;
+    Sample        sys;
+    Sample        mod;
+    std::int64_t  slowTime       = 0;
+    double        dcLinkVoltage  = 0; // [V]
+    double        primaryCurrent = 0; // [A]
+    double        igbtTemp       = 0; // [°C]
+    double        rectifierTemp  = 0; // [°C]
+    double        pcbTemp        = 0; // [°C]
+    Tree          sysError;
+    Tree          sysWarning;
+    Tree          modError;
+    Tree          modWarning;
+    std::uint64_t treeGeneration = 0; /** see getTreeSince */
+};
+
+struct Segment {
+    /** MAGIC once the rest is initialized, release / acquire */
+    std::atomic<std::uint32_t> magic{0};
+    std::uint32_t version = 0;
+    std::uint32_t size    = 0; /** sizeof(Segment) */
+    std::uint32_t pid     = 0; /** of the server */
+    Utils::SeqLock<Readings> readings;
+};
+static_assert(std::is_standard_layout_v<Readings>);
+// Shared between processes, only lock free atomics are address free
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+
+/** "/REGxx", mapped at /dev/shm/REGxx */
+inline std::string SegmentName(int regatronPort) {
+    return "/REG" + std::string(regatronPort < 10 ? "0" : "") +
+           std::to_string(regatronPort);
+}
+
+#if __linux__
+/**
+ * Read only mapping of a segment. A read is a copy out of the mapping, with
+ * no system call and nothing asked of the server.
+ * */
+class Reader {
+  public:
+    /** A read overlapping this many updates in a row gives up */
+    static constexpr int MAX_ATTEMPTS = 1000;
+
+    explicit Reader(const std::string &name) {
+        const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            return;
+        }
+        void *mapping = mmap(nullptr, sizeof(Segment), PROT_READ, MAP_SHARED,
+                             fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED) {
+            return;
+        }
+        m_Segment = static_cast<const Segment *>(mapping);
+    }
+    Reader(const Reader &) = delete;
+    Reader(Reader &&)      = delete;
+    Reader &operator=(const Reader &) = delete;
+    Reader &operator=(Reader &&) = delete;
+    ~Reader() {
+        if (m_Segment != nullptr) {
+            munmap(const_cast<Segment *>(m_Segment), sizeof(Segment));
+        }
+    }
+
+    /** @return: false when missing, of another version or not initialized */
+    [[nodiscard]] bool valid() const {
+        return m_Segment != nullptr &&
+               m_Segment->magic.load(std::memory_order_acquire) == MAGIC &&
+               m_Segment->version == VERSION &&
+               m_Segment->size == sizeof(Segment);
+    }
+
+    /** @return: nullopt when not valid() or always overlapping an update */
+    [[nodiscard]] std::optional<Readings> read() const {
+        if (!valid()) {
+            return {};
+        }
+        Readings readings;
+        for (int attempt = 0; attempt < MAX_ATTEMPTS; attempt++) {
+            if (m_Segment->readings.tryLoad(readings)) {
+                return readings;
+            }
+        }
+        return {};
+    }
+
+    /** Published updates, unchanged readings have the same version */
+    [[nodiscard]] std::uint64_t version() const {
+        return valid() ? m_Segment->readings.version() : 0;
+    }
+
+  private:
+    const Segment *m_Segment = nullptr;
+};
+#endif
+
+} // namespace Regatron::Shared
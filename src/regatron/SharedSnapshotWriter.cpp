@@ -0,0 +1,104 @@
+#include "SharedSnapshotWriter.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#include "log/Logger.hpp"
+
+namespace Regatron {
+
+namespace {
+Shared::Tree ToShared(const T_ErrorTree32 &tree) {
+    Shared::Tree shared;
+    shared.group = static_cast<std::uint32_t>(tree.group);
+    std::transform(std::begin(tree.error), std::end(tree.error),
+                   shared.error.begin(), [](unsigned long word) {
+                       return static_cast<std::uint32_t>(word);
+                   });
+    return shared;
+}
+
+Shared::Sample ToShared(const StatusSample &sample) {
+    return {.voltage    = sample.voltage,
+            .current    = sample.current,
+            .power      = sample.power,
+            .resistance = sample.resistance,
+            .state      = sample.state};
+}
+} // namespace
+
+#if __linux__
+SharedSnapshotWriter::SharedSnapshotWriter(std::string name)
+    : m_Name(std::move(name)) {
+    const int fd = shm_open(m_Name.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0) {
+        LOG_ERROR(R"(Shared snapshot: failed to open "{}". "{}".)", m_Name,
+                  std::strerror(errno));
+        return;
+    }
+    void *mapping = MAP_FAILED;
+    if (ftruncate(fd, sizeof(Shared::Segment)) == 0) {
+        mapping = mmap(nullptr, sizeof(Shared::Segment),
+                       PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    const int error = errno;
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        LOG_ERROR(R"(Shared snapshot: failed to map "{}". "{}".)", m_Name,
+                  std::strerror(error));
+        shm_unlink(m_Name.c_str());
+        return;
+    }
+
+    // Published last, readers check the magic before anything else
+    m_Segment          = new (mapping) Shared::Segment{};
+    m_Segment->version = Shared::VERSION;
+    m_Segment->size    = sizeof(Shared::Segment);
+    m_Segment->pid     = static_cast<std::uint32_t>(getpid());
+    m_Segment->magic.store(Shared::MAGIC, std::memory_order_release);
+    LOG_INFO(R"(Shared snapshot: readings published at "/dev/shm{}", "{}" bytes.)",
+             m_Name, sizeof(Shared::Segment));
+}
+
+SharedSnapshotWriter::~SharedSnapshotWriter() {
+    if (m_Segment == nullptr) {
+        return;
+    }
+    m_Segment->magic.store(0, std::memory_order_release);
+    munmap(m_Segment, sizeof(Shared::Segment));
+    shm_unlink(m_Name.c_str());
+}
+#else
+SharedSnapshotWriter::SharedSnapshotWriter(std::string name)
+    : m_Name(std::move(name)) {
+    LOG_WARN(R"(Shared snapshot: "{}" not available on this platform.)",
+             m_Name);
+}
+
+SharedSnapshotWriter::~SharedSnapshotWriter() = default;
+#endif
+
+void SharedSnapshotWriter::publish(const Snapshot &snapshot) {
+    if (m_Segment == nullptr) {
+        return;
+    }
+    m_Readings.fastTime       = snapshot.fastTime;
+    m_Readings.sys            = ToShared(snapshot.sys);
+    m_Readings.mod            = ToShared(snapshot.mod);
+    m_Readings.slowTime       = snapshot.slowTime;
+    m_Readings.dcLinkVoltage  = snapshot.dcLinkVoltage;
+    m_Readings.primaryCurrent = snapshot.primaryCurrent;
+    m_Readings.igbtTemp       = snapshot.igbtTemp;
+    m_Readings.rectifierTemp  = snapshot.rectifierTemp;
+    m_Readings.pcbTemp        = snapshot.pcbTemp;
+    m_Readings.sysError       = ToShared(snapshot.sysTree.error);
+    m_Readings.sysWarning     = ToShared(snapshot.sysTree.warning);
+    m_Readings.modError       = ToShared(snapshot.modTree.error);
+    m_Readings.modWarning     = ToShared(snapshot.modTree.warning);
+    m_Readings.treeGeneration = snapshot.treeGeneration;
+    m_Segment->readings.store(m_Readings);
+}
+
+} // namespace Regatron
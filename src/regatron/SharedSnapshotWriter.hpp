@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+
+#include "SharedSnapshot.hpp"
+#include "Snapshot.hpp"
+
+namespace Regatron {
+
+/**
+ * Server side of a Shared::Segment: created on construction, removed on
+ * destruction. Single writer, publish() is called by the acquisition after
+ * every read, the readers never hold it back.
+ * Not available outside of Linux, see enabled().
+ * */
+class SharedSnapshotWriter {
+  public:
+    /** @param name: "/REGxx", see Shared::SegmentName */
+    explicit SharedSnapshotWriter(std::string name);
+    SharedSnapshotWriter(const SharedSnapshotWriter &) = delete;
+    SharedSnapshotWriter(SharedSnapshotWriter &&)      = delete;
+    SharedSnapshotWriter &operator=(const SharedSnapshotWriter &) = delete;
+    SharedSnapshotWriter &operator=(SharedSnapshotWriter &&) = delete;
+    ~SharedSnapshotWriter();
+
+    /** @return: false when the segment could not be created */
+    [[nodiscard]] bool enabled() const { return m_Segment != nullptr; }
+
+    void publish(const Snapshot &snapshot);
+
+  private:
+    const std::string m_Name;
+    Shared::Segment * m_Segment = nullptr;
+    Shared::Readings  m_Readings; /** converted, reused */
+};
+
+} // namespace Regatron
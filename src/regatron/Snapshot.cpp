@@ -0,0 +1,70 @@
+#include "Snapshot.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+namespace Regatron {
+
+void FormatReadings(fmt::memory_buffer &out, const StatusSample &sample) {
+    fmt::format_to(std::back_inserter(out), R"([{},{},{},{},{}])",
+                   sample.voltage, sample.current, sample.power,
+                   sample.resistance, sample.state);
+}
+
+void FormatErrorTree(fmt::memory_buffer &out, const TreeSample &tree) {
+    auto it = fmt::format_to(std::back_inserter(out), "[{}",
+                             tree.error.group);
+    for (const auto &error : tree.error.error) {
+        it = fmt::format_to(it, ",{}", error);
+    }
+    it = fmt::format_to(it, ",{}", tree.warning.group);
+    for (const auto &warning : tree.warning.error) {
+        it = fmt::format_to(it, ",{}", warning);
+    }
+    out.push_back(']');
+}
+
+namespace {
+bool SameTree(const T_ErrorTree32 &a, const T_ErrorTree32 &b) {
+    return a.group == b.group &&
+           std::equal(std::begin(a.error), std::end(a.error),
+                      std::begin(b.error));
+}
+
+template <typename It> It FormatCompact(It it, const T_ErrorTree32 &tree) {
+    uint32_t mask = 0;
+    for (std::size_t n = 0; n < std::size(tree.error); n++) {
+        if (tree.error[n] != 0) {
+            mask |= 1U << n;
+        }
+    }
+    it = fmt::format_to(it, "{:x},{:x}", tree.group, mask);
+    for (const auto &word : tree.error) {
+        if (word != 0) {
+            it = fmt::format_to(it, ",{:x}", word);
+        }
+    }
+    return it;
+}
+} // namespace
+
+bool TreeSample::operator==(const TreeSample &other) const {
+    return SameTree(error, other.error) && SameTree(warning, other.warning);
+}
+
+void FormatCompactTree(fmt::memory_buffer &out, const TreeSample &tree) {
+    out.push_back('[');
+    auto it = FormatCompact(std::back_inserter(out), tree.error);
+    *it++   = ',';
+    FormatCompact(it, tree.warning);
+    out.push_back(']');
+}
+
+void FormatTemperatures(fmt::memory_buffer &out, double igbt,
+                        double rectifier, double pcb) {
+    // Same as the default std::ostream double formatting
+    fmt::format_to(std::back_inserter(out), "[{:g},{:g},{:g}]", igbt,
+                   rectifier, pcb);
+}
+
+} // namespace Regatron
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+
+#include "fmt/format.h"
+#include "serialiolib.h" // NOLINT
+
+namespace Regatron {
+
+/** Actual output values, as read by StatusReadings::Read. */
+struct StatusSample {
+    double   voltage    = 0; // [V]
+    double   current    = 0; // [A]
+    double   power      = 0; // [kW]
+    double   resistance = 0; // [mOhm]
+    uint32_t state      = 0;
+};
+
+/** Error and warning trees, as read by StatusReadings::ReadErrorTree32. */
+struct TreeSample {
+    T_ErrorTree32 error{};
+    T_ErrorTree32 warning{};
+
+    bool operator==(const TreeSample &other) const;
+};
+
+/**
+ * Readings published by the acquisition thread.
+ * Every group carries the steady clock time, in nanoseconds, of its last
+ * successful read, zero when it was never read in this connection.
+ * */
+struct Snapshot {
+    uint64_t epoch = 0; /** Acquisition::invalidate() count at read time */
+
+    // Fast group
+    int64_t      fastTime = 0;
+    StatusSample sys;
+    StatusSample mod;
+
+    // Slow group
+    int64_t    slowTime       = 0;
+    double     dcLinkVoltage  = 0; // [V]
+    double     primaryCurrent = 0; // [A]
+    double     igbtTemp       = 0; // [°C]
+    double     rectifierTemp  = 0; // [°C]
+    double     pcbTemp        = 0; // [°C]
+    TreeSample sysTree;
+    TreeSample modTree;
+    uint64_t   treeGeneration = 0; /** error or warning bit changes read */
+};
+
+/** "[voltage,current,power,resistance,state]" */
+void FormatReadings(fmt::memory_buffer &out, const StatusSample &sample);
+
+/** "[errorGroup,error0,...,error31,warningGroup,warning0,...,warning31]" */
+void FormatErrorTree(fmt::memory_buffer &out, const TreeSample &tree);
+
+/**
+ * Hex "[errorGroup,errorMask,words...,warningGroup,warningMask,words...]",
+ * bit n of a mask is set when detail word n is not zero, only those words
+ * follow, e.g. "[0,0,0,0]" without errors and warnings.
+ * */
+void FormatCompactTree(fmt::memory_buffer &out, const TreeSample &tree);
+
+/** "[igbt,rectifier,pcb]" */
+void FormatTemperatures(fmt::memory_buffer &out, double igbt,
+                        double rectifier, double pcb);
+
+} // namespace Regatron
@@ -1,6 +1,6 @@
 #include "StatusReadings.hpp"
 #include "serialiolib.h" // NOLINT
-#include <sstream>
+#include "Tcio.hpp"
 
 namespace Regatron {
 const std::string StatusReadings::GetMinMaxNomString() const {
@@ -13,11 +13,11 @@ const std::string StatusReadings::GetMinMaxNomString() const {
 
 void StatusReadings::ReadErrorTree32() {
     Select();
-    if (TC4ReadErrorTree32(&m_ErrorTree32Mon) != DLL_SUCCESS) {
+    if (TCIO(TC4ReadErrorTree32)(&m_ErrorTree32Mon) != DLL_SUCCESS) {
         throw CommException(fmt::format("failed to get {} error tree",
                             Name()));
     }
-    if (TC4ReadWarningTree32(&m_WarningTree32Mon) != DLL_SUCCESS) {
+    if (TCIO(TC4ReadWarningTree32)(&m_WarningTree32Mon) != DLL_SUCCESS) {
         throw CommException(
             fmt::format("failed to get {} module warn tree", Name()));
     }
@@ -25,57 +25,88 @@ void StatusReadings::ReadErrorTree32() {
 
 void StatusReadings::Read() {
     Select();
-    if (TC4GetVoltageAct(&m_ActualOutVoltageMon) != DLL_SUCCESS) {
+    if (TCIO(TC4GetVoltageAct)(&m_ActualOutVoltageMon) != DLL_SUCCESS) {
         throw CommException("failed to get module actual output voltage");
     }
 
-    if (TC4GetPowerAct(&m_ActualOutPowerMon) != DLL_SUCCESS) {
+    if (TCIO(TC4GetPowerAct)(&m_ActualOutPowerMon) != DLL_SUCCESS) {
         throw CommException("failed to get module actual output power");
     }
 
-    if (TC4GetCurrentAct(&m_ActualOutCurrentMon) != DLL_SUCCESS) {
+    if (TCIO(TC4GetCurrentAct)(&m_ActualOutCurrentMon) != DLL_SUCCESS) {
         throw CommException("failed to get module actual output current");
     }
 
-    if (TC4GetResistanceAct(&m_ActualResMon) != DLL_SUCCESS) {
+    if (TCIO(TC4GetResistanceAct)(&m_ActualResMon) != DLL_SUCCESS) {
         throw CommException("failed to get module actual resistence");
     }
 
-    if (TC4StateActSystem(&m_State) != DLL_SUCCESS) {
+    if (TCIO(TC4StateActSystem)(&m_State) != DLL_SUCCESS) {
         throw CommException("failed to get module state");
     }
 }
 
+StatusSample StatusReadings::GetSample() const {
+    return {.voltage    = m_ActualOutVoltageMon,
+            .current    = m_ActualOutCurrentMon,
+            .power      = m_ActualOutPowerMon,
+            .resistance = m_ActualResMon,
+            .state      = m_State};
+}
+
+TreeSample StatusReadings::GetTreeSample() const {
+    return {.error = m_ErrorTree32Mon, .warning = m_WarningTree32Mon};
+}
+
+PhysLimits StatusReadings::GetPhys() const {
+    return {.min = {.voltage    = m_VoltagePhysMin,
+                    .current    = m_CurrentPhysMin,
+                    .power      = m_PowerPhysMin,
+                    .resistance = m_ResistancePhysMin},
+            .max = {.voltage    = m_VoltagePhysMax,
+                    .current    = m_CurrentPhysMax,
+                    .power      = m_PowerPhysMax,
+                    .resistance = m_ResistancePhysMax},
+            .nom = {.voltage    = m_VoltagePhysNom,
+                    .current    = m_CurrentPhysNom,
+                    .power      = m_PowerPhysNom,
+                    .resistance = m_ResistancePhysNom}};
+}
+
+void StatusReadings::SetPhys(const PhysLimits &phys) {
+    m_VoltagePhysMin    = phys.min.voltage;
+    m_CurrentPhysMin    = phys.min.current;
+    m_PowerPhysMin      = phys.min.power;
+    m_ResistancePhysMin = phys.min.resistance;
+    m_VoltagePhysMax    = phys.max.voltage;
+    m_CurrentPhysMax    = phys.max.current;
+    m_PowerPhysMax      = phys.max.power;
+    m_ResistancePhysMax = phys.max.resistance;
+    m_VoltagePhysNom    = phys.nom.voltage;
+    m_CurrentPhysNom    = phys.nom.current;
+    m_PowerPhysNom      = phys.nom.power;
+    m_ResistancePhysNom = phys.nom.resistance;
+}
+
 const std::string StatusReadings::GetReadingsString() {
     Read();
-    return fmt::format(R"([{},{},{},{},{}])", m_ActualOutVoltageMon,
-                       m_ActualOutCurrentMon, m_ActualOutPowerMon,
-                       m_ActualResMon, m_State);
+    fmt::memory_buffer out;
+    FormatReadings(out, GetSample());
+    return fmt::to_string(out);
 }
 
 const std::string StatusReadings::GetErrorTreeString() {
-    std::ostringstream oss;
     ReadErrorTree32();
+    fmt::memory_buffer out;
+    FormatErrorTree(out, GetTreeSample());
+    return fmt::to_string(out);
+}
 
-    // Error
-    oss << '[' << m_ErrorTree32Mon.group << ',';
-    for (const auto &error : m_ErrorTree32Mon.error) {
-        oss << error;
-        oss << ',';
-    }
-
-    // Warning
-    int idx{0};
-    oss << m_WarningTree32Mon.group << ',';
-    for (const auto &error : m_WarningTree32Mon.error) {
-        oss << error;
-        idx++;
-        if (idx < ERROR_TREE32_LEN) {
-            oss << ',';
-        }
-    }
-    oss << ']';
-    return oss.str();
+const std::string StatusReadings::GetCompactTreeString() {
+    ReadErrorTree32();
+    fmt::memory_buffer out;
+    FormatCompactTree(out, GetTreeSample());
+    return fmt::to_string(out);
 }
 
 const std::string StatusReadings::GetControlModeString() {
@@ -85,28 +116,28 @@ const std::string StatusReadings::GetControlModeString() {
 
 double StatusReadings::GetCurrentRef() {
     Select();
-    if (TC4GetCurrentRef(&m_CurrentRef) != DLL_SUCCESS) {
+    if (TCIO(TC4GetCurrentRef)(&m_CurrentRef) != DLL_SUCCESS) {
         throw CommException("failed to read module current referece");
     }
     return m_CurrentRef;
 }
 double StatusReadings::GetVoltageRef() {
     Select();
-    if (TC4GetVoltageRef(&m_VoltageRef) != DLL_SUCCESS) {
+    if (TCIO(TC4GetVoltageRef)(&m_VoltageRef) != DLL_SUCCESS) {
         throw CommException("failed to read module voltage referece");
     }
     return m_VoltageRef;
 }
 double StatusReadings::GetResistanceRef() {
     Select();
-    if (TC4GetResistanceRef(&m_ResRef) != DLL_SUCCESS) {
+    if (TCIO(TC4GetResistanceRef)(&m_ResRef) != DLL_SUCCESS) {
         throw CommException("failed to read module resitance referece");
     }
     return m_ResRef;
 }
 double StatusReadings::GetPowerRef() {
     Select();
-    if (TC4GetPowerRef(&m_PowerRef) != DLL_SUCCESS) {
+    if (TCIO(TC4GetPowerRef)(&m_PowerRef) != DLL_SUCCESS) {
         throw CommException("failed to read module voltage referece");
     }
     return m_PowerRef;
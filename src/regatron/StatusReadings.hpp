@@ -9,10 +9,31 @@
 
 #include "Regatron.hpp"
 #include "DeviceAccessControl.hpp"
+#include "Snapshot.hpp"
 
 class Readings;
 namespace Regatron {
 constexpr static int    ERROR_TREE32_LEN = 32;
+
+/** Voltage [V], current [A], power [kW] and resistance [mOhm] */
+struct PhysValues {
+    double voltage    = 0;
+    double current    = 0;
+    double power      = 0;
+    double resistance = 0;
+
+    bool operator==(const PhysValues &) const = default;
+};
+
+/** Physical limits, as read by ReadPhys. */
+struct PhysLimits {
+    PhysValues min;
+    PhysValues max;
+    PhysValues nom;
+
+    bool operator==(const PhysLimits &) const = default;
+};
+
 class StatusReadings {
 
   public:
@@ -22,6 +43,8 @@ class StatusReadings {
     virtual ~StatusReadings() = default;
 
     const std::string GetErrorTreeString();
+    /** See FormatCompactTree */
+    const std::string GetCompactTreeString();
     const std::string GetMinMaxNomString() const;
     const std::string GetReadingsString();
     const std::string GetControlModeString();
@@ -29,6 +52,12 @@ class StatusReadings {
     double       GetCurrentPhysMax() const { return m_CurrentPhysMax; }
     double       GetVoltagePhysMax() const { return m_VoltagePhysMax; };
     uint32_t     GetControlMode() const { return m_ControlMode; }
+    /** Values of the last Read() and ReadErrorTree32() calls */
+    StatusSample GetSample() const;
+    TreeSample   GetTreeSample() const;
+    PhysLimits   GetPhys() const;
+    /** Limits known from a previous ReadPhys() */
+    void         SetPhys(const PhysLimits &phys);
     virtual void ReadPhys() = 0;
     void         Read();
     void         ReadErrorTree32();
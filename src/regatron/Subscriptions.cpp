@@ -0,0 +1,165 @@
+#include "Subscriptions.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <iterator>
+
+#include "log/Logger.hpp"
+
+namespace Regatron {
+
+std::optional<SubscriptionRequest>
+ParseSubscription(std::string_view argument) {
+    std::array<std::string_view, 3> words{};
+    std::size_t                     count = 0;
+    while (!argument.empty()) {
+        const auto end = argument.find(' ');
+        if (end != 0) {
+            if (count == words.size()) {
+                return {};
+            }
+            words[count++] = argument.substr(0, end);
+        }
+        argument.remove_prefix(end == std::string_view::npos ? argument.size()
+                                                             : end + 1);
+    }
+    if (count < 2) {
+        return {};
+    }
+
+    SubscriptionRequest request;
+    auto                names = words[0];
+    while (!names.empty()) {
+        const auto end     = names.find(',');
+        const auto channel = ParseChannel(names.substr(0, end));
+        if (!channel) {
+            return {};
+        }
+        request.channels.push_back(*channel);
+        names.remove_prefix(end == std::string_view::npos ? names.size()
+                                                          : end + 1);
+    }
+
+    const auto number = [](std::string_view word, auto &value) {
+        return std::from_chars(word.data(), word.data() + word.size(), value)
+                   .ec == std::errc{};
+    };
+    std::chrono::milliseconds::rep period{0};
+    double                         deadband{0};
+    if (!number(words[1], period) || period < 0 ||
+        (count == 3 && (!number(words[2], deadband) || deadband < 0))) {
+        return {};
+    }
+    request.period = std::chrono::milliseconds{period};
+    if (count == 3) {
+        request.deadband = deadband;
+    }
+    if (request.channels.empty() || (period == 0 && !request.deadband)) {
+        return {};
+    }
+    return request;
+}
+
+uint64_t Subscriptions::add(SubscriptionRequest                request,
+                            const std::shared_ptr<Net::Outbox> &outbox) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    Subscription                subscription;
+    subscription.id      = ++m_LastId;
+    subscription.request = std::move(request);
+    subscription.outbox  = outbox;
+    m_Subscriptions.push_back(std::move(subscription));
+    LOG_INFO(R"(Subscriptions: "{}" added, "{}" active.)", m_LastId,
+             m_Subscriptions.size());
+    return m_LastId;
+}
+
+bool Subscriptions::remove(uint64_t                            id,
+                           const std::shared_ptr<Net::Outbox> &outbox) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    const auto                  found = std::find_if(
+        m_Subscriptions.begin(), m_Subscriptions.end(),
+        [id, &outbox](const Subscription &subscription) {
+            return subscription.id == id &&
+                   subscription.outbox.lock() == outbox;
+        });
+    if (found == m_Subscriptions.end()) {
+        return false;
+    }
+    m_Subscriptions.erase(found);
+    return true;
+}
+
+void Subscriptions::removeAll(const std::shared_ptr<Net::Outbox> &outbox) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    std::erase_if(m_Subscriptions, [&outbox](const Subscription &subscription) {
+        return subscription.outbox.lock() == outbox;
+    });
+}
+
+void Subscriptions::publish(const Snapshot &snapshot, int64_t now) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    // Sessions closed since the last snapshot
+    std::erase_if(m_Subscriptions, [](const Subscription &subscription) {
+        return subscription.outbox.expired();
+    });
+
+    for (auto &subscription : m_Subscriptions) {
+        const auto outbox = subscription.outbox.lock();
+        if (!outbox || !isDue(subscription, snapshot, now)) {
+            continue;
+        }
+
+        m_Update.clear();
+        auto it = fmt::format_to(std::back_inserter(m_Update), "update {} [",
+                                 subscription.id);
+        for (std::size_t i = 0; i < subscription.values.size(); i++) {
+            it = fmt::format_to(it, i == 0 ? "{}" : ",{}",
+                                subscription.values[i]);
+        }
+        m_Update.append(std::string_view{"]\n"});
+        // Merged with the previous update when the client is behind
+        outbox->push(subscription.id,
+                     std::string_view{m_Update.data(), m_Update.size()});
+    }
+}
+
+bool Subscriptions::isDue(Subscription &subscription,
+                          const Snapshot &snapshot, int64_t now) {
+    const auto &request = subscription.request;
+    // Nothing to push before the first read of every group subscribed
+    for (const auto channel : request.channels) {
+        if ((static_cast<std::size_t>(channel) < FAST_CHANNELS
+                 ? snapshot.fastTime
+                 : snapshot.slowTime) == 0) {
+            return false;
+        }
+    }
+    bool due =
+        subscription.time == 0 ||
+        (request.period.count() > 0 &&
+         now - subscription.time >=
+             std::chrono::nanoseconds{request.period}.count());
+    if (!due && request.deadband) {
+        for (std::size_t i = 0; i < request.channels.size(); i++) {
+            if (std::abs(ChannelValue(snapshot, request.channels[i]) -
+                         subscription.values[i]) > *request.deadband) {
+                due = true;
+                break;
+            }
+        }
+    }
+    if (!due) {
+        return false;
+    }
+
+    subscription.values.resize(request.channels.size());
+    for (std::size_t i = 0; i < request.channels.size(); i++) {
+        subscription.values[i] = ChannelValue(snapshot, request.channels[i]);
+    }
+    subscription.time = now;
+    return true;
+}
+
+} // namespace Regatron
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "History.hpp"
+#include "Snapshot.hpp"
+#include "fmt/format.h"
+#include "net/Outbox.hpp"
+
+namespace Regatron {
+
+/** subscribe "<channel>[,<channel>...] <period_ms> [deadband]" */
+struct SubscriptionRequest {
+    std::vector<Channel>      channels;
+    std::chrono::milliseconds period{0}; /** 0: on changes only */
+    std::optional<double>     deadband;  /** nullopt: periodic only */
+};
+
+/** @return: nullopt when malformed, or without a period nor a deadband */
+std::optional<SubscriptionRequest> ParseSubscription(std::string_view argument);
+
+/**
+ * Channels pushed to the sessions that subscribed to them, out of the
+ * acquisition snapshots: any number of subscribers costs the same serial
+ * reads.
+ * An update goes out when the period elapsed since the previous one, or
+ * when a value moved by more than the deadband, at most once per snapshot.
+ * "update <id> [value,...]\n", the values in the order subscribed.
+ * A subscription ends with unsubscribe or when its session closes.
+ * Thread safe.
+ * */
+class Subscriptions {
+  public:
+    /** @return: subscription id */
+    uint64_t add(SubscriptionRequest                request,
+                 const std::shared_ptr<Net::Outbox> &outbox);
+    /** @return: false when the session has no such subscription */
+    bool remove(uint64_t id, const std::shared_ptr<Net::Outbox> &outbox);
+    /** Every subscription of the session */
+    void removeAll(const std::shared_ptr<Net::Outbox> &outbox);
+
+    /**
+     * @param now: steady clock [ns]
+     * On the acquisition thread, see Acquisition::Listener
+     * */
+    void publish(const Snapshot &snapshot, int64_t now);
+
+  private:
+    struct Subscription {
+        uint64_t                   id = 0;
+        SubscriptionRequest        request;
+        std::weak_ptr<Net::Outbox> outbox;
+        std::vector<double>        values; /** last pushed */
+        int64_t                    time = 0; /** of the last push, 0: none */
+    };
+
+    /** @return: true when an update is due */
+    static bool isDue(Subscription &subscription, const Snapshot &snapshot,
+                      int64_t now);
+
+    std::mutex                m_Mutex;
+    std::vector<Subscription> m_Subscriptions;
+    uint64_t                  m_LastId = 0;
+    fmt::memory_buffer        m_Update; /** reused by publish() */
+};
+
+} // namespace Regatron
@@ -0,0 +1,89 @@
+#include "TaggedRequests.hpp"
+
+#include <exception>
+#include <iterator>
+
+#include "log/Logger.hpp"
+
+namespace Regatron {
+
+TaggedRequests::TaggedRequests(Handle handle) : m_Handle(std::move(handle)) {
+    for (std::size_t priority = 0; priority < PRIORITIES; priority++) {
+        m_Threads[priority] = std::thread(&TaggedRequests::run, this, priority);
+    }
+}
+
+TaggedRequests::~TaggedRequests() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_Condition.notify_all();
+    // A request handed to the worker runs to the end
+    for (auto &thread : m_Threads) {
+        thread.join();
+    }
+}
+
+bool TaggedRequests::post(Priority priority, std::string_view tag,
+                          std::string_view                    message,
+                          const std::shared_ptr<Net::Outbox> &outbox) {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto &queue = m_Queues[static_cast<std::size_t>(priority)];
+        if (queue.size() == MAX_PENDING) {
+            return false;
+        }
+        queue.push_back({.tag     = std::string{tag},
+                         .message = std::string{message},
+                         .outbox  = outbox});
+    }
+    m_Condition.notify_all();
+    return true;
+}
+
+std::size_t TaggedRequests::pending() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    std::size_t                 count = m_Running;
+    for (const auto &queue : m_Queues) {
+        count += queue.size();
+    }
+    return count;
+}
+
+void TaggedRequests::run(std::size_t priority) {
+    auto &             queue = m_Queues[priority];
+    fmt::memory_buffer reply; /** reused by every request of the thread */
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    while (true) {
+        m_Condition.wait(lock, [this, &queue]() {
+            return m_Stop || !queue.empty();
+        });
+        if (m_Stop) {
+            return;
+        }
+        auto request = std::move(queue.front());
+        queue.pop_front();
+        m_Running++;
+        lock.unlock();
+
+        reply.clear();
+        fmt::format_to(std::back_inserter(reply), "{} ", request.tag);
+        try {
+            m_Handle(request.message, reply);
+        } catch (const std::exception &e) {
+            LOG_ERROR(R"(Tagged request "{}" failed. "{}".)", request.tag,
+                      e.what());
+            reply.resize(request.tag.size() + 1);
+            fmt::format_to(std::back_inserter(reply), "NACK\n");
+        }
+        if (auto outbox = request.outbox.lock()) {
+            outbox->reply({reply.data(), reply.size()});
+        }
+
+        lock.lock();
+        m_Running--;
+    }
+}
+
+} // namespace Regatron
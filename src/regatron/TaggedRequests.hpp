@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "TcioWorker.hpp"
+#include "fmt/format.h"
+#include "net/Outbox.hpp"
+
+namespace Regatron {
+
+/**
+ * Tagged requests waiting for the TCIO worker, "#<tag> <message>\n".
+ * One thread per Priority hands them to the worker, in order within a
+ * priority, so a queued setpoint never waits behind a flash history walk.
+ * Each reply goes to the session Outbox as "#<tag> <reply>\n" as soon as it
+ * is out, whatever the order of the requests.
+ * Thread safe.
+ * */
+class TaggedRequests {
+  public:
+    /**
+     * Complete reply of a message, including the trailing new line. Runs
+     * on the thread of the priority and waits for the worker.
+     * */
+    using Handle =
+        std::function<void(std::string_view message, fmt::memory_buffer &)>;
+
+    /** Requests queued per priority, the next ones are refused */
+    static constexpr std::size_t MAX_PENDING = 64;
+
+    explicit TaggedRequests(Handle handle);
+    TaggedRequests(const TaggedRequests &) = delete;
+    TaggedRequests(TaggedRequests &&)      = delete;
+    TaggedRequests &operator=(const TaggedRequests &) = delete;
+    TaggedRequests &operator=(TaggedRequests &&) = delete;
+    ~TaggedRequests();
+
+    /**
+     * @param tag: "#<tag>", as received
+     * @return: false when the priority already has MAX_PENDING requests
+     * */
+    bool post(Priority priority, std::string_view tag,
+              std::string_view                    message,
+              const std::shared_ptr<Net::Outbox> &outbox);
+
+    /** Requests queued or running */
+    [[nodiscard]] std::size_t pending() const;
+
+  private:
+    struct Request {
+        std::string                tag;
+        std::string                message;
+        std::weak_ptr<Net::Outbox> outbox; /** the session may close */
+    };
+
+    static constexpr std::size_t PRIORITIES = 3;
+
+    void run(std::size_t priority);
+
+    const Handle                                m_Handle;
+    mutable std::mutex                          m_Mutex;
+    std::condition_variable                     m_Condition;
+    std::array<std::deque<Request>, PRIORITIES> m_Queues;
+    std::size_t                                 m_Running{0};
+    bool                                        m_Stop{false};
+    std::array<std::thread, PRIORITIES>         m_Threads;
+};
+
+} // namespace Regatron
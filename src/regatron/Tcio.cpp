@@ -0,0 +1,160 @@
+#include "Tcio.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "fmt/format.h"
+#include "log/Logger.hpp"
+
+namespace Regatron::Tcio {
+
+namespace {
+constexpr std::string_view MAGIC = "TCIOTRC1";
+/** id, result, duration, size */
+constexpr std::size_t HEADER_SIZE = 4 + 4 + 4 + 2;
+
+std::mutex           traceMutex;
+std::FILE *          recording = nullptr;
+std::vector<uint8_t> replay;
+std::size_t          replayOffset = 0;
+double               replayScale  = 1.;
+
+template <typename T> void Put(uint8_t *&out, T value) {
+    std::memcpy(out, &value, sizeof(T));
+    out += sizeof(T);
+}
+
+template <typename T> T Take(const uint8_t *&in) {
+    T value;
+    std::memcpy(&value, in, sizeof(T));
+    in += sizeof(T);
+    return value;
+}
+
+void Close() {
+    if (recording != nullptr) {
+        std::fclose(recording);
+        recording = nullptr;
+    }
+    replay.clear();
+    replayOffset = 0;
+}
+} // namespace
+
+namespace Detail {
+std::atomic<Mode>       mode{Mode::Off};
+std::atomic<Observer *> observer{nullptr};
+
+void Write(const Record &record) {
+    std::array<uint8_t, HEADER_SIZE> header{};
+    uint8_t *                        out = header.data();
+    Put(out, record.id);
+    Put(out, record.result);
+    Put(out, record.duration);
+    Put(out, record.size);
+
+    std::lock_guard<std::mutex> lock(traceMutex);
+    if (recording == nullptr) {
+        return;
+    }
+    std::fwrite(header.data(), 1, header.size(), recording);
+    std::fwrite(record.payload.data(), 1, record.size, recording);
+}
+
+bool Read(uint32_t id, std::size_t size, std::string_view name,
+          Record &record) {
+    std::lock_guard<std::mutex> lock(traceMutex);
+    if (replayOffset + HEADER_SIZE > replay.size()) {
+        LOG_WARN(R"(TCIO replay: trace ended, "{}" fails.)", name);
+        return false;
+    }
+    const uint8_t *in = replay.data() + replayOffset;
+    record.id         = Take<uint32_t>(in);
+    record.result     = Take<int32_t>(in);
+    record.duration   = Take<uint32_t>(in);
+    record.size       = Take<uint16_t>(in);
+
+    if (record.id != id || record.size != size ||
+        replayOffset + HEADER_SIZE + record.size > replay.size()) {
+        LOG_ERROR(
+            R"(TCIO replay: trace diverged at byte {}, "{}" does not match the recorded call.)",
+            replayOffset, name);
+        return false;
+    }
+    std::memcpy(record.payload.data(), in, record.size);
+    replayOffset += HEADER_SIZE + record.size;
+    return true;
+}
+
+void Wait(const Record &record) {
+    double scale{0};
+    {
+        std::lock_guard<std::mutex> lock(traceMutex);
+        scale = replayScale;
+    }
+    if (scale > 0 && record.duration > 0) {
+        std::this_thread::sleep_for(std::chrono::duration<double, std::micro>(
+            static_cast<double>(record.duration) * scale));
+    }
+}
+} // namespace Detail
+
+void StartRecording(const std::string &path) {
+    std::lock_guard<std::mutex> lock(traceMutex);
+    Close();
+    recording = std::fopen(path.c_str(), "wb");
+    if (recording == nullptr) {
+        throw std::runtime_error(
+            fmt::format(R"(failed to open TCIO trace "{}")", path));
+    }
+    std::fwrite(MAGIC.data(), 1, MAGIC.size(), recording);
+    Detail::mode = Mode::Record;
+    LOG_INFO(R"(TCIO calls recorded to "{}")", path);
+}
+
+void StartReplay(const std::string &path, double timeScale) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error(
+            fmt::format(R"(failed to read TCIO trace "{}")", path));
+    }
+    std::vector<uint8_t> trace{std::istreambuf_iterator<char>(file),
+                               std::istreambuf_iterator<char>()};
+    if (trace.size() < MAGIC.size() ||
+        std::string_view(reinterpret_cast<const char *>(trace.data()),
+                         MAGIC.size()) != MAGIC) {
+        throw std::runtime_error(
+            fmt::format(R"("{}" is not a TCIO trace)", path));
+    }
+
+    std::lock_guard<std::mutex> lock(traceMutex);
+    Close();
+    replay       = std::move(trace);
+    replayOffset = MAGIC.size();
+    replayScale  = timeScale;
+    Detail::mode = Mode::Replay;
+    LOG_INFO(R"(TCIO calls replayed from "{}", {} bytes, time scale {})", path,
+             replay.size(), replayScale);
+}
+
+void SetObserver(Observer *observer) {
+    Detail::observer.store(observer, std::memory_order_release);
+}
+
+void ClearObserver(Observer *observer) {
+    Detail::observer.compare_exchange_strong(observer, nullptr,
+                                             std::memory_order_acq_rel);
+}
+
+void Stop() {
+    std::lock_guard<std::mutex> lock(traceMutex);
+    Detail::mode = Mode::Off;
+    Close();
+}
+
+} // namespace Regatron::Tcio
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "serialiolib.h" // NOLINT
+
+/**
+ * Every TCIO call goes through this macro, e.g.
+ *   TCIO(TC4GetVoltageAct)(&voltage)
+ * so it can be recorded to a trace file or replayed from one.
+ * */
+#define TCIO(function)                                                         \
+    ::Regatron::Tcio::Invoker<&function, ::Regatron::Tcio::Id(#function),      \
+                              ::Regatron::Tcio::IsDeviceCall(#function)> {     \
+        #function                                                              \
+    }
+
+namespace Regatron::Tcio {
+
+enum class Mode {
+    Off,    /** calls go to the library */
+    Record, /** calls go to the library and are appended to the trace */
+    Replay  /** calls are answered from the trace, the library is not used */
+};
+
+/**
+ * Trace file: "TCIOTRC1" followed by one record per call
+ *   uint32 function id, int32 result, uint32 duration [us],
+ *   uint16 payload size, payload
+ * The payload holds every argument in order, the value of inputs and the
+ * value pointed to by outputs after the call.
+ * */
+struct Record {
+    static constexpr std::size_t MAX_PAYLOAD = 1024; /** T_OfflineScopeData */
+
+    uint32_t                         id       = 0;
+    int32_t                          result   = 0;
+    uint32_t                         duration = 0; // [us]
+    uint16_t                         size     = 0;
+    std::array<uint8_t, MAX_PAYLOAD> payload{};
+};
+
+/** Stable function id, FNV-1a of the function name */
+constexpr uint32_t Id(std::string_view name) {
+    uint32_t hash = 2166136261U;
+    for (const char c : name) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 16777619U;
+    }
+    return hash;
+}
+
+/** Device calls (TC...) go on the wire, DLL calls (Dll...) do not */
+constexpr bool IsDeviceCall(std::string_view name) {
+    return name.substr(0, 2) == "TC";
+}
+
+/** Told about every device call, e.g. to follow the link round trip time */
+class Observer {
+  public:
+    Observer()                 = default;
+    Observer(const Observer &) = delete;
+    Observer(Observer &&)      = delete;
+    Observer &operator=(const Observer &) = delete;
+    Observer &operator=(Observer &&) = delete;
+    virtual ~Observer()        = default;
+
+    /** On the calling thread, right after the call */
+    virtual void onCall(DLL_RESULT                result,
+                        std::chrono::microseconds duration) = 0;
+};
+
+/** A single observer, nullptr removes it */
+void SetObserver(Observer *observer);
+/** Remove the observer only when it is still `observer` */
+void ClearObserver(Observer *observer);
+
+/** @throws: std::runtime_error when the file cannot be opened */
+void StartRecording(const std::string &path);
+/**
+ * @param timeScale: each call takes its recorded duration times timeScale,
+ * 0 answers at once.
+ * @throws: std::runtime_error when the file cannot be read
+ * */
+void StartReplay(const std::string &path, double timeScale = 1.);
+/** Flush and close the trace, calls go to the library again. */
+void Stop();
+
+namespace Detail {
+extern std::atomic<Mode>       mode;
+extern std::atomic<Observer *> observer;
+
+void Write(const Record &record);
+/**
+ * Take the next record of the trace.
+ * @return: false when the trace ended or diverged, the next record is not a
+ * call to `id` with `size` bytes of payload
+ * */
+bool Read(uint32_t id, std::size_t size, std::string_view name,
+          Record &record);
+/** Sleep the scaled duration of a replayed record */
+void Wait(const Record &record);
+
+/** Bytes of an argument in the payload */
+template <typename Param> constexpr std::size_t PayloadSize() {
+    if constexpr (std::is_same_v<Param, char *>) {
+        return DLL_VERSIONSTRING_COPY_LENGTH;
+    } else if constexpr (std::is_pointer_v<Param>) {
+        return sizeof(std::remove_pointer_t<Param>);
+    } else {
+        return sizeof(Param);
+    }
+}
+
+template <typename Param>
+void Save(Record &record, const Param &arg) {
+    constexpr auto size = PayloadSize<Param>();
+    const void *   data = &arg;
+    if constexpr (std::is_pointer_v<Param>) {
+        data = arg;
+    }
+    std::memcpy(record.payload.data() + record.size, data, size);
+    record.size += static_cast<uint16_t>(size);
+}
+
+template <typename Param>
+void Load(const Record &record, std::size_t &offset, Param &arg) {
+    constexpr auto size = PayloadSize<Param>();
+    if constexpr (std::is_pointer_v<Param>) {
+        std::memcpy(static_cast<void *>(arg), record.payload.data() + offset,
+                    size);
+    }
+    offset += size;
+}
+} // namespace Detail
+
+[[nodiscard]] inline Mode GetMode() {
+    return Detail::mode.load(std::memory_order_relaxed);
+}
+
+template <auto Function, uint32_t ID, bool DEVICE,
+          typename = decltype(Function)>
+struct Invoker;
+
+template <auto Function, uint32_t ID, bool DEVICE, typename... Params>
+struct Invoker<Function, ID, DEVICE, DLL_RESULT (*)(Params...)> {
+    static constexpr std::size_t PAYLOAD_SIZE =
+        (Detail::PayloadSize<Params>() + ... + 0);
+    static_assert(PAYLOAD_SIZE <= Record::MAX_PAYLOAD,
+                  "TCIO arguments do not fit a trace record");
+
+    std::string_view name;
+
+    DLL_RESULT operator()(Params... args) const {
+        Observer *observer = nullptr;
+        if constexpr (DEVICE) {
+            observer = Detail::observer.load(std::memory_order_acquire);
+        }
+        const auto mode = GetMode();
+        if (mode == Mode::Off && observer == nullptr) {
+            return Function(args...);
+        }
+
+        switch (mode) {
+        case Mode::Off:
+        case Mode::Record: {
+            const auto start    = std::chrono::steady_clock::now();
+            const auto result   = Function(args...);
+            const auto duration = std::chrono::duration_cast<
+                std::chrono::microseconds>(std::chrono::steady_clock::now() -
+                                           start);
+            if (observer != nullptr) {
+                observer->onCall(result, duration);
+            }
+            if (mode == Mode::Record) {
+                Record record;
+                record.id       = ID;
+                record.result   = result;
+                record.duration = static_cast<uint32_t>(duration.count());
+                (Detail::Save(record, args), ...);
+                Detail::Write(record);
+            }
+            return result;
+        }
+
+        case Mode::Replay: {
+            Record record;
+            if (!Detail::Read(ID, PAYLOAD_SIZE, name, record)) {
+                return DLL_FAIL;
+            }
+            [[maybe_unused]] std::size_t offset = 0;
+            (Detail::Load(record, offset, args), ...);
+            Detail::Wait(record);
+            if (observer != nullptr) {
+                observer->onCall(record.result,
+                                 std::chrono::microseconds{record.duration});
+            }
+            return record.result;
+        }
+        }
+        return DLL_FAIL;
+    }
+};
+
+} // namespace Regatron::Tcio
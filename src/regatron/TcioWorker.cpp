@@ -0,0 +1,130 @@
+#include "TcioWorker.hpp"
+
+#include "log/Logger.hpp"
+
+namespace Regatron {
+
+TcioWorker::TcioWorker() : m_Thread([this]() { loop(); }) {}
+
+TcioWorker::~TcioWorker() { stop(); }
+
+void TcioWorker::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_WorkCondition.notify_all();
+    if (m_Thread.joinable() && !isWorkerThread()) {
+        m_Thread.join();
+    }
+}
+
+void TcioWorker::push(Task &task) {
+    auto &queue = m_Queues[task.queue];
+    task.prev   = queue.tail;
+    task.next   = nullptr;
+    if (queue.tail != nullptr) {
+        queue.tail->next = &task;
+    } else {
+        queue.head = &task;
+    }
+    queue.tail = &task;
+}
+
+void TcioWorker::unlink(Task &task) {
+    auto &queue = m_Queues[task.queue];
+    if (task.prev != nullptr) {
+        task.prev->next = task.next;
+    } else {
+        queue.head = task.next;
+    }
+    if (task.next != nullptr) {
+        task.next->prev = task.prev;
+    } else {
+        queue.tail = task.prev;
+    }
+    task.prev = nullptr;
+    task.next = nullptr;
+}
+
+TcioWorker::Task *TcioWorker::front() {
+    for (auto &queue : m_Queues) {
+        if (queue.head != nullptr) {
+            return queue.head;
+        }
+    }
+    return nullptr;
+}
+
+bool TcioWorker::execute(Task &task, Clock::duration deadline) {
+    if (isWorkerThread()) {
+        // Already the TCIO owner, queueing would dead lock
+        task.invoke(task.context);
+        return true;
+    }
+
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    if (m_Stop) {
+        return false;
+    }
+    push(task);
+    m_WorkCondition.notify_one();
+
+    const auto started = [&task]() { return task.state != State::Queued; };
+    if (deadline == NO_DEADLINE) {
+        m_DoneCondition.wait(lock, started);
+    } else if (!m_DoneCondition.wait_for(lock, deadline, started)) {
+        unlink(task);
+        task.state = State::Cancelled;
+    }
+
+    // A running job uses the caller stack, wait for it to finish
+    m_DoneCondition.wait(lock, [&task]() {
+        return task.state == State::Done || task.state == State::Cancelled;
+    });
+    if (task.state == State::Cancelled) {
+        return false;
+    }
+    if (task.exception) {
+        std::rethrow_exception(task.exception);
+    }
+    return true;
+}
+
+void TcioWorker::loop() {
+    LOG_TRACE("TCIO worker started.");
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    while (true) {
+        m_WorkCondition.wait(lock,
+                             [this]() { return m_Stop || front() != nullptr; });
+        if (m_Stop) {
+            break;
+        }
+
+        auto *task = front();
+        unlink(*task);
+        task->state = State::Running;
+        m_DoneCondition.notify_all();
+
+        lock.unlock();
+        try {
+            task->invoke(task->context);
+        } catch (...) {
+            task->exception = std::current_exception();
+        }
+        lock.lock();
+
+        task->state = State::Done;
+        m_DoneCondition.notify_all();
+    }
+
+    // Nobody will run the jobs left behind
+    while (auto *task = front()) {
+        unlink(*task);
+        task->state = State::Cancelled;
+    }
+    m_DoneCondition.notify_all();
+    LOG_TRACE("TCIO worker stopped.");
+}
+
+} // namespace Regatron
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+namespace Regatron {
+
+/** Lower value runs first, jobs of the same priority run in order. */
+enum class Priority : int {
+    Control    = 0, /** setpoints, output enable and commands */
+    Monitor    = 1, /** actual values, state and acquisition polls */
+    Background = 2  /** flash error history, versions */
+};
+
+/**
+ * Single thread owning every TCIO call.
+ * The TCIO library is a global, non reentrant state machine (DllInit,
+ * DllSearchDevice, the module selector...), callers hand their device access
+ * to this thread and wait for it.
+ * Jobs are queued by priority, a queued control job runs before any queued
+ * monitor or background job. A running job is never interrupted.
+ * Jobs live on the caller stack and are linked into the queues, so running
+ * a job does not allocate.
+ * */
+class TcioWorker {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    /** Wait for as long as needed */
+    static constexpr Clock::duration NO_DEADLINE = Clock::duration::max();
+
+    TcioWorker();
+    TcioWorker(const TcioWorker &) = delete;
+    TcioWorker(TcioWorker &&)      = delete;
+    TcioWorker &operator=(const TcioWorker &) = delete;
+    TcioWorker &operator=(TcioWorker &&) = delete;
+    ~TcioWorker();
+
+    /** Cancel the queued jobs and join the thread. */
+    void stop();
+
+    /**
+     * Run a job on the worker thread and wait for it.
+     * @param deadline: maximum time in the queue, a job that did not start
+     * by then is cancelled. A job that started always runs to the end.
+     * @return: false when the job was cancelled
+     * @throws: whatever the job throws
+     * */
+    template <typename Job>
+    bool run(Priority priority, Clock::duration deadline, Job &&job) {
+        using JobType = std::remove_reference_t<Job>;
+        Task task;
+        task.context = const_cast<void *>(
+            static_cast<const void *>(std::addressof(job)));
+        task.invoke = [](void *context) {
+            (*static_cast<JobType *>(context))();
+        };
+        task.queue = static_cast<std::size_t>(priority);
+        return execute(task, deadline);
+    }
+
+    /** @return: true when called from the worker thread */
+    [[nodiscard]] bool isWorkerThread() const {
+        return std::this_thread::get_id() == m_Thread.get_id();
+    }
+
+  private:
+    enum class State { Queued, Running, Done, Cancelled };
+
+    struct Task {
+        void (*invoke)(void *context) = nullptr;
+        void *             context    = nullptr;
+        std::size_t        queue      = 0; /** Priority */
+        State              state      = State::Queued;
+        std::exception_ptr exception;
+        Task *             prev = nullptr;
+        Task *             next = nullptr;
+    };
+
+    /** Intrusive FIFO */
+    struct Queue {
+        Task *head = nullptr;
+        Task *tail = nullptr;
+    };
+
+    static constexpr std::size_t PRIORITIES = 3;
+
+    bool  execute(Task &task, Clock::duration deadline);
+    void  loop();
+    void  push(Task &task);
+    void  unlink(Task &task);
+    Task *front();
+
+    std::array<Queue, PRIORITIES> m_Queues{};
+    std::mutex                    m_Mutex;
+    std::condition_variable       m_WorkCondition; /** new job or stop */
+    std::condition_variable       m_DoneCondition; /** a job changed state */
+    bool                          m_Stop{false};
+    std::thread                   m_Thread;
+};
+
+} // namespace Regatron
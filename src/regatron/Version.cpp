@@ -1,11 +1,13 @@
 #include "Version.hpp"
 
+#include "Tcio.hpp"
+
 namespace Regatron {
 void Version::ReadDllVersion() {
     unsigned int pDLLMajorMinor{0}; // (xx.68.00) and (03.xx.00)
     unsigned int pDLLBuild{0};      // (03.68.xx)
 
-    if (DllReadVersion(&pDLLMajorMinor, &pDLLBuild, m_DLLString) !=
+    if (TCIO(DllReadVersion)(&pDLLMajorMinor, &pDLLBuild, m_DLLString) !=
         DLL_SUCCESS) {
         throw CommException("failed to initialize tcio lib.");
     }
@@ -19,7 +21,7 @@ void Version::ReadDSPChip() {
     unsigned int pChipRev{0};
     unsigned int pChipSubID{0};
 
-    if (TC4GetDeviceDSPID(&pChipID, &pChipRev, &pChipSubID) !=
+    if (TCIO(TC4GetDeviceDSPID)(&pChipID, &pChipRev, &pChipSubID) !=
         DLL_SUCCESS) {
         throw CommException("failed to read DSP ID.");
     }
@@ -33,7 +35,7 @@ void Version::ReadDSPFirmware() {
     unsigned int vDSPSub{0};
     unsigned int vDSPRevision{0};
 
-    if (TC4GetDeviceVersion(&vDSPMain, &vDSPSub, &vDSPRevision) !=
+    if (TCIO(TC4GetDeviceVersion)(&vDSPMain, &vDSPSub, &vDSPRevision) !=
         DLL_SUCCESS) {
         throw CommException("failed to read Main-DSP firmware version.");
     }
@@ -51,8 +53,9 @@ void Version::ReadDSPBootloader() {
     unsigned int pVersionPeripherieDSP{0};
     unsigned int pVersionModulatorDSP{0};
     unsigned int pVersionBootloader{0};
-    if (TC4GetPeripherieVersion(&pVersionPeripherieDSP, &pVersionModulatorDSP,
-                                   &pVersionBootloader)!= DLL_SUCCESS){
+    if (TCIO(TC4GetPeripherieVersion)(&pVersionPeripherieDSP,
+                                      &pVersionModulatorDSP,
+                                      &pVersionBootloader) != DLL_SUCCESS) {
         throw CommException("failed to read bootloader version.");
     }
     m_BootloaderVersionString = 
@@ -62,7 +65,7 @@ void Version::ReadDSPBootloader() {
 
 void Version::ReadPLDFirmware() {
     unsigned short pVersionPLD{0};
-    if (TC42GetFirmwareVersionPLD(&pVersionPLD) != DLL_SUCCESS) {
+    if (TCIO(TC42GetFirmwareVersionPLD)(&pVersionPLD) != DLL_SUCCESS) {
         throw CommException("Failed to read FirmwareVersionPLD");
     }
     m_PLDVersionString =
@@ -73,7 +76,7 @@ void Version::ReadPLDFirmware() {
 
 void Version::ReadIBCFirmware() {
     unsigned short pVersion;
-    if (TC42GetFirmwareVersionIBC(&pVersion) != DLL_SUCCESS) {
+    if (TCIO(TC42GetFirmwareVersionIBC)(&pVersion) != DLL_SUCCESS) {
         throw CommException("Failed to read IBC Firmware Version.");
     }
     if (pVersion != 0){
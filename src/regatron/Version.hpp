@@ -32,7 +32,7 @@ class Version {
     void ReadDllVersion();
     void ReadDSPVersion();
 
-  private:
+    // Parts of ReadDSPVersion
     void ReadDSPChip();
     void ReadDSPFirmware();
     void ReadDSPBootloader();
@@ -0,0 +1,245 @@
+#include "Device.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace Simulator {
+
+namespace {
+/** TC.P.20.500.400 module: 500V, 40A, 20kW */
+constexpr double MODULE_VOLTAGE_MAX    = 500.;
+constexpr double MODULE_CURRENT_MAX    = 40.;
+constexpr double MODULE_POWER_MAX      = 20.;
+constexpr double MODULE_RESISTANCE_MAX = 1000.;
+} // namespace
+
+Device &Device::Get() {
+    static Device device;
+    return device;
+}
+
+Device::Device() { reset(); }
+
+void Device::reset() {
+    const auto modules = std::max(config.modules, 1U);
+
+    mod               = Unit{};
+    mod.voltageMax    = MODULE_VOLTAGE_MAX;
+    mod.currentMax    = MODULE_CURRENT_MAX;
+    mod.powerMax      = MODULE_POWER_MAX;
+    mod.resistanceMax = MODULE_RESISTANCE_MAX;
+
+    sys            = mod;
+    sys.currentMax = mod.currentMax * modules;
+    sys.powerMax   = mod.powerMax * modules;
+
+    selector           = SYS_SELECTOR;
+    controlIn          = 0;
+    remoteControlInput = 0;
+
+    voltageSlope        = 0;
+    voltageStartupSlope = 0;
+    currentSlope        = 0;
+    currentStartupSlope = 0;
+
+    history.clear();
+    historyCursor = 0;
+
+    scopeChannels   = T_OfflineScopeChannels{};
+    scopeTimeFactor = 1;
+    scopeStatus     = SCOPE_IDLE;
+    scopeSamples    = 0;
+    scopeCursor     = 0;
+
+    pendingFault  = Fault::None;
+    pendingFaults = 0;
+    powerup       = std::chrono::steady_clock::now();
+}
+
+Unit &Device::selected() { return (selector == SYS_SELECTOR) ? sys : mod; }
+
+Output Device::output(bool system) const {
+    Output out;
+    if (controlIn == 0 || state() == STATE_ERROR) {
+        return out;
+    }
+    // Resistive load, the first reference reached limits the output
+    const double load = std::max(config.loadResistance, 1e-3);
+    out.voltage       = std::min({sys.voltageRef, sys.currentRef * load,
+                            std::sqrt(sys.powerRef * 1000. * load)});
+    out.voltage       = std::max(out.voltage, 0.);
+    out.current       = out.voltage / load;
+    out.power         = out.voltage * out.current / 1000.;
+    out.resistance    = load * 1000.;
+
+    if (!system) {
+        const auto modules = static_cast<double>(std::max(config.modules, 1U));
+        out.current /= modules;
+        out.power /= modules;
+        out.resistance *= modules;
+    }
+    return out;
+}
+
+unsigned int Device::state() const {
+    if (sys.error.group != 0 || mod.error.group != 0) {
+        return STATE_ERROR;
+    }
+    if (sys.warning.group != 0 || mod.warning.group != 0) {
+        return STATE_WARNING;
+    }
+    return (controlIn != 0) ? STATE_RUN : STATE_READY;
+}
+
+unsigned int Device::controlMode() const {
+    const double load    = std::max(config.loadResistance, 1e-3);
+    const double voltage = sys.voltageRef;
+    const double current = sys.currentRef * load;
+    const double power   = std::sqrt(sys.powerRef * 1000. * load);
+    if (voltage <= current && voltage <= power) {
+        return MODE_VOLTAGE;
+    }
+    return (current <= power) ? MODE_CURRENT : MODE_POWER;
+}
+
+unsigned long Device::operatingSeconds() const {
+    return POWERUP_OPERATING_SECONDS +
+           static_cast<unsigned long>(
+               std::chrono::duration_cast<std::chrono::seconds>(
+                   std::chrono::steady_clock::now() - powerup)
+                   .count());
+}
+
+Fault Device::nextFault() {
+    if (pendingFaults > 0) {
+        pendingFaults--;
+        return pendingFault;
+    }
+    if (config.failureRate > 0 &&
+        std::uniform_real_distribution<double>{0., 1.}(m_Random) <
+            config.failureRate) {
+        return config.randomFault;
+    }
+    return Fault::None;
+}
+
+bool Device::transfer(std::size_t bytes) {
+    stats.transactions++;
+
+    auto cost = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        config.latency);
+    if (config.jitter.count() > 0) {
+        cost += std::chrono::microseconds{
+            std::uniform_int_distribution<int64_t>{
+                0, config.jitter.count()}(m_Random)};
+    }
+    if (config.transferTime && config.baudrate > 0) {
+        cost += std::chrono::nanoseconds{
+            static_cast<int64_t>(bytes) * BITS_PER_BYTE * 1'000'000'000 /
+            config.baudrate};
+    }
+
+    // Nobody answers: the library waits for its read timeout
+    auto fault = Fault::Timeout;
+    if (initialized && connected && config.present) {
+        fault = nextFault();
+    }
+    auto timeout = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        config.timeout);
+    if (timeout.count() == 0 && readTimeoutMultiplier > 0) {
+        timeout = std::chrono::milliseconds{readTimeoutMultiplier} * bytes;
+        if (fault == Fault::None && cost > timeout) {
+            fault = Fault::Timeout;
+        }
+    }
+    if (fault == Fault::Timeout) {
+        cost = timeout;
+    }
+
+    if (cost.count() > 0) {
+        std::this_thread::sleep_for(cost);
+    }
+    if (fault == Fault::None) {
+        return true;
+    }
+
+    stats.failures++;
+    dllState   = DLL_STATUS_COMMUNICATION_ERROR;
+    dllErrorNo = (fault == Fault::Timeout) ? DLL_ERROR_TIMEOUT
+                                           : DLL_ERROR_NO_RESPONSE;
+    return false;
+}
+
+// ----------------------------- Control API ------------------------------
+void Configure(const Config &config) {
+    Device::Get().local([&] {
+        auto &device = Device::Get();
+        const bool resize = device.config.modules != config.modules;
+        device.config     = config;
+        if (resize) {
+            device.reset();
+        }
+    });
+}
+
+Config GetConfig() {
+    Config config;
+    Device::Get().local([&] { config = Device::Get().config; });
+    return config;
+}
+
+void Reset() {
+    Device::Get().local([] {
+        auto &device = Device::Get();
+        device.reset();
+        device.stats = Stats{};
+    });
+}
+
+Stats GetStats() {
+    Stats stats;
+    Device::Get().local([&] { stats = Device::Get().stats; });
+    return stats;
+}
+
+void ResetStats() {
+    Device::Get().local([] { Device::Get().stats = Stats{}; });
+}
+
+void InjectFault(Fault fault, unsigned count) {
+    Device::Get().local([&] {
+        auto &device         = Device::Get();
+        device.pendingFault  = fault;
+        device.pendingFaults = count;
+    });
+}
+
+void SetErrorTree(bool system, const T_ErrorTree32 &error,
+                  const T_ErrorTree32 &warning) {
+    Device::Get().local([&] {
+        auto &device = Device::Get();
+        auto &unit   = system ? device.sys : device.mod;
+        unit.error   = error;
+        unit.warning = warning;
+    });
+}
+
+void AddErrorHistoryEntry(unsigned group, unsigned detail) {
+    Device::Get().local([&] {
+        auto &device = Device::Get();
+        const auto seconds = device.operatingSeconds();
+
+        T_ErrorHistoryEntry entry{};
+        entry.entryCounter = device.history.size() + 1;
+        entry.day          = static_cast<unsigned int>(seconds / 86400);
+        entry.hour         = static_cast<unsigned int>(seconds / 3600 % 24);
+        entry.minute       = static_cast<unsigned int>(seconds / 60 % 60);
+        entry.second       = static_cast<unsigned int>(seconds % 60);
+        entry.group        = group;
+        entry.detail       = detail;
+        device.history.push_back(entry);
+    });
+}
+
+} // namespace Simulator
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include "Simulator.hpp"
+
+namespace Simulator {
+
+/** System or module side of the module selector. */
+struct Unit {
+    double voltageRef    = 0; // [V]
+    double currentRef    = 0; // [A]
+    double powerRef      = 0; // [kW]
+    double resistanceRef = 0; // [mOhm]
+
+    double voltageMax    = 0; // [V]
+    double currentMax    = 0; // [A]
+    double powerMax      = 0; // [kW]
+    double resistanceMax = 0; // [mOhm]
+
+    T_ErrorTree32 error{};
+    T_ErrorTree32 warning{};
+};
+
+/** Actual values of a Unit. */
+struct Output {
+    double voltage    = 0; // [V]
+    double current    = 0; // [A]
+    double power      = 0; // [kW]
+    double resistance = 0; // [mOhm]
+};
+
+/**
+ * TopCon model behind the simulated serialiolib.h functions.
+ * A single instance, like the TCIO library state it replaces. Every entry
+ * point runs under one mutex, a transaction holds it while it "transfers",
+ * the same way the serial line serializes the real ones.
+ * */
+class Device {
+  public:
+    /** Bytes of a scalar request/response exchange on the wire */
+    static constexpr std::size_t FRAME_BYTES = 16;
+    /** Error and warning trees, group plus 32 details */
+    static constexpr std::size_t TREE_BYTES = 4 + 33 * 4;
+    /** 8N1, 10 bits per byte */
+    static constexpr int BITS_PER_BYTE = 10;
+
+    static constexpr unsigned int SYS_SELECTOR = 64;
+
+    /** Operating hour counter at power on */
+    static constexpr unsigned long POWERUP_OPERATING_SECONDS = 3600UL * 1000UL;
+
+    /** TC4StateActSystem */
+    static constexpr unsigned int STATE_READY   = 4;
+    static constexpr unsigned int STATE_RUN     = 8;
+    static constexpr unsigned int STATE_WARNING = 10;
+    static constexpr unsigned int STATE_ERROR   = 12;
+
+    /** TC4GetControlMode, whichever reference limits the output */
+    static constexpr unsigned int MODE_VOLTAGE = 0;
+    static constexpr unsigned int MODE_CURRENT = 1;
+    static constexpr unsigned int MODE_POWER   = 2;
+
+    /** DllGetStatus */
+    static constexpr int DLL_STATUS_OK                  = 0;
+    static constexpr int DLL_STATUS_COMMUNICATION_ERROR = -10;
+    static constexpr int DLL_ERROR_NO_RESPONSE          = 1;
+    static constexpr int DLL_ERROR_TIMEOUT              = 2;
+
+    /** TC4SetOffLineScopeControl, the capture completes at once */
+    static constexpr unsigned int SCOPE_STOP  = 0;
+    static constexpr unsigned int SCOPE_START = 1;
+    /** TC4GetOffLineScopeStatus */
+    static constexpr unsigned int SCOPE_IDLE = 0;
+    static constexpr unsigned int SCOPE_DONE = 2;
+    /** Offline scope sample period at time factor 1 [s] */
+    static constexpr double SCOPE_PERIOD = 50e-6;
+
+    static Device &Get();
+
+    /** DLL side call, nothing goes on the wire. */
+    template <typename Job> DLL_RESULT local(Job &&job) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return complete(job);
+    }
+
+    /**
+     * Device transaction: pays the link cost, may fail on a fault and only
+     * then runs the job.
+     * A job returning false fails the call without a communication error.
+     * */
+    template <typename Job>
+    DLL_RESULT transaction(Job &&job, std::size_t bytes = FRAME_BYTES) {
+        talkQueue++;
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        const bool transferred = transfer(bytes);
+        talkQueue--;
+        if (!transferred) {
+            return DLL_FAIL;
+        }
+        return complete(job);
+    }
+
+    /** Power on state, keeps the configuration. */
+    void reset();
+
+    Unit &                     selected();
+    [[nodiscard]] Output       output(bool system) const;
+    [[nodiscard]] unsigned int state() const;
+    [[nodiscard]] unsigned int controlMode() const;
+    [[nodiscard]] unsigned long operatingSeconds() const;
+
+    // Everything below is guarded by m_Mutex
+    Config config;
+    Stats  stats;
+
+    bool         initialized = false; /** DllInit */
+    bool         connected   = false; /** DllSearchDevice found the device */
+    int          dllState    = DLL_STATUS_OK;
+    int          dllErrorNo  = 0;
+    unsigned int readTimeoutMultiplier  = 0;
+    unsigned int writeTimeoutMultiplier = 0;
+
+    unsigned int selector           = SYS_SELECTOR;
+    unsigned int controlIn          = 0;
+    unsigned int remoteControlInput = 0;
+    Unit         sys;
+    Unit         mod;
+
+    unsigned int voltageSlope        = 0;
+    unsigned int voltageStartupSlope = 0;
+    unsigned int currentSlope        = 0;
+    unsigned int currentStartupSlope = 0;
+
+    std::vector<T_ErrorHistoryEntry> history;
+    std::size_t                      historyCursor = 0;
+
+    T_OfflineScopeChannels scopeChannels{};
+    unsigned int           scopeTimeFactor = 1;
+    unsigned int           scopeStatus     = SCOPE_IDLE;
+    unsigned int           scopeSamples    = 0; /** valid samples */
+    unsigned int           scopeCursor     = 0; /** next sample read */
+
+    Fault    pendingFault  = Fault::None;
+    unsigned pendingFaults = 0;
+
+    std::chrono::steady_clock::time_point powerup;
+
+    bool fastDetection = false; /** DllSetComPortFastDetection */
+
+    /** DllGetTalkQueueCount: transactions on the wire or waiting for it */
+    std::atomic<unsigned int> talkQueue{0};
+
+    // DllSearchDevice state, read and written without the mutex while a
+    // search runs
+    std::atomic<int>  searchProgress{-1};
+    std::atomic<bool> searchAborted{false};
+
+  private:
+    Device();
+
+    template <typename Job> static DLL_RESULT complete(Job &job) {
+        if constexpr (std::is_same_v<std::invoke_result_t<Job &>, bool>) {
+            return job() ? DLL_SUCCESS : DLL_FAIL;
+        } else {
+            job();
+            return DLL_SUCCESS;
+        }
+    }
+
+    /** @return: false when the transaction failed */
+    bool  transfer(std::size_t bytes);
+    Fault nextFault();
+
+    std::mutex   m_Mutex;
+    std::mt19937 m_Random{0x7c10};
+};
+
+} // namespace Simulator
@@ -0,0 +1,642 @@
+/**
+ * serialiolib.h entry points, as used by the regatron target.
+ * DLL calls only touch the library state, TC4 calls are device transactions
+ * and go through the simulated link.
+ * */
+#include "serialiolib.h" // NOLINT
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#include "Device.hpp"
+
+using Simulator::Device;
+
+namespace {
+constexpr double NORM_MAX = 4000.;
+
+constexpr unsigned int DLL_VERSION = (3U << 16U) | 80U;
+constexpr unsigned int DLL_BUILD   = 0;
+constexpr const char * DLL_STRING  = "TCIO simulator";
+
+/** TC4GetAdditionalPhysicalValues */
+constexpr int DC_LINK_PHYS_NOM         = 800; // [V]
+constexpr int PRIMARY_CURRENT_PHYS_NOM = 100; // [A]
+constexpr int TEMPERATURE_PHYS_NOM     = 100; // [°C]
+
+int Digital(double value, double nominal) {
+    return static_cast<int>(std::lround(value * NORM_MAX / nominal));
+}
+
+/** Set a reference of the selected unit, out of range values are refused */
+DLL_RESULT SetRef(double Simulator::Unit::*ref, double Simulator::Unit::*max,
+                  double value) {
+    return Device::Get().transaction([=] {
+        auto &unit = Device::Get().selected();
+        if (value < 0 || value > unit.*max) {
+            return false;
+        }
+        unit.*ref = value;
+        return true;
+    });
+}
+
+DLL_RESULT GetRef(double Simulator::Unit::*ref, double *pValue) {
+    return Device::Get().transaction(
+        [=] { *pValue = Device::Get().selected().*ref; });
+}
+
+DLL_RESULT GetAct(double Simulator::Output::*value, double *pValue) {
+    return Device::Get().transaction([=] {
+        auto &device = Device::Get();
+        *pValue = device.output(device.selector == Device::SYS_SELECTOR).*value;
+    });
+}
+
+/** Limits of a unit, scaled: 0 for the minimum, 1 for the maximum */
+void GetLimits(const Simulator::Unit &unit, double scale, double *pVoltage,
+               double *pCurrent, double *pPower, double *pResistance) {
+    *pVoltage    = unit.voltageMax * scale;
+    *pCurrent    = unit.currentMax * scale;
+    *pPower      = unit.powerMax * scale;
+    *pResistance = unit.resistanceMax * scale;
+}
+} // namespace
+
+// ------------------------------- DLL ------------------------------------
+DLL_RESULT DllInit() {
+    return Device::Get().local([] {
+        auto &device         = Device::Get();
+        device.initialized   = true;
+        device.connected     = false;
+        device.fastDetection = false;
+        device.dllState      = Device::DLL_STATUS_OK;
+        device.dllErrorNo    = 0;
+    });
+}
+
+DLL_RESULT DllClose() {
+    return Device::Get().local([] {
+        auto &device       = Device::Get();
+        device.initialized = false;
+        device.connected   = false;
+    });
+}
+
+DLL_RESULT DllSetSearchDevice2ttyDIGI() {
+    return Device::Get().local([] { return Device::Get().initialized; });
+}
+
+DLL_RESULT DllSearchDevice(int fromPort, int toPort, int *pPortNrFound) {
+    auto &device  = Device::Get();
+    *pPortNrFound = -1;
+    if (fromPort > toPort) {
+        return DLL_FAIL;
+    }
+
+    // Port by port, progress and abort are used while it runs
+    device.searchAborted = false;
+    for (int port = fromPort; port <= toPort && !device.searchAborted;
+         port++) {
+        device.searchProgress = port;
+        bool found            = false;
+        auto probe            = std::chrono::milliseconds{0};
+        const auto result     = device.local([&] {
+            if (!device.initialized) {
+                return false;
+            }
+            device.stats.searchedPorts++;
+            probe = device.config.portProbe /
+                    (device.fastDetection ? Simulator::FAST_DETECTION_SPEEDUP
+                                          : 1);
+            found = device.config.present &&
+                    (device.config.port == 0 || device.config.port == port);
+            device.connected = found;
+            return true;
+        });
+        std::this_thread::sleep_for(probe);
+        if (result != DLL_SUCCESS) {
+            device.searchProgress = -1;
+            return DLL_FAIL;
+        }
+        if (found) {
+            *pPortNrFound = port;
+            break;
+        }
+    }
+    device.searchProgress = -1;
+    return DLL_SUCCESS;
+}
+
+DLL_RESULT DllAbortDeviceSearch() {
+    Device::Get().searchAborted = true;
+    return DLL_SUCCESS;
+}
+
+DLL_RESULT DllGetDeviceSearchProgress(int *pComPort) {
+    *pComPort = Device::Get().searchProgress;
+    return DLL_SUCCESS;
+}
+
+DLL_RESULT DllSetComPortFastDetection(unsigned int fastDetection) {
+    return Device::Get().local(
+        [=] { Device::Get().fastDetection = fastDetection != 0; });
+}
+
+DLL_RESULT DllGetStatus(int *pState, int *pErrorNo) {
+    return Device::Get().local([=] {
+        *pState   = Device::Get().dllState;
+        *pErrorNo = Device::Get().dllErrorNo;
+    });
+}
+
+DLL_RESULT DllReadVersion(unsigned int *pVersion, unsigned int *pBuild,
+                          char *pString) {
+    *pVersion = DLL_VERSION;
+    *pBuild   = DLL_BUILD;
+    std::strncpy(pString, DLL_STRING, DLL_VERSIONSTRING_COPY_LENGTH - 1);
+    pString[DLL_VERSIONSTRING_COPY_LENGTH - 1] = '\0';
+    return DLL_SUCCESS;
+}
+
+DLL_RESULT DllGetCommBaudrate(int *pActBaudRate) {
+    return Device::Get().local(
+        [=] { *pActBaudRate = Device::Get().config.baudrate; });
+}
+
+DLL_RESULT DllSetCommTimeouts(unsigned int ReadTimeoutMultiplier,
+                              unsigned int WriteTimeoutMultiplier) {
+    return Device::Get().local([=] {
+        Device::Get().readTimeoutMultiplier  = ReadTimeoutMultiplier;
+        Device::Get().writeTimeoutMultiplier = WriteTimeoutMultiplier;
+    });
+}
+
+DLL_RESULT DllGetCommTimeouts(unsigned int *pReadTimeoutMultiplier,
+                              unsigned int *pWriteTimeoutMultiplier) {
+    return Device::Get().local([=] {
+        *pReadTimeoutMultiplier  = Device::Get().readTimeoutMultiplier;
+        *pWriteTimeoutMultiplier = Device::Get().writeTimeoutMultiplier;
+    });
+}
+
+DLL_RESULT DllGetTalkQueueCount(unsigned int *pTalkQueueCount,
+                                unsigned int *pTalkQueueSendBytesCount,
+                                unsigned int *pTalkQueueReceiveBytesCount) {
+    // Without the mutex, a transaction on the wire holds it
+    const unsigned int count = Device::Get().talkQueue;
+    const unsigned int bytes =
+        count * static_cast<unsigned int>(Device::FRAME_BYTES);
+    *pTalkQueueCount             = count;
+    *pTalkQueueSendBytesCount    = bytes;
+    *pTalkQueueReceiveBytesCount = bytes;
+    return DLL_SUCCESS;
+}
+
+// ----------------------------- Identity ---------------------------------
+DLL_RESULT TC4GetSerialNr(unsigned long *pSerialNr) {
+    return Device::Get().transaction(
+        [=] { *pSerialNr = Device::Get().config.serialNr; });
+}
+
+DLL_RESULT TC4GetModuleID(unsigned int *pModuleID) {
+    return Device::Get().transaction(
+        [=] { *pModuleID = Device::Get().config.moduleId; });
+}
+
+DLL_RESULT TC4GetDeviceDSPID(unsigned int *pChipID, unsigned int *pChipRev,
+                             unsigned int *pChipSubID) {
+    return Device::Get().transaction([=] {
+        *pChipID    = 0x0048;
+        *pChipRev   = 1;
+        *pChipSubID = 0;
+    });
+}
+
+DLL_RESULT TC4GetDeviceVersion(unsigned int *pMain, unsigned int *pSub,
+                               unsigned int *pRevision) {
+    return Device::Get().transaction([=] {
+        *pMain     = 4;
+        *pSub      = 20;
+        *pRevision = 60;
+    });
+}
+
+DLL_RESULT TC4GetPeripherieVersion(unsigned int *pVersionPeripherieDSP,
+                                   unsigned int *pVersionModulatorDSP,
+                                   unsigned int *pVersionBootloader) {
+    return Device::Get().transaction([=] {
+        *pVersionPeripherieDSP = 0;
+        *pVersionModulatorDSP  = 0;
+        *pVersionBootloader    = 414;
+    });
+}
+
+DLL_RESULT TC42GetFirmwareVersionPLD(unsigned short *pVersionPLD) {
+    return Device::Get().transaction([=] { *pVersionPLD = 209; });
+}
+
+DLL_RESULT TC42GetFirmwareVersionIBC(unsigned short *pVersionIBC) {
+    // No IBC board
+    return Device::Get().transaction([=] { *pVersionIBC = 0; });
+}
+
+// ------------------------------ Limits ----------------------------------
+DLL_RESULT TC4GetAdditionalPhysicalValues(int *pDCLinkPhysNom,
+                                          int *pPrimaryCurrentPhysNom,
+                                          int *pTemperaturePhysNom) {
+    return Device::Get().transaction([=] {
+        *pDCLinkPhysNom         = DC_LINK_PHYS_NOM;
+        *pPrimaryCurrentPhysNom = PRIMARY_CURRENT_PHYS_NOM;
+        *pTemperaturePhysNom    = TEMPERATURE_PHYS_NOM;
+    });
+}
+
+DLL_RESULT TC4GetSystemPhysicalLimitMax(double *pVoltage, double *pCurrent,
+                                        double *pPower, double *pResistance) {
+    return Device::Get().transaction([=] {
+        GetLimits(Device::Get().sys, 1., pVoltage, pCurrent, pPower,
+                  pResistance);
+    });
+}
+
+DLL_RESULT TC4GetSystemPhysicalLimitMin(double *pVoltage, double *pCurrent,
+                                        double *pPower, double *pResistance) {
+    return Device::Get().transaction([=] {
+        GetLimits(Device::Get().sys, 0., pVoltage, pCurrent, pPower,
+                  pResistance);
+    });
+}
+
+DLL_RESULT TC4GetSystemPhysicalLimitNom(double *pVoltage, double *pCurrent,
+                                        double *pPower, double *pResistance) {
+    return TC4GetSystemPhysicalLimitMax(pVoltage, pCurrent, pPower,
+                                        pResistance);
+}
+
+DLL_RESULT TC4GetModulePhysicalLimitMax(double *pVoltage, double *pCurrent,
+                                        double *pPower, double *pResistance) {
+    return Device::Get().transaction([=] {
+        GetLimits(Device::Get().mod, 1., pVoltage, pCurrent, pPower,
+                  pResistance);
+    });
+}
+
+DLL_RESULT TC4GetModulePhysicalLimitMin(double *pVoltage, double *pCurrent,
+                                        double *pPower, double *pResistance) {
+    return Device::Get().transaction([=] {
+        GetLimits(Device::Get().mod, 0., pVoltage, pCurrent, pPower,
+                  pResistance);
+    });
+}
+
+DLL_RESULT TC4GetModulePhysicalLimitNom(double *pVoltage, double *pCurrent,
+                                        double *pPower, double *pResistance) {
+    return TC4GetModulePhysicalLimitMax(pVoltage, pCurrent, pPower,
+                                        pResistance);
+}
+
+DLL_RESULT TC4GetPhysicalValuesIncrement(double *pIncModV, double *pIncModC,
+                                         double *pIncModP, double *pIncModR,
+                                         double *pIncSysV, double *pIncSysC,
+                                         double *pIncSysP, double *pIncSysR) {
+    return Device::Get().transaction([=] {
+        const auto &device = Device::Get();
+        *pIncModV          = device.mod.voltageMax / NORM_MAX;
+        *pIncModC          = device.mod.currentMax / NORM_MAX;
+        *pIncModP          = device.mod.powerMax / NORM_MAX;
+        *pIncModR          = device.mod.resistanceMax / NORM_MAX;
+        *pIncSysV          = device.sys.voltageMax / NORM_MAX;
+        *pIncSysC          = device.sys.currentMax / NORM_MAX;
+        *pIncSysP          = device.sys.powerMax / NORM_MAX;
+        *pIncSysR          = device.sys.resistanceMax / NORM_MAX;
+    });
+}
+
+// --------------------------- Actual values ------------------------------
+DLL_RESULT TC4GetVoltageAct(double *pVoltageAct) {
+    return GetAct(&Simulator::Output::voltage, pVoltageAct);
+}
+
+DLL_RESULT TC4GetCurrentAct(double *pCurrentAct) {
+    return GetAct(&Simulator::Output::current, pCurrentAct);
+}
+
+DLL_RESULT TC4GetPowerAct(double *pPowerAct) {
+    return GetAct(&Simulator::Output::power, pPowerAct);
+}
+
+DLL_RESULT TC4GetResistanceAct(double *pResistanceAct) {
+    return GetAct(&Simulator::Output::resistance, pResistanceAct);
+}
+
+DLL_RESULT TC4GetVoltageActSense(double *pVolategeActSense) {
+    return GetAct(&Simulator::Output::voltage, pVolategeActSense);
+}
+
+DLL_RESULT TC4GetPowerActSense(double *pPowerActSense) {
+    return GetAct(&Simulator::Output::power, pPowerActSense);
+}
+
+DLL_RESULT TC4GetMeasurementDigitalValues(int *pVoltage, int *pCurrent) {
+    return Device::Get().transaction([=] {
+        const auto &device = Device::Get();
+        const auto  output = device.output(false);
+        *pVoltage          = Digital(output.voltage, device.mod.voltageMax);
+        *pCurrent          = Digital(output.current, device.mod.currentMax);
+    });
+}
+
+DLL_RESULT TC4GetDCLinkDigital(int *pDCLinkVoltage) {
+    return Device::Get().transaction([=] {
+        *pDCLinkVoltage =
+            Digital(Device::Get().config.dcLinkVoltage, DC_LINK_PHYS_NOM);
+    });
+}
+
+DLL_RESULT TC4GetIPrimDigital(int *pPrimaryCurrent) {
+    return Device::Get().transaction([=] {
+        const auto &device = Device::Get();
+        const double current =
+            device.output(false).power * 1000. / device.config.dcLinkVoltage;
+        *pPrimaryCurrent = Digital(current, PRIMARY_CURRENT_PHYS_NOM);
+    });
+}
+
+DLL_RESULT TC4GetTempDigital(int *pIgbtTemp, int *pRectifierTemp) {
+    return Device::Get().transaction([=] {
+        const auto &config = Device::Get().config;
+        *pIgbtTemp         = Digital(config.temperature, TEMPERATURE_PHYS_NOM);
+        *pRectifierTemp    = Digital(config.temperature, TEMPERATURE_PHYS_NOM);
+    });
+}
+
+DLL_RESULT TC42GetTemperaturePCB(double *pTemperaturePCB) {
+    return Device::Get().transaction(
+        [=] { *pTemperaturePCB = Device::Get().config.temperature; });
+}
+
+// ---------------------------- References --------------------------------
+DLL_RESULT TC4SetVoltageRef(double voltageRef) {
+    return SetRef(&Simulator::Unit::voltageRef, &Simulator::Unit::voltageMax,
+                  voltageRef);
+}
+
+DLL_RESULT TC4SetCurrentRef(double currentRef) {
+    return SetRef(&Simulator::Unit::currentRef, &Simulator::Unit::currentMax,
+                  currentRef);
+}
+
+DLL_RESULT TC4SetPowerRef(double powerRef) {
+    return SetRef(&Simulator::Unit::powerRef, &Simulator::Unit::powerMax,
+                  powerRef);
+}
+
+DLL_RESULT TC4SetResistanceRef(double resistanceRef) {
+    return SetRef(&Simulator::Unit::resistanceRef,
+                  &Simulator::Unit::resistanceMax, resistanceRef);
+}
+
+DLL_RESULT TC4GetVoltageRef(double *pVoltageRef) {
+    return GetRef(&Simulator::Unit::voltageRef, pVoltageRef);
+}
+
+DLL_RESULT TC4GetCurrentRef(double *pCurrentRef) {
+    return GetRef(&Simulator::Unit::currentRef, pCurrentRef);
+}
+
+DLL_RESULT TC4GetPowerRef(double *pPowerRef) {
+    return GetRef(&Simulator::Unit::powerRef, pPowerRef);
+}
+
+DLL_RESULT TC4GetResistanceRef(double *pResistanceRef) {
+    return GetRef(&Simulator::Unit::resistanceRef, pResistanceRef);
+}
+
+// ------------------------- State and control ----------------------------
+DLL_RESULT TC4SetModuleSelector(unsigned int moduleSelector) {
+    return Device::Get().transaction([=] {
+        auto &device = Device::Get();
+        device.stats.selectorWrites++;
+        device.selector = moduleSelector;
+    });
+}
+
+DLL_RESULT TC4StateActSystem(unsigned int *pState) {
+    return Device::Get().transaction([=] { *pState = Device::Get().state(); });
+}
+
+DLL_RESULT TC4GetControlMode(unsigned int *pControlMode) {
+    return Device::Get().transaction(
+        [=] { *pControlMode = Device::Get().controlMode(); });
+}
+
+DLL_RESULT TC4SetControlIn(unsigned int voltageOn) {
+    return Device::Get().transaction(
+        [=] { Device::Get().controlIn = (voltageOn != 0) ? 1 : 0; });
+}
+
+DLL_RESULT TC4GetControlIn(unsigned int *pVoltageOn) {
+    return Device::Get().transaction(
+        [=] { *pVoltageOn = Device::Get().controlIn; });
+}
+
+DLL_RESULT TC4SetRemoteControlInput(unsigned int remoteControlInput) {
+    return Device::Get().transaction(
+        [=] { Device::Get().remoteControlInput = remoteControlInput; });
+}
+
+DLL_RESULT TC4GetRemoteControlInput(unsigned int *pRemoteControlInput) {
+    return Device::Get().transaction(
+        [=] { *pRemoteControlInput = Device::Get().remoteControlInput; });
+}
+
+DLL_RESULT TC4ClearError() {
+    return Device::Get().transaction([] {
+        auto &device = Device::Get();
+        for (auto *unit : {&device.sys, &device.mod}) {
+            unit->error   = T_ErrorTree32{};
+            unit->warning = T_ErrorTree32{};
+        }
+    });
+}
+
+DLL_RESULT TC4StoreParameters() {
+    return Device::Get().transaction([] {});
+}
+
+// ------------------------------ Slopes ----------------------------------
+DLL_RESULT TC4SetVoltageSlopeRamp(unsigned int slope,
+                                  unsigned int startupSlope) {
+    return Device::Get().transaction([=] {
+        Device::Get().voltageSlope        = slope;
+        Device::Get().voltageStartupSlope = startupSlope;
+    });
+}
+
+DLL_RESULT TC4GetVoltageSlopeRamp(unsigned int *pSlope,
+                                  unsigned int *pStartupSlope) {
+    return Device::Get().transaction([=] {
+        *pSlope        = Device::Get().voltageSlope;
+        *pStartupSlope = Device::Get().voltageStartupSlope;
+    });
+}
+
+DLL_RESULT TC4SetCurrentSlopeRamp(unsigned int slope,
+                                  unsigned int startupSlope) {
+    return Device::Get().transaction([=] {
+        Device::Get().currentSlope        = slope;
+        Device::Get().currentStartupSlope = startupSlope;
+    });
+}
+
+DLL_RESULT TC4GetCurrentSlopeRamp(unsigned int *pSlope,
+                                  unsigned int *pStartupSlope) {
+    return Device::Get().transaction([=] {
+        *pSlope        = Device::Get().currentSlope;
+        *pStartupSlope = Device::Get().currentStartupSlope;
+    });
+}
+
+// --------------------------- Error trees --------------------------------
+DLL_RESULT TC4ReadErrorTree32(struct T_ErrorTree32 *pErrorTree32) {
+    return Device::Get().transaction(
+        [=] { *pErrorTree32 = Device::Get().selected().error; },
+        Device::TREE_BYTES);
+}
+
+DLL_RESULT TC4ReadWarningTree32(struct T_ErrorTree32 *pWarnTree32) {
+    return Device::Get().transaction(
+        [=] { *pWarnTree32 = Device::Get().selected().warning; },
+        Device::TREE_BYTES);
+}
+
+// ------------------------ Flash error history ---------------------------
+DLL_RESULT TC4GetFlashErrorHistorySize(unsigned int *nEntries) {
+    return Device::Get().transaction([=] {
+        *nEntries = static_cast<unsigned int>(Device::Get().history.size());
+    });
+}
+
+DLL_RESULT TC4GetFlashErrorHistoryFirstEntry(struct T_ErrorHistoryEntry *entry,
+                                             signed int *error) {
+    Device::Get().local([] { Device::Get().historyCursor = 0; });
+    return TC4GetFlashErrorHistoryNextEntry(entry, error);
+}
+
+DLL_RESULT TC4GetFlashErrorHistoryNextEntry(struct T_ErrorHistoryEntry *entry,
+                                            signed int *error) {
+    return Device::Get().transaction([=] {
+        auto &device = Device::Get();
+        if (device.historyCursor >= device.history.size()) {
+            *error = -1;
+            return false;
+        }
+        *entry = device.history[device.historyCursor++];
+        *error = 0;
+        return true;
+    });
+}
+
+// --------------------------- Offline scope ------------------------------
+DLL_RESULT
+TC4SetOffLineScopeChannels(struct T_OfflineScopeChannels *p_Channels) {
+    return Device::Get().transaction([=] {
+        if (p_Channels->NumOfChannel == 0 || p_Channels->NumOfChannel > 8) {
+            return false;
+        }
+        Device::Get().scopeChannels = *p_Channels;
+        return true;
+    });
+}
+
+DLL_RESULT
+TC4GetOffLineScopeChannels(struct T_OfflineScopeChannels *p_Channels) {
+    return Device::Get().transaction(
+        [=] { *p_Channels = Device::Get().scopeChannels; });
+}
+
+DLL_RESULT TC4SetOffLineScopeChannelFactors() {
+    return Device::Get().local([] {});
+}
+
+DLL_RESULT TC4SetOffLineScopeTimeFactor(unsigned int Time) {
+    return Device::Get().transaction([=] {
+        if (Time == 0) {
+            return false;
+        }
+        Device::Get().scopeTimeFactor = Time;
+        return true;
+    });
+}
+
+DLL_RESULT TC4SetOffLineScopeControl(unsigned int Control) {
+    return Device::Get().transaction([=] {
+        auto &device = Device::Get();
+        if (Control == Device::SCOPE_START) {
+            device.scopeStatus  = Device::SCOPE_DONE;
+            device.scopeSamples = device.config.scopeSamples;
+        } else {
+            device.scopeStatus  = Device::SCOPE_IDLE;
+            device.scopeSamples = 0;
+        }
+        device.scopeCursor = 0;
+    });
+}
+
+DLL_RESULT TC4GetOffLineScopeStatus(unsigned int *pStatus) {
+    return Device::Get().transaction(
+        [=] { *pStatus = Device::Get().scopeStatus; });
+}
+
+DLL_RESULT TC4GetOffLineScopeNumOfValidSamples(unsigned int *pNumOfSamples) {
+    return Device::Get().transaction(
+        [=] { *pNumOfSamples = Device::Get().scopeSamples; });
+}
+
+DLL_RESULT TC4GetOffLineScopeValue(struct T_OfflineScopeData *entry,
+                                   unsigned int *             pNumOfReads) {
+    auto &device = Device::Get();
+    return device.transaction(
+        [=, &device] {
+            const std::array<unsigned int, 8> addresses{
+                device.scopeChannels.pChannel1, device.scopeChannels.pChannel2,
+                device.scopeChannels.pChannel3, device.scopeChannels.pChannel4,
+                device.scopeChannels.pChannel5, device.scopeChannels.pChannel6,
+                device.scopeChannels.pChannel7, device.scopeChannels.pChannel8};
+            const std::array<double *, 8> values{
+                entry->Channel1, entry->Channel2, entry->Channel3,
+                entry->Channel4, entry->Channel5, entry->Channel6,
+                entry->Channel7, entry->Channel8};
+
+            const auto reads =
+                std::min(8U, device.scopeSamples - device.scopeCursor);
+            for (unsigned int i = 0; i < reads; i++) {
+                const auto n        = device.scopeCursor + i;
+                entry->Status[i]    = device.scopeStatus;
+                entry->TimeStamp[i] = n * device.scopeTimeFactor *
+                                      Device::SCOPE_PERIOD;
+                for (unsigned int c = 0; c < 8; c++) {
+                    values[c][i] = c < device.scopeChannels.NumOfChannel
+                                       ? addresses[c] + n
+                                       : 0.;
+                }
+            }
+            device.scopeCursor += reads;
+            *pNumOfReads = reads;
+        },
+        sizeof(T_OfflineScopeData));
+}
+
+DLL_RESULT TC4GetOperatingSeconds(unsigned long *seconds) {
+    return Device::Get().transaction(
+        [=] { *seconds = Device::Get().operatingSeconds(); });
+}
+
+DLL_RESULT TC4GetPowerupTime(unsigned long *seconds) {
+    return Device::Get().transaction(
+        [=] { *seconds = Device::POWERUP_OPERATING_SECONDS; });
+}
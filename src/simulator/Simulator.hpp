@@ -0,0 +1,95 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "serialiolib.h" // NOLINT
+
+/**
+ * Simulated TCIO backend.
+ * The tcio_simulator library implements the serialiolib.h functions used by
+ * the regatron target against an in-process TopCon model, so the server can
+ * be run, tested and benchmarked without a device (-DENABLE_SIMULATOR=ON).
+ * This namespace is the control side, used by tests and benchmarks to shape
+ * the link and the device.
+ * */
+namespace Simulator {
+
+enum class Fault {
+    None,
+    CommunicationError, /** fails at once, DllGetStatus reports -10 */
+    Timeout             /** fails after Config::timeout, same status */
+};
+
+/** DllSearchDevice speedup with DllSetComPortFastDetection */
+constexpr int FAST_DETECTION_SPEEDUP = 10;
+
+struct Config {
+    /** Fixed cost of every device transaction */
+    std::chrono::microseconds latency{0};
+    /** Uniformly distributed extra cost, [0, jitter] */
+    std::chrono::microseconds jitter{0};
+    /** Reported by DllGetCommBaudrate */
+    int baudrate = 38400;
+    /** Add the time the frames take on the wire at baudrate */
+    bool transferTime = false;
+    /**
+     * Time lost by a Fault::Timeout transaction. 0: the read timeout
+     * multiplier in ms per byte of the frame, like the library, and slower
+     * transactions time out.
+     * */
+    std::chrono::milliseconds timeout{100};
+
+    /** Probability of a random fault on each transaction, [0, 1] */
+    double failureRate = 0;
+    Fault  randomFault = Fault::CommunicationError;
+
+    /** Whether DllSearchDevice finds the device, clear it to power it off */
+    bool present = true;
+    /** DLL port number the device answers on, 0 for any port */
+    int port = 0;
+    /** DllSearchDevice time per port, see FAST_DETECTION_SPEEDUP */
+    std::chrono::milliseconds portProbe{0};
+
+    unsigned long serialNr = 100001; /** TC4GetSerialNr */
+    unsigned      moduleId = 0;      /** 0: master */
+    unsigned      modules  = 1; /** modules in parallel, sharing the current */
+
+    double loadResistance = 1.;   /** [Ohm] */
+    double dcLinkVoltage  = 650.; /** [V] */
+    double temperature    = 35.;  /** [°C] */
+
+    /**
+     * Offline scope capture, sample n of a channel at DSP address a reads
+     * a + n, taken every Device::SCOPE_PERIOD times the time factor
+     * */
+    unsigned scopeSamples = 1000;
+};
+
+struct Stats {
+    uint64_t transactions   = 0; /** device transactions, failed included */
+    uint64_t failures       = 0;
+    uint64_t selectorWrites = 0; /** TC4SetModuleSelector calls */
+    uint64_t searchedPorts  = 0; /** ports probed by DllSearchDevice */
+};
+
+void   Configure(const Config &config);
+Config GetConfig();
+
+/** Back to the power on device state, keeps the configuration. */
+void Reset();
+
+Stats GetStats();
+void  ResetStats();
+
+/** The next `count` transactions fail with `fault`. */
+void InjectFault(Fault fault, unsigned count = 1);
+
+/** Raise errors and warnings, the device goes to the ERROR state. */
+void SetErrorTree(bool system, const T_ErrorTree32 &error,
+                  const T_ErrorTree32 &warning);
+
+/** Append an entry to the flash error history. */
+void AddErrorHistoryEntry(unsigned group, unsigned detail);
+
+} // namespace Simulator
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <fmt/format.h>
+
+namespace Utils {
+/**
+ * RFC 4648 base64, with padding. Carries binary data in the new line
+ * delimited text protocol: the encoded text has no '\n' nor ';'.
+ * */
+namespace Base64 {
+constexpr std::string_view ALPHABET =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+constexpr char PAD = '=';
+
+/** Appends the encoding of data to out */
+inline void Encode(fmt::memory_buffer &out, std::string_view data) {
+    const auto byte = [&data](std::size_t i) -> std::uint32_t {
+        return static_cast<unsigned char>(data[i]);
+    };
+    std::size_t i = 0;
+    for (; i + 3 <= data.size(); i += 3) {
+        const auto word = (byte(i) << 16U) | (byte(i + 1) << 8U) | byte(i + 2);
+        out.push_back(ALPHABET[(word >> 18U) & 0x3FU]);
+        out.push_back(ALPHABET[(word >> 12U) & 0x3FU]);
+        out.push_back(ALPHABET[(word >> 6U) & 0x3FU]);
+        out.push_back(ALPHABET[word & 0x3FU]);
+    }
+    const auto rest = data.size() - i;
+    if (rest == 0) {
+        return;
+    }
+    const auto word = (byte(i) << 16U) | (rest == 2 ? byte(i + 1) << 8U : 0U);
+    out.push_back(ALPHABET[(word >> 18U) & 0x3FU]);
+    out.push_back(ALPHABET[(word >> 12U) & 0x3FU]);
+    out.push_back(rest == 2 ? ALPHABET[(word >> 6U) & 0x3FU] : PAD);
+    out.push_back(PAD);
+}
+
+/** @return: nullopt when text is not padded base64 */
+inline std::optional<std::string> Decode(std::string_view text) {
+    if (text.size() % 4 != 0) {
+        return {};
+    }
+    std::array<int, 256> values{};
+    values.fill(-1);
+    for (std::size_t i = 0; i < ALPHABET.size(); i++) {
+        values[static_cast<unsigned char>(ALPHABET[i])] = static_cast<int>(i);
+    }
+
+    std::string data;
+    data.reserve(text.size() / 4 * 3);
+    for (std::size_t i = 0; i < text.size(); i += 4) {
+        const bool  last = i + 4 == text.size();
+        std::size_t pad  = 0;
+        if (last) {
+            pad = text[i + 3] == PAD ? (text[i + 2] == PAD ? 2 : 1) : 0;
+        }
+        std::uint32_t word = 0;
+        for (std::size_t j = 0; j < 4; j++) {
+            const auto character = static_cast<unsigned char>(text[i + j]);
+            const auto value     = j >= 4 - pad ? 0 : values[character];
+            if (value < 0) {
+                return {};
+            }
+            word = (word << 6U) | static_cast<std::uint32_t>(value);
+        }
+        data.push_back(static_cast<char>((word >> 16U) & 0xFFU));
+        if (pad < 2) {
+            data.push_back(static_cast<char>((word >> 8U) & 0xFFU));
+        }
+        if (pad < 1) {
+            data.push_back(static_cast<char>(word & 0xFFU));
+        }
+    }
+    return data;
+}
+} // namespace Base64
+} // namespace Utils
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+#include <fmt/format.h>
+
+namespace Utils {
+/**
+ * Little endian unsigned integers and doubles, whatever the host order: the
+ * wire encoding of the binary protocol and of the offline scope waveform.
+ * */
+namespace LittleEndian {
+
+template <typename T> void Put(fmt::memory_buffer &out, T value) {
+    static_assert(std::is_unsigned_v<T>);
+    for (std::size_t i = 0; i < sizeof(T); i++) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFFU));
+    }
+}
+
+inline void PutF64(fmt::memory_buffer &out, double value) {
+    Put(out, std::bit_cast<std::uint64_t>(value));
+}
+
+/** Reads from the front of in, false when too short */
+template <typename T> bool Get(std::string_view &in, T &value) {
+    static_assert(std::is_unsigned_v<T> && sizeof(T) <= sizeof(std::uint64_t));
+    if (in.size() < sizeof(T)) {
+        return false;
+    }
+    // Built in 64 bits, narrow types would be promoted to int
+    std::uint64_t bits = 0;
+    for (std::size_t i = 0; i < sizeof(T); i++) {
+        bits |= std::uint64_t{static_cast<unsigned char>(in[i])} << (8 * i);
+    }
+    value = static_cast<T>(bits);
+    in.remove_prefix(sizeof(T));
+    return true;
+}
+
+inline bool GetF64(std::string_view &in, double &value) {
+    std::uint64_t bits = 0;
+    if (!Get(in, bits)) {
+        return false;
+    }
+    value = std::bit_cast<double>(bits);
+    return true;
+}
+} // namespace LittleEndian
+} // namespace Utils
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace Utils {
+/**
+ * Single writer, multiple readers sequence lock.
+ * Readers never block the writer, a read that overlaps a write is retried.
+ * The value is kept as relaxed atomic words so a torn read is never observed
+ * as a data race, only discarded by the sequence check.
+ * */
+template <typename T> class SeqLock {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "SeqLock value must be trivially copyable");
+
+    using Word = std::uint64_t;
+    static constexpr std::size_t N =
+        (sizeof(T) + sizeof(Word) - 1) / sizeof(Word);
+
+  public:
+    SeqLock() { store(T{}); }
+
+    /** Must not be called concurrently with another store. */
+    void store(const T &value) {
+        std::array<Word, N> words{};
+        std::memcpy(words.data(), &value, sizeof(T));
+
+        const auto sequence = m_Sequence.load(std::memory_order_relaxed);
+        m_Sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i = 0; i < N; i++) {
+            m_Words[i].store(words[i], std::memory_order_relaxed);
+        }
+        m_Sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    [[nodiscard]] T load() const {
+        T value;
+        while (!tryLoad(value)) {
+        }
+        return value;
+    }
+
+    /**
+     * Single attempt, for readers that must not spin on a writer that may
+     * never finish, e.g. another process.
+     * @return: false when the read overlapped a write, value is unchanged
+     * */
+    [[nodiscard]] bool tryLoad(T &value) const {
+        std::array<Word, N> words{};
+        const auto before = m_Sequence.load(std::memory_order_acquire);
+        for (std::size_t i = 0; i < N; i++) {
+            words[i] = m_Words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const auto after = m_Sequence.load(std::memory_order_relaxed);
+        if ((before & 1U) != 0 || before != after) {
+            return false;
+        }
+        std::memcpy(static_cast<void *>(&value), words.data(), sizeof(T));
+        return true;
+    }
+
+    /** Completed stores, for a reader to tell an update apart */
+    [[nodiscard]] std::uint64_t version() const {
+        return m_Sequence.load(std::memory_order_acquire) / 2;
+    }
+
+  private:
+    std::atomic<std::uint64_t>       m_Sequence{0}; /** odd while writing */
+    std::array<std::atomic<Word>, N> m_Words{};
+};
+} // namespace Utils
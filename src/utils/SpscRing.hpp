@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace Utils {
+/**
+ * Single producer, single consumer bounded queue, lock free.
+ * Only made of lock free atomics and trivially copyable slots, so it can be
+ * placed in memory shared between processes.
+ * The indices only grow, slot = index % N: the ring is empty when both are
+ * equal and full when they are N apart.
+ * */
+template <typename T, std::size_t N> class SpscRing {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "SpscRing value must be trivially copyable");
+    static_assert(N > 0 && (N & (N - 1)) == 0,
+                  "SpscRing size must be a power of two");
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+    /** Keeps the producer and consumer indices on their own cache lines */
+    static constexpr std::size_t CACHE_LINE = 64;
+
+  public:
+    static constexpr std::size_t CAPACITY = N;
+
+    /**
+     * Producer only
+     * @return: false when full, value is not queued
+     * */
+    bool push(const T &value) {
+        const auto head = m_Head.load(std::memory_order_relaxed);
+        if (head - m_Tail.load(std::memory_order_acquire) >= N) {
+            return false;
+        }
+        m_Slots[head % N] = value;
+        m_Head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Consumer only
+     * @return: false when empty, value is unchanged
+     * */
+    bool pop(T &value) {
+        const auto tail = m_Tail.load(std::memory_order_relaxed);
+        if (tail == m_Head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = m_Slots[tail % N];
+        m_Tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Either side, a hint only while the other side is running */
+    [[nodiscard]] bool empty() const {
+        return m_Tail.load(std::memory_order_acquire) ==
+               m_Head.load(std::memory_order_acquire);
+    }
+
+  private:
+    alignas(CACHE_LINE) std::atomic<std::uint64_t> m_Head{0}; /** producer */
+    alignas(CACHE_LINE) std::atomic<std::uint64_t> m_Tail{0}; /** consumer */
+    alignas(CACHE_LINE) std::array<T, N> m_Slots{};
+};
+} // namespace Utils
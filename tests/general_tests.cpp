@@ -1,10 +1,19 @@
 #include "catch2/catch.hpp"
 
+#include <atomic>
 #include <chrono>
 #include <thread>
+#include <utility>
+#include <vector>
 
 #include "log/Logger.hpp"
-#include "regatron/Readings.hpp"
+#include "regatron/ControllerSettings.hpp"
+#include "regatron/History.hpp"
+#include "regatron/SharedCommands.hpp"
+#include "regatron/SharedCommandsServer.hpp"
+#include "regatron/SharedSnapshot.hpp"
+#include "regatron/SharedSnapshotWriter.hpp"
+#include "regatron/TcioWorker.hpp"
 #include "utils/Instrumentator.hpp"
 
 TEST_CASE(R"(Testing "log")", "[log]") {
@@ -37,30 +46,213 @@ TEST_CASE("Testing instrumentator", "[instrumentator]") {
 }
 
 TEST_CASE("Testing Slope calculation", "[slope]") {
-    Regatron::Readings readings{};
-    readings.m_SysVoltagePhysMax = 390.;
-    LOG_TRACE("MAX = {}", readings.m_SysVoltagePhysMax);
-    readings.SlopeRawToVms(0);
-    readings.SlopeRawToVms(1);
-    readings.SlopeRawToVms(2);
-    readings.SlopeRawToVms(3);
-    readings.SlopeRawToVms(4);
-    readings.SlopeRawToVms(16000);
-    readings.SlopeRawToVms(32000);
-
-    readings.SlopeVmsToRaw(0.73);
-    readings.SlopeVmsToRaw(1);
-
-    readings.m_SysVoltagePhysMax = 800.;
-    LOG_TRACE("MAX = {}", readings.m_SysVoltagePhysMax);
-    readings.SlopeRawToVms(0);
-    readings.SlopeRawToVms(1);
-    readings.SlopeRawToVms(2);
-    readings.SlopeRawToVms(3);
-    readings.SlopeRawToVms(4);
-    readings.SlopeRawToVms(16000);
-    readings.SlopeRawToVms(32000);
-
-    readings.SlopeVmsToRaw(0.73);
-    readings.SlopeVmsToRaw(1);
+    using Regatron::ControllerSettings;
+    for (const double fullScale : {390., 800.}) {
+        const double a = ControllerSettings::GetSlopeA(fullScale);
+        const double b = ControllerSettings::GetSlopeB(fullScale);
+        LOG_TRACE("MAX = {}, a = {}, b = {}", fullScale, a, b);
+
+        // Full scale in SLOPE_MAX_TIME_MS is the slowest ramp, in
+        // SLOPE_MIN_TIME_MS the fastest
+        REQUIRE(a * fullScale / Regatron::SLOPE_MAX_TIME_MS + b ==
+                Approx(Regatron::SLOPE_MIN_RAW));
+        REQUIRE(a * fullScale / Regatron::SLOPE_MIN_TIME_MS + b ==
+                Approx(Regatron::SLOPE_MAX_RAW));
+    }
+}
+
+TEST_CASE("History ring buffer", "[history]") {
+    using Regatron::Channel;
+    constexpr int64_t MS = 1000000;
+
+    Regatron::History  history{8};
+    Regatron::Snapshot snapshot;
+    for (int i = 1; i <= 10; i++) {
+        snapshot.fastTime    = i * 100 * MS;
+        snapshot.sys.voltage = i % 2 == 0 ? i : -i;
+        snapshot.slowTime    = i * 100 * MS;
+        snapshot.pcbTemp     = 20. + i;
+        history.append(snapshot, true, i % 5 == 0);
+    }
+
+    // Only the last 8 samples are kept, oldest first
+    auto points = history.query(Channel::SysVoltage, 0, 1);
+    REQUIRE(points.size() == 8);
+    REQUIRE(points.front().time == 300 * MS);
+    REQUIRE(points.front().min == -3.);
+    REQUIRE(points.back().max == 10.);
+
+    // Window and min/max decimation, the point takes its last sample time
+    points = history.query(Channel::SysVoltage, 550 * MS, 2);
+    REQUIRE(points.size() == 3);
+    REQUIRE(points[0].time == 700 * MS);
+    REQUIRE(points[0].min == -7.);
+    REQUIRE(points[0].max == 6.);
+    REQUIRE(points[1].min == -9.);
+    REQUIRE(points[1].max == 8.);
+    REQUIRE(points[2].time == 1000 * MS);
+    REQUIRE(points[2].min == 10.);
+    REQUIRE(points[2].max == 10.);
+
+    // Slow channels only have the slow group reads
+    points = history.query(*Regatron::ParseChannel("pcbTemp"), 0, 1);
+    REQUIRE(points.size() == 2);
+    REQUIRE(points[1].max == 30.);
+
+    fmt::memory_buffer out;
+    Regatron::FormatHistory(out, points, false, 1000 * MS);
+    REQUIRE(fmt::to_string(out) == "[-500,25,0,30]");
+
+    REQUIRE_FALSE(Regatron::ParseChannel("unknown"));
+    REQUIRE(Regatron::History{0}.query(Channel::SysVoltage, 0, 1).empty());
+}
+
+#if __linux__
+TEST_CASE("Shared memory snapshot", "[shared]") {
+    const auto name = fmt::format("/REGtest{}", getpid());
+    {
+        Regatron::SharedSnapshotWriter writer{name};
+        REQUIRE(writer.enabled());
+        Regatron::Shared::Reader reader{name};
+        REQUIRE(reader.valid());
+        const auto version = reader.version();
+
+        Regatron::Snapshot snapshot;
+        snapshot.fastTime                  = 100;
+        snapshot.sys.voltage               = 12.5;
+        snapshot.mod.state                 = 4;
+        snapshot.pcbTemp                   = 31.;
+        snapshot.modTree.warning.group     = 2;
+        snapshot.modTree.warning.error[31] = 0x80;
+        snapshot.treeGeneration            = 3;
+        writer.publish(snapshot);
+
+        const auto readings = reader.read();
+        REQUIRE(readings);
+        REQUIRE(reader.version() == version + 1);
+        REQUIRE(readings->fastTime == 100);
+        REQUIRE(readings->sys.voltage == 12.5);
+        REQUIRE(readings->mod.state == 4);
+        REQUIRE(readings->pcbTemp == 31.);
+        REQUIRE(readings->slowTime == 0);
+        REQUIRE(readings->modWarning.group == 2);
+        REQUIRE(readings->modWarning.error[31] == 0x80);
+        REQUIRE(readings->treeGeneration == 3);
+    }
+    // Unlinked with the writer
+    REQUIRE_FALSE(Regatron::Shared::Reader{name}.valid());
+}
+
+TEST_CASE("Shared memory snapshot read latency", "[shared][benchmark]") {
+    const auto name = fmt::format("/REGbench{}", getpid());
+    Regatron::SharedSnapshotWriter writer{name};
+    Regatron::Shared::Reader       reader{name};
+    REQUIRE(reader.valid());
+
+    // Every value of a snapshot is the same, a torn read would mix them
+    std::atomic<bool> done{false};
+    std::thread       updates([&writer, &done]() {
+        Regatron::Snapshot snapshot;
+        for (int64_t i = 1; !done.load(std::memory_order_relaxed); i++) {
+            snapshot.fastTime       = i;
+            snapshot.sys.voltage    = static_cast<double>(i);
+            snapshot.pcbTemp        = static_cast<double>(i);
+            snapshot.treeGeneration = static_cast<uint64_t>(i);
+            writer.publish(snapshot);
+        }
+    });
+
+    constexpr int READS  = 1000000;
+    int           torn   = 0;
+    int           missed = 0;
+    const auto    start  = std::chrono::steady_clock::now();
+    for (int i = 0; i < READS; i++) {
+        const auto readings = reader.read();
+        if (!readings) {
+            missed++;
+            continue;
+        }
+        if (readings->sys.voltage != static_cast<double>(readings->fastTime) ||
+            readings->pcbTemp != readings->sys.voltage ||
+            readings->treeGeneration !=
+                static_cast<uint64_t>(readings->fastTime)) {
+            torn++;
+        }
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    done               = true;
+    updates.join();
+
+    LOG_INFO("Shared snapshot: {} ns per read under continuous updates, "
+             "{} updates, {} reads gave up.",
+             std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                     .count() /
+                 READS,
+             reader.version(), missed);
+    REQUIRE(torn == 0);
+}
+
+TEST_CASE("Shared memory setpoint commands", "[shared]") {
+    using namespace std::chrono_literals;
+    using Regatron::Shared::CommandStatus;
+    using Regatron::Shared::Setpoint;
+
+    // The first write holds the worker, the commands queued meanwhile are
+    // coalesced
+    std::atomic<bool>                        applying{false};
+    std::atomic<bool>                        release{false};
+    std::vector<std::pair<Setpoint, double>> applied;
+    Regatron::TcioWorker                     worker;
+    const auto name = fmt::format("/REGtest{}Commands", getpid());
+    Regatron::SharedCommandsServer server{
+        name, worker, [&](Setpoint setpoint, double value) {
+            applying = true;
+            while (!release) {
+                std::this_thread::sleep_for(1ms);
+            }
+            if (value < 0) {
+                return CommandStatus::OutOfRange;
+            }
+            applied.emplace_back(setpoint, value);
+            return CommandStatus::Applied;
+        }};
+    REQUIRE(server.enabled());
+    Regatron::Shared::Commander commander{name};
+    REQUIRE(commander.valid());
+
+    REQUIRE(commander.submit(Setpoint::Voltage, 1.) == 1);
+    while (!applying) {
+        std::this_thread::sleep_for(1ms);
+    }
+    REQUIRE(commander.submit(Setpoint::Voltage, 2.) == 2);
+    REQUIRE(commander.submit(Setpoint::Current, -1.) == 3);
+    REQUIRE(commander.submit(Setpoint::Voltage, 3.) == 4);
+    release = true;
+
+    std::vector<Regatron::Shared::Completion> completions;
+    const auto until = std::chrono::steady_clock::now() + 1s;
+    while (completions.size() < 4 && std::chrono::steady_clock::now() < until) {
+        if (const auto completion = commander.poll()) {
+            completions.push_back(*completion);
+        } else {
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+    REQUIRE(completions.size() == 4);
+    const auto status = [&completions](uint64_t id) {
+        for (const auto &completion : completions) {
+            if (completion.id == id) {
+                return static_cast<CommandStatus>(completion.status);
+            }
+        }
+        return CommandStatus::Invalid;
+    };
+    REQUIRE(status(1) == CommandStatus::Applied);
+    REQUIRE(status(2) == CommandStatus::Superseded);
+    REQUIRE(status(3) == CommandStatus::OutOfRange);
+    REQUIRE(status(4) == CommandStatus::Applied);
+    REQUIRE(applied == std::vector<std::pair<Setpoint, double>>{
+                           {Setpoint::Voltage, 1.}, {Setpoint::Voltage, 3.}});
+    REQUIRE(commander.droppedCompletions() == 0);
 }
+#endif
@@ -0,0 +1,150 @@
+#include "catch2/catch.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "net/Handler.hpp"
+#include "regatron/Comm.hpp"
+#include "regatron/Handler.hpp"
+
+namespace {
+/** Allocations made by the current thread while counting is enabled. */
+thread_local bool countAllocations = false;
+thread_local int  allocations      = 0;
+} // namespace
+
+void *operator new(std::size_t size) {
+    if (countAllocations) {
+        allocations++;
+    }
+    if (void *p = std::malloc(size != 0 ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t /*size*/) noexcept { std::free(p); }
+
+namespace {
+/**
+ * Handler bound to a disconnected device, device commands answer UNAVAILABLE.
+ * */
+std::shared_ptr<Net::Handler>
+makeHandler(Regatron::AcquisitionConfig acquisitionConfig = {}) {
+    auto comm = std::make_shared<Regatron::Comm>(1);
+    comm->setAutoReconnect(false);
+    return std::make_shared<Regatron::Handler>(comm, acquisitionConfig);
+}
+
+std::string request(Net::Handler &handler, std::string_view message) {
+    Net::Response response;
+    handler.handle(message, response);
+    return fmt::to_string(response);
+}
+} // namespace
+
+TEST_CASE("Single commands", "[handler]") {
+    auto handler = makeHandler();
+
+    REQUIRE(request(*handler, "getConnectionState\n") ==
+            "getConnectionState 0\n");
+    REQUIRE(request(*handler, "setDebug 1.5\n") == "setDebug ACK\n");
+    REQUIRE(request(*handler, "getDebug\n") == "getDebug 1.5\n");
+    REQUIRE(request(*handler, "getSysReadings\n") ==
+            "getSysReadings UNAVAILABLE\n");
+    REQUIRE(request(*handler, "unknownCommand\n") == "NACK");
+
+    // Command name and argument are split once
+    REQUIRE(request(*handler, "setDebug   -3\n") == "setDebug ACK\n");
+    REQUIRE(request(*handler, "getDebug\r\n") == "getDebug -3\n");
+    REQUIRE(request(*handler, "getDebug 1\n") == "NACK");
+    REQUIRE(request(*handler, "setDebug\n") == "NACK");
+    REQUIRE(request(*handler, "setDebug abc\n") == "NACK");
+    REQUIRE(request(*handler, "getDebugX\n") == "NACK");
+}
+
+TEST_CASE("Batch commands", "[handler]") {
+    auto handler = makeHandler();
+
+    REQUIRE(request(*handler, "batch setDebug 2;getDebug\n") ==
+            "batch setDebug ACK;getDebug 2\n");
+
+    // A failed item does not abort the rest of the batch
+    REQUIRE(request(*handler, 
+                "batch getSysReadings; unknownCommand 1 ;getDebug;\n") ==
+            "batch getSysReadings UNAVAILABLE;unknownCommand NACK;"
+            "getDebug 2\n");
+
+    REQUIRE(request(*handler, "batch \n") == "batch \n");
+
+    // Module reads may be handled first, replies keep the request order
+    REQUIRE(request(*handler, "batch setDebug 3;getSysReadings;getDebug;"
+                              "getModReadings;setDebug 4;getModTree\n") ==
+            "batch setDebug ACK;getSysReadings UNAVAILABLE;getDebug 3;"
+            "getModReadings UNAVAILABLE;setDebug ACK;"
+            "getModTree UNAVAILABLE\n");
+    REQUIRE_THAT(request(*handler, "getSelectorStats\n"),
+                 Catch::Matchers::StartsWith("getSelectorStats ["));
+}
+
+TEST_CASE("Snapshot and fresh readings", "[handler]") {
+    auto handler = makeHandler();
+
+    // No acquisition, readings come from the device
+    REQUIRE(request(*handler, "getReadingsAge\n") ==
+            "getReadingsAge [-1,-1]\n");
+    REQUIRE(request(*handler, "getSysTree\n") ==
+            "getSysTree UNAVAILABLE\n");
+
+    REQUIRE(request(*handler, "setDebug 7\n") == "setDebug ACK\n");
+    REQUIRE(request(*handler, "fresh getDebug\n") == "getDebug 7\n");
+    REQUIRE(request(*handler, "fresh  getSysReadings\n") ==
+            "getSysReadings UNAVAILABLE\n");
+    REQUIRE(request(*handler, "fresh\n") == "NACK");
+    REQUIRE(request(*handler, "batch fresh getDebug;getDebug\n") ==
+            "batch getDebug 7;getDebug 7\n");
+}
+
+TEST_CASE("Steady state requests do not allocate", "[handler]") {
+    auto          handler = makeHandler();
+    Net::Response response;
+
+    const std::string_view requests[] = {
+        "setDebug 4.25\n",
+        "getDebug\n",
+        "getCommStatus\n",
+        "getAutoReconnect\n",
+        "batch getDebug;setDebug 1e-3;getAutoReconnect\n",
+    };
+
+    // Warm up, the response buffer keeps its capacity
+    for (const auto &message : requests) {
+        handler->handle(message, response);
+    }
+
+    for (const auto &message : requests) {
+        response.clear();
+        allocations      = 0;
+        countAllocations = true;
+        handler->handle(message, response);
+        countAllocations = false;
+        INFO(message);
+        CHECK(allocations == 0);
+    }
+}
+
+TEST_CASE("Acquisition without a device publishes nothing", "[handler]") {
+    using namespace std::chrono_literals;
+    auto handler = makeHandler({.fastPeriod = 1ms, .slowPeriod = 5ms});
+
+    std::this_thread::sleep_for(20ms);
+    REQUIRE(request(*handler, "getReadingsAge\n") ==
+            "getReadingsAge [-1,-1]\n");
+    REQUIRE(request(*handler, "getSysReadings\n") ==
+            "getSysReadings UNAVAILABLE\n");
+}
@@ -0,0 +1,327 @@
+#include "catch2/catch.hpp"
+
+#include <asio.hpp> // NOLINT
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "log/Logger.hpp"
+#include "net/Frame.hpp"
+#include "net/Handler.hpp"
+#include "net/Server.hpp"
+
+namespace {
+constexpr unsigned short TEST_PORT        = 29910;
+constexpr unsigned int   SERVER_THREADS   = 4;
+constexpr int            REQUESTS_PER_RUN = 20000;
+
+class EchoHandler : public Net::Handler {
+  public:
+    void handle(std::string_view message, Net::Response &response) override {
+        response.append(message.data(), message.data() + message.size());
+    }
+};
+
+/** Echoes, keeps the outbox of the last session for the test to push to. */
+class PushHandler : public EchoHandler {
+  public:
+    void handleSession(std::string_view message, Net::Response &response,
+                       const std::shared_ptr<Net::Outbox> &outbox) override {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Outbox = outbox;
+        }
+        handle(message, response);
+    }
+
+    std::shared_ptr<Net::Outbox> outbox() {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Outbox;
+    }
+
+  private:
+    std::mutex                   m_Mutex;
+    std::shared_ptr<Net::Outbox> m_Outbox;
+};
+
+/** Echoes frames too, "bad" is a malformed frame. */
+class FrameHandler : public EchoHandler {
+  public:
+    [[nodiscard]] bool acceptsFrames() const override { return true; }
+    bool handleFrame(std::string_view payload,
+                     Net::Response &  response) override {
+        response.append(payload.data(), payload.data() + payload.size());
+        return payload != "bad";
+    }
+};
+
+/** Runs a server on a background thread for the lifetime of the object. */
+class ServerRunner {
+  public:
+    explicit ServerRunner(std::shared_ptr<Net::Handler> handler)
+        : m_Server(std::make_shared<Net::Server>(std::move(handler), TEST_PORT,
+                                                 SERVER_THREADS)),
+          m_Thread([this]() { m_Server->listen(); }) {}
+    ServerRunner(const ServerRunner &) = delete;
+    ServerRunner(ServerRunner &&)      = delete;
+    ServerRunner &operator=(const ServerRunner &) = delete;
+    ServerRunner &operator=(ServerRunner &&) = delete;
+    ~ServerRunner() {
+        m_Server->shutdown();
+        m_Server->stop();
+        m_Thread.join();
+    }
+
+  private:
+    std::shared_ptr<Net::Server> m_Server;
+    std::thread                  m_Thread;
+};
+
+class Client {
+  public:
+    Client() : m_Socket(m_IOContext) {
+        m_Socket.connect(asio::ip::tcp::endpoint{
+            asio::ip::address_v4::loopback(), TEST_PORT});
+    }
+
+    std::string request(const std::string &message) {
+        asio::write(m_Socket, asio::buffer(message));
+        return response();
+    }
+
+    std::string response() {
+        const auto  length = asio::read_until(m_Socket, m_Buffer, '\n');
+        const auto  begin  = asio::buffers_begin(m_Buffer.data());
+        std::string response{begin, begin + static_cast<long>(length)};
+        m_Buffer.consume(length);
+        return response;
+    }
+
+    void write(const std::string &data) {
+        asio::write(m_Socket, asio::buffer(data));
+    }
+
+    /** @return: payload of the next frame */
+    std::string frame() {
+        const auto size = Net::FramePayloadSize(take(Net::FRAME_HEADER));
+        return take(*size);
+    }
+
+    /** @return: false when the server closed the connection */
+    bool open() {
+        std::error_code ec;
+        asio::read(m_Socket, m_Buffer, asio::transfer_at_least(1), ec);
+        return ec != asio::error::eof;
+    }
+
+    static std::string frameOf(std::string_view payload) {
+        fmt::memory_buffer out;
+        const auto         mark = Net::BeginFrame(out);
+        out.append(payload.data(), payload.data() + payload.size());
+        Net::EndFrame(out, mark);
+        return fmt::to_string(out);
+    }
+
+  private:
+    std::string take(std::size_t size) {
+        if (m_Buffer.size() < size) {
+            asio::read(m_Socket, m_Buffer,
+                       asio::transfer_exactly(size - m_Buffer.size()));
+        }
+        const auto  begin = asio::buffers_begin(m_Buffer.data());
+        std::string data{begin, begin + static_cast<long>(size)};
+        m_Buffer.consume(size);
+        return data;
+    }
+
+    asio::io_context      m_IOContext;
+    asio::ip::tcp::socket m_Socket;
+    asio::streambuf       m_Buffer;
+};
+
+/** @return: requests per second served to nClients concurrent clients */
+double measureThroughput(int nClients) {
+    const int                requestsPerClient = REQUESTS_PER_RUN / nClients;
+    std::atomic<int>         completed{0};
+    std::vector<std::thread> clients;
+
+    const auto start = std::chrono::steady_clock::now();
+    clients.reserve(static_cast<std::size_t>(nClients));
+    for (int c = 0; c < nClients; c++) {
+        clients.emplace_back([&completed, requestsPerClient]() {
+            Client client;
+            for (int r = 0; r < requestsPerClient; r++) {
+                if (client.request("getDebug\n") == "getDebug\n") {
+                    completed++;
+                }
+            }
+        });
+    }
+    for (auto &client : clients) {
+        client.join();
+    }
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    REQUIRE(completed == requestsPerClient * nClients);
+    return completed / elapsed.count();
+}
+} // namespace
+
+TEST_CASE("Idle client does not block other clients", "[net]") {
+    ServerRunner server{std::make_shared<EchoHandler>()};
+
+    Client idle;
+    Client active;
+    REQUIRE(active.request("getDebug\n") == "getDebug\n");
+    REQUIRE(idle.request("setDebug 1\n") == "setDebug 1\n");
+}
+
+#if __linux__
+TEST_CASE("UNIX endpoint removed after shutdown", "[net]") {
+    const std::string endpoint = "/tmp/net_tests_endpoint";
+    {
+        Net::Server server{std::make_shared<EchoHandler>(), endpoint.c_str(),
+                           1};
+        REQUIRE(std::filesystem::exists(endpoint));
+        server.shutdown();
+    }
+    REQUIRE_FALSE(std::filesystem::exists(endpoint));
+}
+#endif
+
+TEST_CASE("Server stops on a signal", "[net]") {
+    Net::Server server{std::make_shared<EchoHandler>(), TEST_PORT, 1};
+    server.stopOnSignals({SIGUSR1});
+    std::thread listener([&server]() { server.listen(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds{50});
+    std::raise(SIGUSR1);
+    listener.join();
+    REQUIRE(server.stopSignal() == SIGUSR1);
+}
+
+TEST_CASE("Pipelined requests are answered in order", "[net]") {
+    ServerRunner server{std::make_shared<EchoHandler>()};
+
+    Client      client;
+    std::string pipeline;
+    for (int i = 0; i < 64; i++) {
+        pipeline += fmt::format("setDebug {}\n", i);
+    }
+    // Partial message, completed by the next request
+    pipeline += "getDe";
+
+    REQUIRE(client.request(pipeline) == "setDebug 0\n");
+    for (int i = 1; i < 64; i++) {
+        REQUIRE(client.response() == fmt::format("setDebug {}\n", i));
+    }
+    REQUIRE(client.request("bug\n") == "getDebug\n");
+}
+
+TEST_CASE("Pushed updates are written between responses", "[net]") {
+    auto         handler = std::make_shared<PushHandler>();
+    ServerRunner server{handler};
+
+    Client client;
+    REQUIRE(client.request("getDebug\n") == "getDebug\n");
+    const auto outbox = handler->outbox();
+    REQUIRE(outbox != nullptr);
+
+    // Written while no request is in progress
+    REQUIRE(outbox->push(1, "update 1 [1]\n"));
+    REQUIRE(client.response() == "update 1 [1]\n");
+
+    // Every request is still answered, updates may come in between
+    for (int i = 0; i < 100; i++) {
+        REQUIRE(outbox->push(1, fmt::format("update 1 [{}]\n", i)));
+        const auto request = fmt::format("setDebug {}\n", i);
+        auto       reply   = client.request(request);
+        while (reply.starts_with("update")) {
+            reply = client.response();
+        }
+        REQUIRE(reply == request);
+    }
+}
+
+TEST_CASE("Outbox merges by key and bounds the pending updates", "[net]") {
+    // The same key is merged, extra keys are dropped
+    Net::Outbox        bounded{nullptr};
+    fmt::memory_buffer pushed;
+    REQUIRE(bounded.push(0, "a\n"));
+    REQUIRE(bounded.push(0, "b\n"));
+    for (uint64_t key = 1; key < Net::Outbox::MAX_PENDING; key++) {
+        REQUIRE(bounded.push(key, "c\n"));
+    }
+    REQUIRE_FALSE(bounded.push(Net::Outbox::MAX_PENDING, "d\n"));
+    REQUIRE(bounded.merged() == 1);
+    REQUIRE(bounded.dropped() == 1);
+    bounded.take(pushed);
+    REQUIRE(fmt::to_string(pushed).starts_with("b\nc\n"));
+    REQUIRE(pushed.size() == 2 * Net::Outbox::MAX_PENDING);
+
+    // Replies are never merged nor dropped, and go out first
+    pushed.clear();
+    REQUIRE(bounded.push(0, "e\n"));
+    for (std::size_t i = 0; i <= Net::Outbox::MAX_PENDING; i++) {
+        bounded.reply("#1 r\n");
+    }
+    bounded.take(pushed);
+    REQUIRE(fmt::to_string(pushed).starts_with("#1 r\n#1 r\n"));
+    REQUIRE(fmt::to_string(pushed).ends_with("#1 r\ne\n"));
+    REQUIRE(pushed.size() == 5 * (Net::Outbox::MAX_PENDING + 1) + 2);
+    REQUIRE(bounded.dropped() == 1);
+}
+
+TEST_CASE("Binary frames on the same port", "[net]") {
+    ServerRunner server{std::make_shared<FrameHandler>()};
+
+    // Magic first byte, pipelined frames and a partial one
+    Client binary;
+    binary.write(std::string(1, static_cast<char>(Net::BINARY_MAGIC)) +
+                 Client::frameOf("a") + Client::frameOf("bc") +
+                 Client::frameOf("def").substr(0, 5));
+    REQUIRE(binary.frame() == "a");
+    REQUIRE(binary.frame() == "bc");
+    binary.write(Client::frameOf("def").substr(5));
+    REQUIRE(binary.frame() == "def");
+
+    // Negotiated from text, the rest of the read is framed already
+    Client negotiated;
+    REQUIRE(negotiated.request("getDebug\n") == "getDebug\n");
+    negotiated.write("proto binary\n" + Client::frameOf("g"));
+    REQUIRE(negotiated.response() == "proto ACK\n");
+    REQUIRE(negotiated.frame() == "g");
+
+    // A malformed frame closes the session
+    negotiated.write(Client::frameOf("bad"));
+    REQUIRE_FALSE(negotiated.open());
+}
+
+TEST_CASE("Binary frames are refused without handler support", "[net]") {
+    ServerRunner server{std::make_shared<EchoHandler>()};
+
+    Client client;
+    REQUIRE(client.request("proto binary\n") == "proto NACK\n");
+    REQUIRE(client.request("getDebug\n") == "getDebug\n");
+}
+
+TEST_CASE("Throughput from 1 to 64 clients", "[net][load]") {
+    ServerRunner server{std::make_shared<EchoHandler>()};
+
+    const double single = measureThroughput(1);
+    LOG_INFO(R"(Throughput with "1" client: "{:.0f}" req/s)", single);
+
+    for (int nClients = 2; nClients <= 64; nClients *= 2) {
+        const double throughput = measureThroughput(nClients);
+        LOG_INFO(R"(Throughput with "{}" clients: "{:.0f}" req/s)", nClients,
+                 throughput);
+        CHECK(throughput > single / 2.);
+    }
+}
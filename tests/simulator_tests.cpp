@@ -0,0 +1,1113 @@
+#include "catch2/catch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "log/Logger.hpp"
+#include "net/Frame.hpp"
+#include "net/Handler.hpp"
+#include "regatron/Comm.hpp"
+#include "regatron/Binary.hpp"
+#include "regatron/Handler.hpp"
+#include "regatron/SharedCommands.hpp"
+#include "regatron/Tcio.hpp"
+#include "simulator/Simulator.hpp"
+#include "utils/Base64.hpp"
+
+namespace {
+/** Allocations made by the current thread while counting is enabled. */
+thread_local bool countAllocations = false;
+thread_local int  allocations      = 0;
+} // namespace
+
+void *operator new(std::size_t size) {
+    if (countAllocations) {
+        allocations++;
+    }
+    if (void *p = std::malloc(size != 0 ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t /*size*/) noexcept { std::free(p); }
+
+namespace {
+/** Fresh simulated device and a Comm that connects to it at once. */
+std::shared_ptr<Regatron::Comm> makeComm(Simulator::Config config = {}) {
+    Simulator::Configure(config);
+    Simulator::Reset();
+    auto comm = std::make_shared<Regatron::Comm>(1);
+    comm->SetConnectDelay(std::chrono::milliseconds{0});
+    return comm;
+}
+
+/** @return: false when not connected within a second */
+bool waitConnected(const Regatron::Comm &comm) {
+    using namespace std::chrono_literals;
+    const auto until = std::chrono::steady_clock::now() + 1s;
+    while (comm.getConnectionState() != Regatron::ConnectionState::Ok) {
+        if (std::chrono::steady_clock::now() > until) {
+            return false;
+        }
+        std::this_thread::sleep_for(1ms);
+    }
+    return true;
+}
+
+std::string request(Net::Handler &handler, std::string_view message) {
+    Net::Response response;
+    handler.handle(message, response);
+    return fmt::to_string(response);
+}
+
+/** Same, from a session that takes pushed updates */
+std::string request(Net::Handler &handler, std::string_view message,
+                    const std::shared_ptr<Net::Outbox> &outbox) {
+    Net::Response response;
+    handler.handleSession(message, response, outbox);
+    return fmt::to_string(response);
+}
+
+/** Reply payload of a binary request, decoded on access */
+struct BinaryReply {
+    std::string payload;
+
+    [[nodiscard]] Regatron::Binary::Reply reply() const {
+        const auto reply = Regatron::Binary::DecodeReply(payload);
+        REQUIRE(reply);
+        return *reply;
+    }
+};
+
+BinaryReply request(Net::Handler &handler, const Net::Response &payload) {
+    Net::Response response;
+    REQUIRE(
+        handler.handleFrame({payload.data(), payload.size()}, response));
+    return {fmt::to_string(response)};
+}
+
+/** @return: command id -> name, from getCommandTable */
+std::vector<std::string> commandTable(Net::Handler &handler) {
+    auto table = request(handler, "getCommandTable\n");
+    table      = table.substr(table.find('[') + 1);
+    table      = table.substr(0, table.find(']'));
+    std::vector<std::string> names;
+    std::size_t              begin = 0;
+    while (begin <= table.size()) {
+        const auto end = std::min(table.find(',', begin), table.size());
+        names.push_back(table.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    return names;
+}
+
+/** @return: updates pushed within a second, empty when none */
+std::string waitPushed(Net::Outbox &outbox) {
+    using namespace std::chrono_literals;
+    const auto         until = std::chrono::steady_clock::now() + 1s;
+    fmt::memory_buffer pushed;
+    outbox.take(pushed);
+    while (pushed.size() == 0 && std::chrono::steady_clock::now() < until) {
+        std::this_thread::sleep_for(1ms);
+        outbox.take(pushed);
+    }
+    return fmt::to_string(pushed);
+}
+} // namespace
+
+TEST_CASE("Simulated device", "[simulator]") {
+    Simulator::Config config;
+    config.loadResistance = 5.;
+    auto              comm = makeComm(config);
+    Regatron::Handler handler{comm};
+
+    // Connected in the background
+    REQUIRE(waitConnected(*comm));
+    REQUIRE(request(handler, "getModuleID\n") == "getModuleID 0\n");
+    REQUIRE(request(handler, "getDLLVersion\n") == "getDLLVersion 3.80.0\n");
+
+    REQUIRE(request(handler, "setSysVoltageRef 100\n") ==
+            "setSysVoltageRef ACK\n");
+    REQUIRE(request(handler, "setSysCurrentRef 10\n") ==
+            "setSysCurrentRef ACK\n");
+    REQUIRE(request(handler, "setSysPowerRef 20\n") == "setSysPowerRef ACK\n");
+    REQUIRE(request(handler, "getSysVoltageRef\n") == "getSysVoltageRef 100\n");
+    REQUIRE(request(handler, "getSysReadings\n") ==
+            "getSysReadings [0,0,0,0,4]\n");
+
+    // Current limited: 10A into 5 Ohm
+    REQUIRE(request(handler, "setSysOutVoltEnable 1\n") ==
+            "setSysOutVoltEnable ACK\n");
+    REQUIRE(request(handler, "getSysReadings\n") ==
+            "getSysReadings [50,10,0.5,5000,8]\n");
+    REQUIRE(request(handler, "getModReadings\n") ==
+            "getModReadings [50,10,0.5,5000,8]\n");
+
+    SECTION("Error tree") {
+        T_ErrorTree32 error{};
+        error.group    = 1U << 2U;
+        error.error[2] = 0x10;
+        Simulator::SetErrorTree(true, error, T_ErrorTree32{});
+
+        REQUIRE(request(handler, "getSysReadings\n") ==
+                "getSysReadings [0,0,0,0,12]\n");
+        REQUIRE(request(handler, "getSysTree\n").rfind("getSysTree [4,0,0,16,0",
+                                                       0) == 0);
+        REQUIRE(request(handler, "getSysTreeCompact\n") ==
+                "getSysTreeCompact [4,4,10,0,0]\n");
+        REQUIRE(request(handler, "cmdClearErrors\n") ==
+                "cmdClearErrors ACK\n");
+        REQUIRE(request(handler, "getSysReadings\n") ==
+                "getSysReadings [50,10,0.5,5000,8]\n");
+    }
+
+    SECTION("Slope registers") {
+        REQUIRE(request(handler, "setSlopeVoltRaw 100\n") ==
+                "setSlopeVoltRaw ACK\n");
+        REQUIRE(request(handler, "setSlopeStartupVoltRaw 200\n") ==
+                "setSlopeStartupVoltRaw ACK\n");
+        REQUIRE(request(handler, "cmdSlopeVoltWrite\n") ==
+                "cmdSlopeVoltWrite ACK\n");
+        REQUIRE(request(handler, "getSlopeVolt\n").rfind("getSlopeVolt [200,100,",
+                                                         0) == 0);
+    }
+
+    SECTION("Flash error history") {
+        Simulator::AddErrorHistoryEntry(1, 2);
+        Simulator::AddErrorHistoryEntry(3, 4);
+        const auto history = request(handler, "getFlashErrorHistory\n");
+        REQUIRE(history.rfind("getFlashErrorHistory [1,", 0) == 0);
+        REQUIRE(history.find(",0.00,1,2 2,") != std::string::npos);
+        REQUIRE(history.find(",0.00,3,4 ]") != std::string::npos);
+
+        // Unchanged history, the size and the first entry only
+        Simulator::ResetStats();
+        REQUIRE(request(handler, "getFlashErrorHistory\n") == history);
+        REQUIRE(Simulator::GetStats().transactions == 2);
+
+        Simulator::AddErrorHistoryEntry(5, 6);
+        const auto page = request(handler, "getFlashErrorHistory 1 1\n");
+        REQUIRE(page.rfind("getFlashErrorHistory [2,", 0) == 0);
+        REQUIRE(page.find(",0.00,3,4 ]") != std::string::npos);
+        REQUIRE(request(handler, "getFlashErrorHistory 2 10\n")
+                    .find(",0.00,5,6 ]") != std::string::npos);
+        REQUIRE(request(handler, "getFlashErrorHistory 3\n") == "NACK");
+    }
+}
+
+TEST_CASE("Simulated link faults", "[simulator]") {
+    Simulator::Config config;
+    config.timeout = std::chrono::milliseconds{20};
+    auto comm      = makeComm(config);
+    comm->SetAutoReconnectInterval(std::chrono::seconds{0});
+    Regatron::Handler handler{comm};
+
+    REQUIRE(waitConnected(*comm));
+    REQUIRE(request(handler, "getSysReadings\n") ==
+            "getSysReadings [0,0,0,0,4]\n");
+
+    // A failed transaction drops the connection, it comes back in the
+    // background
+    Simulator::InjectFault(Simulator::Fault::CommunicationError);
+    REQUIRE(request(handler, "getSysReadings\n") == "NACK");
+    REQUIRE(waitConnected(*comm));
+    REQUIRE(request(handler, "getSysReadings\n") ==
+            "getSysReadings [0,0,0,0,4]\n");
+
+    Simulator::InjectFault(Simulator::Fault::Timeout);
+    const auto start = std::chrono::steady_clock::now();
+    REQUIRE(request(handler, "getSysReadings\n") == "NACK");
+    REQUIRE(std::chrono::steady_clock::now() - start >= config.timeout);
+
+    // Powered off: the device is not found any more
+    REQUIRE(waitConnected(*comm));
+    config.present = false;
+    Simulator::Configure(config);
+    REQUIRE(request(handler, "getSysReadings\n") == "NACK");
+    REQUIRE_FALSE(waitConnected(*comm));
+    REQUIRE(request(handler, "getSysReadings\n") ==
+            "getSysReadings UNAVAILABLE\n");
+}
+
+TEST_CASE("Background reconnect", "[simulator]") {
+    using namespace std::chrono_literals;
+
+    Simulator::Config config;
+    config.loadResistance = 5.;
+    auto comm             = makeComm(config);
+    comm->SetConnectDelay(200ms);
+    Regatron::Handler handler{comm, {.fastPeriod = 5ms, .slowPeriod = 0ms}};
+
+    // Requests do not wait for the connection
+    const auto start = std::chrono::steady_clock::now();
+    REQUIRE(request(handler, "setSysVoltageRef 100\n") ==
+            "setSysVoltageRef UNAVAILABLE\n");
+    REQUIRE(request(handler, "batch getModuleID;getDebug\n") ==
+            "batch getModuleID UNAVAILABLE;getDebug 0\n");
+    REQUIRE(std::chrono::steady_clock::now() - start < 100ms);
+
+    // Waiting the connect delay, the TCIO worker is free
+    std::this_thread::sleep_for(50ms);
+    REQUIRE(request(handler, "getConnectionState\n") ==
+            "getConnectionState 1\n");
+    REQUIRE(request(handler, "cmdDisconnect\n") == "cmdDisconnect ACK\n");
+    REQUIRE(request(handler, "cmdConnect\n") == "cmdConnect ACK\n");
+
+    REQUIRE(waitConnected(*comm));
+    REQUIRE(request(handler, "setSysCurrentRef 10\n") ==
+            "setSysCurrentRef ACK\n");
+    REQUIRE(request(handler, "setSysOutVoltEnable 1\n") ==
+            "setSysOutVoltEnable ACK\n");
+    std::this_thread::sleep_for(50ms);
+    REQUIRE(request(handler, "getSysReadings\n") ==
+            "getSysReadings [0,0,0,5000,8]\n");
+
+    // The last readings stay available while disconnected
+    config.present = false;
+    Simulator::Configure(config);
+    REQUIRE(request(handler, "fresh getSysReadings\n") == "NACK");
+    REQUIRE(request(handler, "getSysReadings\n") ==
+            "getSysReadings [0,0,0,5000,8] STALE\n");
+    REQUIRE(request(handler, "fresh getSysReadings\n") ==
+            "getSysReadings UNAVAILABLE\n");
+
+    config.present = true;
+    Simulator::Configure(config);
+    REQUIRE(request(handler, "cmdConnect\n") == "cmdConnect ACK\n");
+    REQUIRE(waitConnected(*comm));
+    REQUIRE(request(handler, "fresh getSysReadings\n") ==
+            "getSysReadings [0,0,0,5000,8]\n");
+}
+
+TEST_CASE("Readings history", "[simulator]") {
+    using namespace std::chrono_literals;
+
+    Simulator::Config config;
+    config.loadResistance = 5.;
+    auto              comm = makeComm(config);
+    Regatron::Handler handler{
+        comm, {.fastPeriod = 5ms, .slowPeriod = 20ms, .historyDepth = 1000}};
+    REQUIRE(waitConnected(*comm));
+    REQUIRE(request(handler, "setSysCurrentRef 10\n") ==
+            "setSysCurrentRef ACK\n");
+    REQUIRE(request(handler, "setSysOutVoltEnable 1\n") ==
+            "setSysOutVoltEnable ACK\n");
+    std::this_thread::sleep_for(150ms);
+
+    // "[time,value,...]", oldest first, times in ms up to now
+    const auto history = request(handler, "getHistory sysResistance 10\n");
+    REQUIRE(history.starts_with("getHistory [-"));
+    REQUIRE(history.ends_with(",5000]\n"));
+    const auto samples = std::count(history.begin(), history.end(), ',');
+    REQUIRE(samples >= 20);
+
+    // Decimated: "[time,min,max,...]", fewer points
+    const auto decimated =
+        request(handler, "getHistory sysResistance 10 10\n");
+    REQUIRE(decimated.ends_with(",5000,5000]\n"));
+    REQUIRE(std::count(decimated.begin(), decimated.end(), ',') < samples);
+    REQUIRE(request(handler, "getHistory pcbTemp 0.05\n")
+                .starts_with("getHistory [-"));
+
+    // Kept while disconnected
+    REQUIRE(request(handler, "cmdDisconnect\n") == "cmdDisconnect ACK\n");
+    REQUIRE(request(handler, "getHistory sysResistance 10\n")
+                .starts_with("getHistory [-"));
+    // Windows larger than the clock are the whole history
+    REQUIRE(request(handler, "getHistory sysResistance 1e30\n")
+                .starts_with("getHistory [-"));
+
+    REQUIRE(request(handler, "getHistory sysVoltage inf\n") == "NACK");
+    REQUIRE(request(handler, "getHistory sysVoltage nan\n") == "NACK");
+    REQUIRE(request(handler, "getHistory unknown 10\n") == "NACK");
+    REQUIRE(request(handler, "getHistory sysVoltage\n") == "NACK");
+    REQUIRE(request(handler, "getHistory sysVoltage 1 0\n") == "NACK");
+    REQUIRE(request(handler, "getHistory sysVoltage 1 2 3\n") == "NACK");
+}
+
+TEST_CASE("Error tree changes", "[simulator]") {
+    using namespace std::chrono_literals;
+
+    auto              comm = makeComm();
+    Regatron::Handler handler{comm, {.slowPeriod = 5ms}};
+    REQUIRE(waitConnected(*comm));
+    const auto waitTree = [&](std::string_view since) {
+        const auto until = std::chrono::steady_clock::now() + 1s;
+        auto       reply = request(handler, since);
+        while ((reply == "NACK" || reply == "getTreeSince unchanged\n") &&
+               std::chrono::steady_clock::now() < until) {
+            std::this_thread::sleep_for(1ms);
+            reply = request(handler, since);
+        }
+        return reply;
+    };
+
+    // Generation 0 is the empty trees
+    while (request(handler, "getTreeSince 0\n") == "NACK") {
+        std::this_thread::sleep_for(1ms);
+    }
+    REQUIRE(request(handler, "getTreeSince 0\n") ==
+            "getTreeSince unchanged\n");
+
+    T_ErrorTree32 warning{};
+    warning.group    = 1U;
+    warning.error[0] = 0x3;
+    Simulator::SetErrorTree(true, T_ErrorTree32{}, warning);
+    REQUIRE(waitTree("getTreeSince 0\n") ==
+            "getTreeSince 1 [0,0,1,1,3] [0,0,0,0]\n");
+    REQUIRE(request(handler, "getTreeSince 1\n") ==
+            "getTreeSince unchanged\n");
+
+    Simulator::SetErrorTree(true, T_ErrorTree32{}, T_ErrorTree32{});
+    REQUIRE(waitTree("getTreeSince 1\n") ==
+            "getTreeSince 2 [0,0,0,0] [0,0,0,0]\n");
+    REQUIRE(request(handler, "getTreeSince\n") == "NACK");
+}
+
+TEST_CASE("Subscriptions", "[simulator]") {
+    using namespace std::chrono_literals;
+
+    Simulator::Config config;
+    config.loadResistance = 5.;
+    auto              comm = makeComm(config);
+    Regatron::Handler handler{comm, {.fastPeriod = 5ms}};
+    auto              outbox = std::make_shared<Net::Outbox>(nullptr);
+    REQUIRE(waitConnected(*comm));
+
+    REQUIRE(request(handler, "subscribe sysVoltage,sysCurrent 10\n", outbox) ==
+            "subscribe 1\n");
+    REQUIRE(waitPushed(*outbox) == "update 1 [0,0]\n");
+    REQUIRE(request(handler, "unsubscribe 1\n", outbox) ==
+            "unsubscribe ACK\n");
+    fmt::memory_buffer pushed;
+    outbox->take(pushed);
+
+    // Changes only, past the deadband
+    REQUIRE(request(handler, "subscribe sysResistance 0 100\n", outbox) ==
+            "subscribe 2\n");
+    REQUIRE(waitPushed(*outbox) == "update 2 [0]\n");
+    REQUIRE(request(handler, "setSysCurrentRef 10\n") ==
+            "setSysCurrentRef ACK\n");
+    REQUIRE(request(handler, "setSysOutVoltEnable 1\n") ==
+            "setSysOutVoltEnable ACK\n");
+    REQUIRE(waitPushed(*outbox) == "update 2 [5000]\n");
+    std::this_thread::sleep_for(50ms);
+    pushed.clear();
+    outbox->take(pushed);
+    REQUIRE(pushed.size() == 0);
+
+    // A client behind gets the last update of each subscription only
+    REQUIRE(request(handler, "subscribe sysResistance 5\n", outbox) ==
+            "subscribe 3\n");
+    std::this_thread::sleep_for(50ms);
+    REQUIRE(waitPushed(*outbox) == "update 3 [5000]\n");
+    REQUIRE(outbox->merged() > 0);
+
+    REQUIRE(request(handler, "unsubscribe 1\n", outbox) == "NACK");
+    REQUIRE(request(handler, "unsubscribe\n", outbox) == "unsubscribe ACK\n");
+    REQUIRE(request(handler, "unsubscribe 3\n", outbox) == "NACK");
+
+    // Slow group not polled, period or deadband missing, no outbox
+    REQUIRE(request(handler, "subscribe pcbTemp 10\n", outbox) == "NACK");
+    REQUIRE(request(handler, "subscribe sysVoltage 0\n", outbox) == "NACK");
+    REQUIRE(request(handler, "subscribe unknown 10\n", outbox) == "NACK");
+    REQUIRE(request(handler, "subscribe sysVoltage 10\n") == "NACK");
+}
+
+TEST_CASE("Shutdown", "[simulator]") {
+    using namespace std::chrono_literals;
+
+    auto              comm = makeComm();
+    Regatron::Handler handler{comm, {.fastPeriod = 5ms, .slowPeriod = 5ms}};
+    REQUIRE(waitConnected(*comm));
+
+    // Closed from the worker, nothing reconnects nor polls afterwards
+    handler.shutdown();
+    REQUIRE(comm->getConnectionState() ==
+            Regatron::ConnectionState::Disconnected);
+    REQUIRE_FALSE(comm->getAutoReconnect());
+    REQUIRE(request(handler, "getSysVoltageRef\n") ==
+            "getSysVoltageRef UNAVAILABLE\n");
+    std::this_thread::sleep_for(50ms);
+    REQUIRE(comm->getConnectionState() ==
+            Regatron::ConnectionState::Disconnected);
+}
+
+TEST_CASE("Snapshot requests do not allocate", "[simulator]") {
+    using namespace std::chrono_literals;
+
+    auto              comm = makeComm();
+    Regatron::Handler handler{comm, {.fastPeriod = 5ms, .slowPeriod = 5ms}};
+    REQUIRE(waitConnected(*comm));
+    while (request(handler, "getReadingsAge\n").find("-1") !=
+           std::string::npos) {
+        std::this_thread::sleep_for(1ms);
+    }
+
+    const std::string_view requests[] = {
+        "getSysReadings\n",
+        "getTemperatures\n",
+        "getSysTree\n",
+        "getTreeSince 0\n",
+        "batch getSysReadings;getModReadings\n",
+    };
+
+    // Warm up, the response buffer keeps its capacity
+    Net::Handler &session = handler;
+    Net::Response response;
+    for (const auto &message : requests) {
+        session.handle(message, response);
+    }
+
+    for (const auto &message : requests) {
+        response.clear();
+        allocations      = 0;
+        countAllocations = true;
+        session.handle(message, response);
+        countAllocations = false;
+        INFO(message << fmt::to_string(response));
+        CHECK(allocations == 0);
+        // Answered from the snapshot, not refused
+        CHECK(fmt::to_string(response).find("UNAVAILABLE") ==
+              std::string::npos);
+    }
+}
+
+TEST_CASE("Tagged requests", "[simulator]") {
+    using namespace std::chrono_literals;
+
+    Simulator::Config config;
+    config.loadResistance = 5.;
+    config.latency        = 1ms;
+    auto              comm = makeComm(config);
+    Regatron::Handler handler{comm, {.fastPeriod = 5ms, .slowPeriod = 5ms}};
+    auto              outbox = std::make_shared<Net::Outbox>(nullptr);
+    REQUIRE(waitConnected(*comm));
+    while (request(handler, "getReadingsAge\n").find("-1") !=
+           std::string::npos) {
+        std::this_thread::sleep_for(1ms);
+    }
+
+    // Device reads come later, snapshot and local ones at once
+    REQUIRE(request(handler, "#1 getFlashErrorHistory\n", outbox).empty());
+    REQUIRE(request(handler, "#2 getSysReadings\n", outbox) ==
+            "#2 getSysReadings [0,0,0,0,4]\n");
+    REQUIRE(request(handler, "#3 getDebug\n", outbox) == "#3 getDebug 0\n");
+    REQUIRE(waitPushed(*outbox).starts_with("#1 getFlashErrorHistory "));
+
+    // Every queued reply carries its tag, in completion order
+    REQUIRE(request(handler, "#4 getDLLVersion\n", outbox).empty());
+    REQUIRE(request(handler, "#5 setSysVoltageRef 10\n", outbox).empty());
+    REQUIRE(request(handler, "#6 batch getSysVoltageRef;getDebug\n", outbox)
+                .empty());
+    std::string pushed;
+    for (int i = 0; i < 3 && std::count(pushed.begin(), pushed.end(), '\n') < 3;
+         i++) {
+        pushed += waitPushed(*outbox);
+    }
+    REQUIRE(pushed.find("#4 getDLLVersion 3.80.0\n") != std::string::npos);
+    REQUIRE(pushed.find("#5 setSysVoltageRef ACK\n") != std::string::npos);
+    REQUIRE(pushed.find("#6 batch getSysVoltageRef ") != std::string::npos);
+
+    // Failures keep the tag and the new line, a bad tag is not a request
+    REQUIRE(request(handler, "#7 unknown\n", outbox) == "#7 NACK\n");
+    REQUIRE(request(handler, "#8 subscribe sysVoltage 0\n", outbox) ==
+            "#8 NACK\n");
+    REQUIRE(request(handler, "#x getDebug\n", outbox) == "NACK");
+    REQUIRE(request(handler, "#9\n", outbox) == "NACK");
+
+    // Not connected: answered at once
+    config.present = false;
+    Simulator::Configure(config);
+    REQUIRE(request(handler, "cmdDisconnect\n") == "cmdDisconnect ACK\n");
+    REQUIRE(request(handler, "#10 getSysVoltageRef\n", outbox) ==
+            "#10 getSysVoltageRef UNAVAILABLE\n");
+}
+
+#if __linux__
+TEST_CASE("Shared memory setpoints", "[simulator]") {
+    using namespace std::chrono_literals;
+    using Regatron::Shared::CommandStatus;
+    using Regatron::Shared::Setpoint;
+
+    auto              comm = makeComm();
+    const auto        name = fmt::format("/REGsim{}Commands", getpid());
+    Regatron::Handler handler{comm, {}, name};
+    REQUIRE(waitConnected(*comm));
+    Regatron::Shared::Commander commander{name};
+    REQUIRE(commander.valid());
+
+    const auto wait = [&commander]() {
+        const auto until = std::chrono::steady_clock::now() + 1s;
+        auto       completion = commander.poll();
+        while (!completion && std::chrono::steady_clock::now() < until) {
+            std::this_thread::sleep_for(1ms);
+            completion = commander.poll();
+        }
+        REQUIRE(completion);
+        return static_cast<CommandStatus>(completion->status);
+    };
+    REQUIRE(commander.submit(Setpoint::Voltage, 100.) != 0);
+    REQUIRE(wait() == CommandStatus::Applied);
+    REQUIRE(request(handler, "getSysVoltageRef\n") == "getSysVoltageRef 100\n");
+
+    // Outside of the physical limits, the device is not written
+    REQUIRE(commander.submit(Setpoint::Voltage, 1000.) != 0);
+    REQUIRE(wait() == CommandStatus::OutOfRange);
+    REQUIRE(request(handler, "getSysVoltageRef\n") == "getSysVoltageRef 100\n");
+
+    REQUIRE(request(handler, "cmdDisconnect\n") == "cmdDisconnect ACK\n");
+    REQUIRE(commander.submit(Setpoint::Current, 10.) != 0);
+    REQUIRE(wait() == CommandStatus::Unavailable);
+}
+#endif
+
+TEST_CASE("Binary protocol", "[simulator]") {
+    using namespace std::chrono_literals;
+    using Regatron::Binary::Status;
+    using Regatron::Binary::Type;
+    namespace Binary = Regatron::Binary;
+
+    Simulator::Config config;
+    config.loadResistance = 5.;
+    auto              comm = makeComm(config);
+    Regatron::Handler handler{
+        comm, {.fastPeriod = 5ms, .slowPeriod = 5ms, .historyDepth = 100}};
+    REQUIRE(waitConnected(*comm));
+
+    const auto names = commandTable(handler);
+    const auto id    = [&names](std::string_view name) {
+        const auto found = std::find(names.begin(), names.end(), name);
+        REQUIRE(found != names.end());
+        return static_cast<uint16_t>(found - names.begin());
+    };
+
+    // Set with a double argument, ACK has no value
+    Net::Response payload;
+    Binary::EncodeSet(payload, id("setSysVoltageRef"), 1, 100.);
+    auto binary = request(handler, payload);
+    REQUIRE(binary.reply().id == 1);
+    REQUIRE(binary.reply().command == id("setSysVoltageRef"));
+    REQUIRE(binary.reply().status == Status::Ok);
+    REQUIRE(binary.reply().type == Type::None);
+
+    // Snapshot readings are typed
+    payload.clear();
+    Binary::EncodeGet(payload, id("getSysReadings"), 2);
+    binary = request(handler, payload);
+    while (binary.reply().type != Type::Sample) {
+        std::this_thread::sleep_for(1ms);
+        binary = request(handler, payload);
+    }
+    REQUIRE(binary.reply().status == Status::Ok);
+    REQUIRE(Binary::DecodeSample(binary.reply()));
+    payload.clear();
+    Binary::EncodeGet(payload, id("getTemperatures"), 3);
+    binary = request(handler, payload);
+    while (binary.reply().type != Type::F64Array) {
+        std::this_thread::sleep_for(1ms);
+        binary = request(handler, payload);
+    }
+    REQUIRE(Binary::DecodeF64Array(binary.reply())->size() == 3);
+    payload.clear();
+    Binary::EncodeGet(payload, id("getSysTree"), 4);
+    binary = request(handler, payload);
+    REQUIRE(Binary::DecodeTree(binary.reply()) == Regatron::TreeSample{});
+    REQUIRE(binary.reply().value.size() == 16);
+
+    // Any other command answers its text value
+    payload.clear();
+    Binary::EncodeGet(payload, id("getSysVoltageRef"), 5);
+    binary = request(handler, payload);
+    REQUIRE(binary.reply().type == Type::String);
+    REQUIRE(binary.reply().value == "100");
+    payload.clear();
+    Binary::EncodeGet(payload, id("getSysReadings"), 6, Binary::FRESH);
+    binary = request(handler, payload);
+    REQUIRE(binary.reply().type == Type::String);
+    REQUIRE(binary.reply().value.starts_with("["));
+    payload.clear();
+    Binary::EncodeQuery(payload, id("getHistory"), 7, "sysVoltage 1");
+    binary = request(handler, payload);
+    REQUIRE(binary.reply().status == Status::Ok);
+    REQUIRE(binary.reply().value.starts_with("["));
+    payload.clear();
+    Binary::EncodeQuery(payload, id("getHistory"), 8, "unknown 1");
+    REQUIRE(request(handler, payload).reply().status == Status::Nack);
+    payload.clear();
+    Binary::EncodeGet(payload, static_cast<uint16_t>(names.size()), 9);
+    REQUIRE(request(handler, payload).reply().status == Status::Invalid);
+
+    // Kept readings and device commands while disconnected
+    REQUIRE(request(handler, "cmdDisconnect\n") == "cmdDisconnect ACK\n");
+    payload.clear();
+    Binary::EncodeGet(payload, id("getSysReadings"), 10);
+    binary = request(handler, payload);
+    REQUIRE(binary.reply().status == Status::Stale);
+    REQUIRE(binary.reply().type == Type::Sample);
+    payload.clear();
+    Binary::EncodeSet(payload, id("setSysVoltageRef"), 11, 50.);
+    REQUIRE(request(handler, payload).reply().status == Status::Unavailable);
+
+    // Truncated
+    REQUIRE_FALSE(static_cast<Net::Handler &>(handler).handleFrame("\x01\x00",
+                                                                   payload));
+}
+
+TEST_CASE("Binary protocol throughput", "[simulator][benchmark]") {
+    using namespace std::chrono_literals;
+    namespace Binary       = Regatron::Binary;
+    constexpr int REQUESTS = 200000;
+
+    Simulator::Config config;
+    config.loadResistance = 5.;
+    auto              comm = makeComm(config);
+    Regatron::Handler regatron{comm, {.fastPeriod = 5ms, .slowPeriod = 5ms}};
+    Net::Handler &    handler = regatron;
+    REQUIRE(waitConnected(*comm));
+    REQUIRE(request(handler, "setSysVoltageRef 100\n") ==
+            "setSysVoltageRef ACK\n");
+    REQUIRE(request(handler, "setSysCurrentRef 10\n") ==
+            "setSysCurrentRef ACK\n");
+    REQUIRE(request(handler, "setSysPowerRef 20\n") == "setSysPowerRef ACK\n");
+    REQUIRE(request(handler, "setSysOutVoltEnable 1\n") ==
+            "setSysOutVoltEnable ACK\n");
+    const auto names = commandTable(handler);
+    const auto id    = static_cast<uint16_t>(
+        std::find(names.begin(), names.end(), "getSysReadings") -
+        names.begin());
+    // Current limited: 10A into 5 Ohm, as in "Simulated device"
+    while (request(handler, "getSysReadings\n") !=
+           "getSysReadings [50,10,0.5,5000,8]\n") {
+        std::this_thread::sleep_for(1ms);
+    }
+
+    // Cached getSysReadings, request and response bytes as on the wire
+    const std::string_view text{"getSysReadings\n"};
+    Net::Response          payload;
+    Binary::EncodeGet(payload, id, 1);
+    Net::Response response;
+    for (const bool binary : {false, true}) {
+        std::size_t bytes = 0;
+        const auto  start = std::chrono::steady_clock::now();
+        for (int i = 0; i < REQUESTS; i++) {
+            response.clear();
+            if (binary) {
+                handler.handleFrame({payload.data(), payload.size()},
+                                    response);
+                bytes += payload.size() + response.size() +
+                         2 * Net::FRAME_HEADER;
+            } else {
+                handler.handle(text, response);
+                bytes += text.size() + response.size();
+            }
+        }
+        const std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+        LOG_INFO(R"(getSysReadings {}: {:.0f} requests per second, {:.1f} bytes per request)",
+                 binary ? "binary" : "text", REQUESTS / elapsed.count(),
+                 static_cast<double>(bytes) / REQUESTS);
+    }
+    REQUIRE(Binary::DecodeReply({response.data(), response.size()})->type ==
+            Binary::Type::Sample);
+}
+
+TEST_CASE("Offline scope", "[simulator]") {
+    Simulator::Config config;
+    config.scopeSamples = 1001;
+    auto              comm = makeComm(config);
+    Regatron::Handler handler{comm};
+    REQUIRE(waitConnected(*comm));
+
+    REQUIRE(request(handler, "setScopeChannels 100:0.5 2000\n") ==
+            "setScopeChannels ACK\n");
+    REQUIRE(request(handler, "setScopeTimeFactor 2\n") ==
+            "setScopeTimeFactor ACK\n");
+    REQUIRE(request(handler, "setScopeControl 1\n") ==
+            "setScopeControl ACK\n");
+    REQUIRE(request(handler, "getScopeStatus\n") ==
+            "getScopeStatus [2,1001]\n");
+
+    // 8 samples per call
+    Simulator::ResetStats();
+    const auto text = request(handler, "getScopeWaveform\n");
+    REQUIRE(Simulator::GetStats().transactions == 1 + (1001 + 7) / 8);
+
+    // "getScopeWaveform <base64>\n", nothing that ends a message or an item
+    REQUIRE(text.starts_with("getScopeWaveform "));
+    REQUIRE(text.find_first_of("\n;") == text.size() - 1);
+    const auto bytes = Utils::Base64::Decode(
+        std::string_view{text}.substr(17, text.size() - 18));
+    REQUIRE(bytes);
+    REQUIRE(bytes->size() == 8 + 3 * 1001 * sizeof(double));
+    const auto waveform = Regatron::ParseWaveform(*bytes);
+    REQUIRE(waveform);
+    REQUIRE(waveform->time.size() == 1001);
+    REQUIRE(waveform->channelCount == 2);
+    REQUIRE(waveform->time[1000] == Approx(1000 * 2 * 50e-6));
+    // Raw values, converted by the channel factor only
+    REQUIRE(waveform->channels[0].front() == 50.);
+    REQUIRE(waveform->channels[0].back() == 550.);
+    REQUIRE(waveform->channels[1].front() == 2000.);
+    REQUIRE(waveform->channels[1].back() == 3000.);
+
+    // Typed in a binary frame, refused in a batch
+    REQUIRE(request(handler, "setScopeControl 1\n") ==
+            "setScopeControl ACK\n");
+    const auto names = commandTable(handler);
+    const auto id    = static_cast<uint16_t>(
+        std::find(names.begin(), names.end(), "getScopeWaveform") -
+        names.begin());
+    Net::Response payload;
+    Regatron::Binary::EncodeGet(payload, id, 1);
+    const auto binary = request(handler, payload);
+    REQUIRE(binary.reply().status == Regatron::Binary::Status::Ok);
+    const auto decoded = Regatron::Binary::DecodeWaveform(binary.reply());
+    REQUIRE(decoded);
+    REQUIRE(decoded->channels[1] == waveform->channels[1]);
+    REQUIRE(request(handler, "batch getScopeWaveform;getDebug\n") ==
+            "batch getScopeWaveform NACK;getDebug 0\n");
+
+    // Tagged, queued at Background instead of read on the caller thread
+    auto outbox = std::make_shared<Net::Outbox>(nullptr);
+    REQUIRE(request(handler, "setScopeControl 1\n") ==
+            "setScopeControl ACK\n");
+    REQUIRE(request(handler, "#1 getScopeWaveform\n", outbox).empty());
+    REQUIRE(waitPushed(*outbox) == "#1 " + text);
+
+    REQUIRE(request(handler, "setScopeChannels 1 2 3 4 5 6 7 8 9\n") ==
+            "NACK");
+    REQUIRE(request(handler, "setScopeChannels 1:x\n") == "NACK");
+}
+
+TEST_CASE("Fast connect", "[simulator]") {
+    using namespace std::chrono_literals;
+    const auto portFile =
+        (std::filesystem::temp_directory_path() / "simulator_tests.port")
+            .string();
+    std::filesystem::remove(portFile);
+
+    // Ports 0 to 9 are DLL devices 1 to 10, the device is the fifth one,
+    // 20 ms to probe each port
+    Simulator::Config config;
+    config.port      = 5;
+    config.portProbe = 20ms;
+    auto connect     = [&config, &portFile]() {
+        auto comm = makeComm(config);
+        comm->SetConnectDelay(100ms);
+        comm->SetFastConnect(false, portFile);
+        Simulator::ResetStats();
+        REQUIRE(comm->connect(0, 9));
+        return comm->GetConnectTimes();
+    };
+
+    // Full search, the port is saved
+    auto times = connect();
+    REQUIRE(Simulator::GetStats().searchedPorts == 5);
+    REQUIRE(times.search >= 100);
+    REQUIRE(times.wait >= 100);
+    REQUIRE(std::filesystem::exists(portFile));
+
+    // Only the saved port is probed, no connect delay
+    times = connect();
+    REQUIRE(Simulator::GetStats().searchedPorts == 1);
+    REQUIRE(times.search < 100);
+    REQUIRE(times.wait < 100);
+
+    // Moved: the probe fails, then the full search
+    config.port = 7;
+    times       = connect();
+    REQUIRE(Simulator::GetStats().searchedPorts == 1 + 7);
+    REQUIRE(times.wait >= 100);
+
+    // Fast COM port detection, the saved port is not in the range any more
+    config.port = 3;
+    {
+        auto comm = makeComm(config);
+        comm->SetFastConnect(true, portFile);
+        REQUIRE(comm->connect(0, 2));
+        REQUIRE(comm->GetConnectTimes().search < 3 * 20);
+    }
+
+    // A search of the whole range is aborted
+    config.present   = false;
+    config.portProbe = 50ms;
+    {
+        auto        comm = makeComm(config);
+        std::thread abort([&comm]() {
+            std::this_thread::sleep_for(120ms);
+            CHECK(comm->getSearchProgress() >= 0);
+            comm->abortSearch();
+        });
+        const auto start = std::chrono::steady_clock::now();
+        REQUIRE_THROWS_AS(comm->connect(0, 99), Regatron::CommException);
+        abort.join();
+        REQUIRE(std::chrono::steady_clock::now() - start < 1s);
+        REQUIRE(comm->getSearchProgress() == -1);
+    }
+
+    std::filesystem::remove(portFile);
+}
+
+TEST_CASE("Adaptive timeouts", "[simulator]") {
+    using namespace std::chrono_literals;
+    // The library timeout, multiplier times 16 ms per call, is simulated
+    Simulator::Config config;
+    config.timeout = 0ms;
+    config.latency = 1ms;
+    auto comm      = makeComm(config);
+    comm->SetAdaptiveTimeouts(2, 100);
+    REQUIRE(comm->connect());
+
+    const auto multiplier = [&comm]() {
+        return comm->getLinkStats().multiplier;
+    };
+    const auto calls = [](int count) {
+        unsigned int id{0};
+        int          failed = 0;
+        for (int i = 0; i < count; i++) {
+            failed += TCIO(TC4GetModuleID)(&id) != DLL_SUCCESS ? 1 : 0;
+        }
+        return failed;
+    };
+    REQUIRE(multiplier() == 10);
+
+    // Fast link: halved at each step down to the lower bound
+    REQUIRE(calls(64) == 0);
+    comm->tuneTimeouts();
+    REQUIRE(multiplier() == 5);
+    for (int i = 0; i < 3; i++) {
+        calls(8);
+        comm->tuneTimeouts();
+    }
+    REQUIRE(multiplier() == 2);
+    unsigned int readTimeout{0};
+    unsigned int writeTimeout{0};
+    REQUIRE(DllGetCommTimeouts(&readTimeout, &writeTimeout) == DLL_SUCCESS);
+    REQUIRE(readTimeout == 2);
+    auto stats = comm->getLinkStats();
+    REQUIRE(stats.samples >= 88);
+    REQUIRE(stats.p50 >= 1000);
+    REQUIRE(stats.p99 >= stats.p50);
+    REQUIRE(stats.timeouts == 0);
+
+    // Slower link, 20 to 50 ms: calls over 32 ms time out while others
+    // answer, the timeout grows until none does
+    config.latency = 20ms;
+    config.jitter  = 30ms;
+    Simulator::Configure(config);
+    REQUIRE(calls(16) > 0);
+    for (int i = 0; i < 4; i++) {
+        comm->tuneTimeouts();
+        calls(16);
+    }
+    REQUIRE(multiplier() >= 4);
+    REQUIRE(calls(32) == 0);
+    stats = comm->getLinkStats();
+    REQUIRE(stats.timeouts > 0);
+    REQUIRE(stats.talkQueue == 0);
+}
+
+TEST_CASE("Identity cache", "[simulator]") {
+    const auto directory =
+        std::filesystem::temp_directory_path() / "simulator_tests.identity";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    const Regatron::IdentityCache cache(directory.string());
+
+    Simulator::Config config;
+    const auto        connect = [&config, &directory]() {
+        auto comm = makeComm(config);
+        comm->SetIdentityCache(directory.string());
+        Simulator::ResetStats();
+        REQUIRE(comm->connect());
+        return comm;
+    };
+
+    // Unknown unit: mandatory fields read, saved once all are loaded
+    auto       comm = connect();
+    const auto read = Simulator::GetStats().transactions;
+    REQUIRE(comm->isIdentityPending());
+    REQUIRE_FALSE(cache.load(config.serialNr));
+    while (comm->loadIdentity()) {
+    }
+    const auto saved = cache.load(config.serialNr);
+    REQUIRE(saved);
+    REQUIRE(saved->dspVersion == "V4.20.60");
+    const auto voltageMax =
+        comm->getReadings().value()->GetSystemStatus().GetVoltagePhysMax();
+    comm.reset();
+
+    // Known unit: the 5 mandatory reads are skipped, all read back later
+    comm = connect();
+    REQUIRE(read - Simulator::GetStats().transactions == 5);
+    REQUIRE(comm->getReadings().value()->GetSystemStatus().GetVoltagePhysMax() ==
+            voltageMax);
+    REQUIRE(comm->isIdentityPending());
+    int steps = 1;
+    while (comm->loadIdentity()) {
+        steps++;
+    }
+    REQUIRE(steps == 10);
+    REQUIRE_FALSE(comm->isIdentityPending());
+    REQUIRE(*cache.load(config.serialNr) == *saved);
+    comm.reset();
+
+    // Same serial number, one more module: the read back fixes the cache
+    config.modules = 2;
+    comm           = connect();
+    REQUIRE(comm->getReadings().value()->GetSystemStatus().GetCurrentPhysMax() ==
+            saved->system.max.current);
+    while (comm->loadIdentity()) {
+    }
+    REQUIRE(comm->getReadings().value()->GetSystemStatus().GetCurrentPhysMax() ==
+            2 * saved->system.max.current);
+    REQUIRE(cache.load(config.serialNr)->system.max.current ==
+            2 * saved->system.max.current);
+    comm.reset();
+
+    // Another unit
+    config.serialNr = 7;
+    comm            = connect();
+    while (comm->loadIdentity()) {
+    }
+    REQUIRE_FALSE(comm->isIdentityPending());
+    REQUIRE(cache.load(7));
+    comm.reset();
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("Deferred initialization", "[simulator]") {
+    using Regatron::IdentityField;
+    constexpr uint32_t MANDATORY = 0b111;
+    constexpr uint32_t ALL       = (1U << Regatron::IDENTITY_FIELDS) - 1;
+
+    Simulator::Config config;
+    auto              comm = makeComm(config);
+    REQUIRE(comm->connect());
+    REQUIRE(comm->getIdentityLoaded() == MANDATORY);
+    REQUIRE(comm->isIdentityPending());
+
+    // Setpoints are accepted before the other fields are loaded
+    auto readings = comm->getReadings().value();
+    readings->GetSystemStatus().SetVoltageRef(10.);
+    REQUIRE(readings->GetSystemStatus().GetVoltageRef() == 10.);
+    REQUIRE(comm->getIdentityLoaded() == MANDATORY);
+
+    // Loaded on first use, once
+    Simulator::ResetStats();
+    REQUIRE(readings->getDSPVersion() == "V4.20.60");
+    REQUIRE(readings->isLoaded(IdentityField::DspVersion));
+    const auto first = Simulator::GetStats().transactions;
+    REQUIRE(first > 0);
+    REQUIRE(readings->getDSPVersion() == "V4.20.60");
+    REQUIRE(Simulator::GetStats().transactions == first);
+
+    // The background loading skips it
+    int steps = 1;
+    while (comm->loadIdentity()) {
+        steps++;
+    }
+    REQUIRE(steps == Regatron::IDENTITY_FIELDS - 4);
+    REQUIRE(comm->getIdentityLoaded() == ALL);
+    REQUIRE_FALSE(comm->isIdentityPending());
+    REQUIRE_FALSE(comm->loadIdentity());
+}
+
+TEST_CASE("Fast group cycle", "[simulator][benchmark]") {
+    constexpr int CYCLES = 20;
+
+    Simulator::Config config;
+    config.latency      = std::chrono::microseconds{200};
+    config.jitter       = std::chrono::microseconds{50};
+    config.transferTime = true;
+    auto comm           = makeComm(config);
+    REQUIRE(comm->connect());
+    auto readings = comm->getReadings();
+    REQUIRE(readings.has_value());
+
+    // Transactions and time per fast group cycle, module readings from
+    // StatusReadings::Read or from the digital measurements (fastReadings)
+    double transactions[2]{};
+    for (const bool fastReadings : {false, true}) {
+        Regatron::Snapshot snapshot;
+        (*readings)->readGroups(snapshot, true, false, fastReadings);
+        Simulator::ResetStats();
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < CYCLES; i++) {
+            (*readings)->readGroups(snapshot, true, false, fastReadings);
+        }
+        const auto elapsed = std::chrono::duration_cast<
+            std::chrono::microseconds>(std::chrono::steady_clock::now() -
+                                       start);
+
+        const auto stats = Simulator::GetStats();
+        REQUIRE(stats.failures == 0);
+        transactions[fastReadings ? 1 : 0] =
+            static_cast<double>(stats.transactions) / CYCLES;
+        LOG_INFO(
+            R"(Fast group, fast readings "{}": {} transactions, {} selector writes, {} us per cycle)",
+            fastReadings, transactions[fastReadings ? 1 : 0],
+            static_cast<double>(stats.selectorWrites) / CYCLES,
+            elapsed.count() / CYCLES);
+    }
+    REQUIRE(transactions[1] < transactions[0]);
+}
+
+TEST_CASE("TCIO record and replay", "[simulator]") {
+    const auto trace =
+        (std::filesystem::temp_directory_path() / "simulator_tests.tcio")
+            .string();
+    constexpr std::string_view SESSION[] = {
+        "getModuleID\n",           "setSysVoltageRef 100\n",
+        "setSysCurrentRef 10\n",   "setSysPowerRef 20\n",
+        "setSysOutVoltEnable 1\n", "getSysReadings\n",
+        "getModReadings\n",        "getSysTree\n"};
+
+    auto run = [&SESSION]() {
+        Simulator::Config config;
+        config.loadResistance = 5.;
+        auto                     comm = makeComm(config);
+        Regatron::Handler        handler{comm};
+        std::vector<std::string> replies;
+        waitConnected(*comm);
+        // The deferred identity reads are part of the trace, in order
+        while (comm->isIdentityPending()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        for (const auto message : SESSION) {
+            replies.push_back(request(handler, message));
+        }
+        return replies;
+    };
+
+    Regatron::Tcio::StartRecording(trace);
+    const auto recorded = run();
+    Regatron::Tcio::Stop();
+    REQUIRE(recorded[5] == "getSysReadings [50,10,0.5,5000,8]\n");
+
+    // Same replies, the simulated device is not touched
+    Regatron::Tcio::StartReplay(trace, 0.);
+    Simulator::ResetStats();
+    const auto replayed = run();
+    REQUIRE(Simulator::GetStats().transactions == 0);
+    REQUIRE(replayed == recorded);
+
+    // The trace ended, the next call fails
+    Regatron::Handler handler{makeComm()};
+    REQUIRE(request(handler, "getModuleID\n") != "getModuleID 0\n");
+    Regatron::Tcio::Stop();
+    std::filesystem::remove(trace);
+}
@@ -0,0 +1,106 @@
+#include "catch2/catch.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "utils/Base64.hpp"
+#include "utils/SeqLock.hpp"
+#include "utils/SpscRing.hpp"
+
+namespace {
+/** Every field holds the same value, a torn read would mix two of them. */
+struct Sample {
+    std::array<std::uint64_t, 37> values{};
+};
+} // namespace
+
+TEST_CASE("SeqLock readers never observe a partial write", "[utils]") {
+    Utils::SeqLock<Sample> seqLock;
+    std::atomic<bool>      done{false};
+
+    std::thread writer([&seqLock, &done]() {
+        Sample sample;
+        for (std::uint64_t i = 1; i <= 200000; i++) {
+            sample.values.fill(i);
+            seqLock.store(sample);
+        }
+        done = true;
+    });
+
+    std::uint64_t last  = 0;
+    int           reads = 0;
+    while (!done) {
+        const auto sample = seqLock.load();
+        for (const auto &value : sample.values) {
+            REQUIRE(value == sample.values.front());
+        }
+        // Values are published in order
+        REQUIRE(sample.values.front() >= last);
+        last = sample.values.front();
+        reads++;
+    }
+    writer.join();
+
+    REQUIRE(seqLock.load().values.back() == 200000);
+    REQUIRE(reads > 0);
+}
+
+TEST_CASE("SpscRing keeps the order and the bounds", "[utils]") {
+    Utils::SpscRing<std::uint64_t, 8> ring;
+    std::uint64_t                     value = 0;
+    REQUIRE(ring.empty());
+    REQUIRE_FALSE(ring.pop(value));
+    for (std::uint64_t i = 0; i < 8; i++) {
+        REQUIRE(ring.push(i));
+    }
+    REQUIRE_FALSE(ring.push(8));
+    REQUIRE(ring.pop(value));
+    REQUIRE(value == 0);
+    REQUIRE(ring.push(8));
+
+    // Concurrent producer, every value comes out once and in order
+    std::thread producer([&ring]() {
+        for (std::uint64_t i = 9; i <= 100000; i++) {
+            while (!ring.push(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    std::uint64_t expected = 1;
+    while (expected <= 100000) {
+        if (ring.pop(value)) {
+            REQUIRE(value == expected);
+            expected++;
+        }
+    }
+    producer.join();
+    REQUIRE(ring.empty());
+}
+
+TEST_CASE("Base64 round trip", "[utils]") {
+    const auto encode = [](std::string_view data) {
+        fmt::memory_buffer out;
+        Utils::Base64::Encode(out, data);
+        return fmt::to_string(out);
+    };
+    REQUIRE(encode("").empty());
+    REQUIRE(encode("f") == "Zg==");
+    REQUIRE(encode("fo") == "Zm8=");
+    REQUIRE(encode("foo") == "Zm9v");
+    REQUIRE(encode("foobar") == "Zm9vYmFy");
+
+    // Every byte value, no new line nor separator in the text
+    std::string data;
+    for (int i = 0; i < 256 * 3 + 1; i++) {
+        data.push_back(static_cast<char>(i));
+    }
+    const auto text = encode(data);
+    REQUIRE(text.find_first_of("\n;") == std::string::npos);
+    REQUIRE(Utils::Base64::Decode(text) == data);
+
+    REQUIRE_FALSE(Utils::Base64::Decode("Zg="));
+    REQUIRE_FALSE(Utils::Base64::Decode("Z\ng="));
+}
@@ -0,0 +1,108 @@
+#include "catch2/catch.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "regatron/TcioWorker.hpp"
+
+using namespace std::chrono_literals;
+using Regatron::Priority;
+using Regatron::TcioWorker;
+
+namespace {
+/** Keeps the worker busy until released. */
+class Blocker {
+  public:
+    explicit Blocker(TcioWorker &worker)
+        : m_Done(std::async(std::launch::async, [this, &worker]() {
+              worker.run(Priority::Control, TcioWorker::NO_DEADLINE, [this]() {
+                  m_Running = true;
+                  while (!m_Released) {
+                      std::this_thread::sleep_for(1ms);
+                  }
+              });
+          })) {
+        while (!m_Running) {
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+    Blocker(const Blocker &) = delete;
+    Blocker(Blocker &&)      = delete;
+    Blocker &operator=(const Blocker &) = delete;
+    Blocker &operator=(Blocker &&) = delete;
+    ~Blocker() { release(); }
+
+    void release() {
+        m_Released = true;
+        m_Done.wait();
+    }
+
+  private:
+    std::atomic<bool> m_Running{false};
+    std::atomic<bool> m_Released{false};
+    std::future<void> m_Done;
+};
+} // namespace
+
+TEST_CASE("Higher priority jobs run first", "[worker]") {
+    TcioWorker worker;
+    Blocker    blocker{worker};
+
+    std::mutex               mutex;
+    std::vector<Priority>    order;
+    std::vector<std::thread> callers;
+    for (auto priority :
+         {Priority::Background, Priority::Monitor, Priority::Control}) {
+        callers.emplace_back([&, priority]() {
+            worker.run(priority, TcioWorker::NO_DEADLINE, [&]() {
+                std::lock_guard<std::mutex> lock(mutex);
+                order.push_back(priority);
+            });
+        });
+        // Queued in this order
+        std::this_thread::sleep_for(20ms);
+    }
+
+    blocker.release();
+    for (auto &caller : callers) {
+        caller.join();
+    }
+    REQUIRE(order == std::vector<Priority>{Priority::Control, Priority::Monitor,
+                                           Priority::Background});
+}
+
+TEST_CASE("Jobs not started before the deadline are cancelled", "[worker]") {
+    TcioWorker worker;
+    bool       ran = false;
+    {
+        Blocker blocker{worker};
+        REQUIRE_FALSE(
+            worker.run(Priority::Monitor, 20ms, [&ran]() { ran = true; }));
+    }
+    REQUIRE_FALSE(ran);
+    REQUIRE(worker.run(Priority::Monitor, 1s, [&ran]() { ran = true; }));
+    REQUIRE(ran);
+}
+
+TEST_CASE("Job exceptions reach the caller", "[worker]") {
+    TcioWorker worker;
+    REQUIRE_THROWS_AS(worker.run(Priority::Control, 1s,
+                                 []() { throw std::runtime_error("fail"); }),
+                      std::runtime_error);
+
+    // Nested jobs run in place
+    int depth = 0;
+    worker.run(Priority::Monitor, 1s, [&]() {
+        worker.run(Priority::Control, 1s, [&depth]() { depth++; });
+        depth++;
+    });
+    REQUIRE(depth == 2);
+
+    worker.stop();
+    REQUIRE_FALSE(worker.run(Priority::Control, 1s, []() {}));
+}